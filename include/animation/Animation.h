@@ -38,6 +38,7 @@ public:
     bool setParam(const std::string& name, const DynamicPalette& value);
     
     AnimationParameter* findParameter(const std::string& name);
+    AnimationParameter* findParameter(uint32_t id);
 
     void resetToDefaults() {
         for (auto& p : parameters) {
@@ -49,6 +50,11 @@ public:
         devicePhase = phase;
     }
 
+    // True for effects that consume the shared audio analyzer
+    virtual bool isAudioReactive() const {
+        return false;
+    }
+
 protected:
     float devicePhase = 0.0f; // 0.0 to 1.0
     uint8_t brightness = 255;
@@ -7,8 +7,12 @@
 #include <ArduinoJson.h>
 
 #include <cstdint>
+#include <functional>
+#include <mutex>
 #include "animation/Animation.h"
 #include "system/LedController.h"
+#include "audio/WavAudioSource.h"
+#include "audio/AudioBenchmark.h"
 
 // Forward declaration if useful, but Animation is needed for vector<Animation*>
 // We need Animation.h, but we DON'T need specific animations here.
@@ -38,9 +42,20 @@ public:
     void setAnimation(const std::string& presetName); // Select a PRESET
     std::string getCurrentAnimationName() const; // Returns PRESET name
     
+    // Render the current effect (or black when off) into a buffer without showing it
+    void renderFrame(uint32_t epoch, CRGB* leds, int numLeds);
     void update(uint32_t epoch, float phase = 0.0f);
+    // Drawn over every rendered frame (mesh event flashes); set before the animation task starts
+    void setFrameOverlay(std::function<void(uint32_t epoch, CRGB* leds, int numLeds)> overlay) { frameOverlay = overlay; }
     
     std::vector<std::string> getPresetNames() const;
+
+    // Content hash per preset (name, base type and params) for mesh anti-entropy
+    struct PresetDigestEntry {
+        std::string name;
+        uint32_t hash;
+    };
+    std::vector<PresetDigestEntry> getPresetDigests() const;
     std::vector<std::string> getBaseAnimationNames() const;
 
     Animation* getCurrentAnimation();
@@ -54,6 +69,17 @@ public:
     void setDevicePhase(float phase);
     float getDevicePhase() const;
 
+    // Audio replay: feed a WAV from LittleFS into the audio effects instead of the mic
+    void startAudioReplay(const std::string& path, bool realtime, bool loop);
+    void stopAudioReplay();
+    bool isAudioReplayActive() const { return audioReplayActive; }
+
+    // Audio benchmark: runs a slice per frame on the animation task until done
+    void requestAudioBenchmark(const std::string& path);
+    bool isAudioBenchmarkPending() const;
+    float getAudioBenchmarkProgress() const { return benchmarkProgress; }
+    AudioBenchmark::Result getAudioBenchmarkResult() const;
+
 private:
     LedController& controller;
     float devicePhase = 0.0f;
@@ -65,6 +91,7 @@ private:
         std::string name;
         std::string baseType;
         std::string filePath; // e.g. /presets/my_cool_fire.json
+        uint32_t contentHash;
     };
     std::vector<Preset> presets;
 
@@ -72,8 +99,36 @@ private:
     std::string currentPresetName;
 
     bool powerState;
+    std::function<void(uint32_t, CRGB*, int)> frameOverlay;
 
     void saveLastPreset();
+
+    // Audio replay / benchmark (requested from web, executed in update()).
+    // audioRequestMutex guards the pending requests and lastBenchmark, which
+    // the web task reads and writes while the animation task works.
+    mutable std::mutex audioRequestMutex;
+    WavAudioSource replaySource;
+    bool audioReplayActive = false;
+    struct PendingReplay {
+        bool pending = false;
+        bool stop = false;
+        std::string path;
+        bool realtime = true;
+        bool loop = false;
+    };
+    PendingReplay pendingReplay;
+    struct PendingBenchmark {
+        bool pending = false;
+        std::string path;
+    };
+    PendingBenchmark pendingBenchmark;
+    AudioBenchmark benchmark;
+    volatile bool benchmarkRunning = false;
+    volatile float benchmarkProgress = 0.0f;
+    AudioBenchmark::Result lastBenchmark;
+
+    void processAudioRequests();
+    Animation* cloneCurrentAnimation() const;
 };
 
 
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <FastLED.h>
+#include "system/Hash.h"
 
 #include <vector>
 
@@ -70,11 +71,13 @@ struct AnimationParameter {
 
     AnimationParameter(const char* n, ParameterType t, void* v, const char* desc = "", float mn = 0, float mx = 100, float s = 1)
         : name(n), type(t), value(v), description(desc), min(mn), max(mx), step(s) {
+        id = fnv1a32(n);
         // Store the initial value as the default
         storeCurrentAsDefault();
     }
 
     const char* name;
+    uint32_t id; // fnv1a32 of name, used as the on-air parameter ID
     const char* description;
     ParameterType type;
     void* value; // Pointer to the actual variable
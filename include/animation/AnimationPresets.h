@@ -6,10 +6,14 @@
 
 // Forward declaration
 class AnimationManager;
+class Animation;
 
 class AnimationPresets {
 public:
     static void createAnimations(AnimationManager& manager);
+    // A fresh, unregistered instance of a base type (nullptr if unknown),
+    // e.g. for a benchmark that must not touch the live singleton
+    static Animation* createAnimation(const std::string& typeName);
 };
 
 #endif // ANIMATIONPRESETS_H
@@ -66,7 +66,7 @@ private:
         float bandEnergy = 0.0f;
         int halfSamples = SAMPLES / 2;
         
-        // Base class renders FFT into vReal (magnitude)
+        // Shared analyzer holds the FFT magnitude spectrum
         for (int i = 1; i < halfSamples; i++) {
             float freq = (i * SAMPLING_FREQ) / SAMPLES;
             
@@ -78,8 +78,7 @@ private:
             }
             
             if (pass) {
-                // vReal holds magnitude after complexToMagnitude in base class
-                bandEnergy += vReal[i]; 
+                bandEnergy += getMagnitude(i);
             }
         }
 
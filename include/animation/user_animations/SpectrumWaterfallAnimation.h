@@ -0,0 +1,73 @@
+#ifndef SPECTRUMWATERFALLANIMATION_H
+#define SPECTRUMWATERFALLANIMATION_H
+
+#include "animation/AudioReactAnimation.h"
+
+// Scrolls the recent spectrum history along the strip: the first LED shows
+// the newest frame, the far end the oldest. Colour follows where the energy
+// sits in the selected band (low -> high), brightness follows its level.
+class SpectrumWaterfallAnimation : public AudioReactAnimation {
+public:
+    SpectrumWaterfallAnimation()
+        : AudioReactAnimation("SpectrumWaterfall"),
+          minFreq(30.0f),
+          maxFreq(2000.0f),
+          floorLevel(120),
+          gain(4.0f),
+          history(SPECTROGRAM_ROWS) {
+
+        palette = {{ CRGB::Red, CRGB::Yellow, CRGB::Green, CRGB::Blue }};
+
+        registerParameter("Palette", &palette, "Low to high frequency colors");
+        registerParameter("Min Freq", &minFreq, 0.0f, 4000.0f, 10.0f, "Start Hz");
+        registerParameter("Max Freq", &maxFreq, 0.0f, 4000.0f, 10.0f, "End Hz");
+        registerParameter("Floor", &floorLevel, 0, 255, 1, "Noise floor (log level)");
+        registerParameter("Gain", &gain, 0.5f, 16.0f, 0.5f, "Brightness per log step");
+        registerParameter("History", &history, 1, SPECTROGRAM_ROWS, 1, "Frames shown across the strip");
+    }
+
+    std::string getTypeName() const override { return "SpectrumWaterfall"; }
+
+protected:
+    void renderAudioAnimation(uint32_t epoch, CRGB* leds, int numLeds) const override {
+        CRGBPalette16 p = palette.toPalette16();
+
+        int firstBin = constrain((int)(minFreq * SAMPLES / SAMPLING_FREQ), 1, getNumBins() - 1);
+        int lastBin = constrain((int)(maxFreq * SAMPLES / SAMPLING_FREQ), firstBin, getNumBins() - 1);
+        int rows = constrain(history, 1, getSpectrogramDepth());
+
+        for (int i = 0; i < numLeds; i++) {
+            const uint8_t* row = getSpectrogramRow((i * rows) / numLeds);
+            if (!row) {
+                leds[i] = CRGB::Black;
+                continue;
+            }
+
+            // Peak level and where it sits in the band
+            uint8_t peak = 0;
+            int peakBin = firstBin;
+            for (int b = firstBin; b <= lastBin; b++) {
+                if (row[b] > peak) {
+                    peak = row[b];
+                    peakBin = b;
+                }
+            }
+
+            int level = peak > floorLevel ? (int)((peak - floorLevel) * gain) : 0;
+            uint8_t bright = (uint8_t)constrain(level, 0, 255);
+            uint8_t colorIndex = lastBin > firstBin ? (uint8_t)(((peakBin - firstBin) * 255) / (lastBin - firstBin)) : 0;
+
+            leds[i] = ColorFromPalette(p, colorIndex, bright);
+        }
+    }
+
+private:
+    float minFreq;
+    float maxFreq;
+    int floorLevel;
+    float gain;
+    int history;
+    DynamicPalette palette;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#include "audio/AudioSource.h"
+
+// Microphone on an ADC pin, sampled with busy-wait pacing.
+class AdcAudioSource : public AudioSource {
+public:
+    AdcAudioSource(int pin, uint32_t sampleRate);
+
+    int readSamples(float* out, int count) override;
+    uint32_t getSampleRate() const override { return sampleRate; }
+
+private:
+    int pin;
+    uint32_t sampleRate;
+    bool configured;
+};
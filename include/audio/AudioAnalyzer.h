@@ -0,0 +1,130 @@
+#pragma once
+#include <Arduino.h>
+#include <arduinoFFT.h>
+#include <functional>
+#include "audio/AudioSource.h"
+#include "audio/AdcAudioSource.h"
+#include "audio/AudioFeatures.h"
+
+#define MIC_PIN       34
+#define SAMPLES       256
+#define SAMPLING_FREQ 8000
+
+// Frames overlap by half: each update() reads AUDIO_HOP new samples, so
+// features come at SAMPLING_FREQ / AUDIO_HOP (62.5 Hz) while the FFT still
+// sees SAMPLES of history
+#define AUDIO_HOP (SAMPLES / 2)
+
+// FFT bins folded into each broadcast feature band
+#define AUDIO_BINS_PER_BAND ((SAMPLES / 2) / AUDIO_FEATURE_BANDS)
+
+// Spectrogram history: last N frames, one 8-bit log-magnitude byte per bin.
+// Must be a power of two (row lookup is a mask, not a modulo).
+#define SPECTROGRAM_ROWS 64
+#define SPECTROGRAM_BINS (SAMPLES / 2)
+
+// Shared FFT front-end for all audio reactive animations.
+// Pulls one frame of SAMPLES from the active AudioSource (the microphone
+// by default) and keeps the magnitude spectrum of the latest frame.
+// Nodes without a microphone can instead be fed AudioFeatures received
+// over the mesh, in which case sampling and the FFT are skipped.
+class AudioAnalyzer {
+public:
+    static AudioAnalyzer& shared();
+
+    // Private instances (the benchmark) have no listener and are never fed
+    // remote frames, so nothing they analyse leaves the node
+    AudioAnalyzer();
+    ~AudioAnalyzer();
+
+    // The analyzer audio effects read from: shared() unless one has been
+    // bound around the frames being rendered. Animation task only.
+    static AudioAnalyzer& current() { return bound ? *bound : shared(); }
+    static void bind(AudioAnalyzer* analyzer) { bound = analyzer; }
+
+    // Swap the input. Passing nullptr restores the microphone.
+    void setSource(AudioSource* src);
+    AudioSource* getSource() const { return source; }
+
+    // Capture AUDIO_HOP samples and analyse the latest window. Returns false if
+    // the source ran dry. Serialised: the ear task and an audio effect may
+    // both call it around an effect switch.
+    bool update();
+
+    // Helper to get total energy in a frequency range
+    float getEnergy(float minFreq, float maxFreq) const;
+
+    float getMagnitude(int bin) const {
+        if (bin >= 0 && bin < SAMPLES / 2) {
+            return vReal[bin];
+        }
+        return 0.0f;
+    }
+
+    int getNumBins() const { return SAMPLES / 2; }
+    float getBinFrequency(int bin) const { return (bin * SAMPLING_FREQ) / SAMPLES; }
+
+    // Bass onset on the latest frame (local detection or relayed from the ear)
+    bool isBeat() const { return beat; }
+
+    // Spectrogram history for waterfall / trail effects. Row 'age' 0 is the
+    // newest frame; returns nullptr if that many frames have not been seen yet.
+    // The pointer stays valid until the next update() (no copies, O(1) lookup).
+    const uint8_t* getSpectrogramRow(int age) const {
+        if (age < 0 || age >= spectrogramDepth) return nullptr;
+        return spectrogram[(spectrogramHead - age) & (SPECTROGRAM_ROWS - 1)];
+    }
+    int getSpectrogramDepth() const { return spectrogramDepth; }
+
+    // Cost of the last windowing + FFT + magnitude pass (excludes sampling)
+    uint32_t getLastAnalysisMicros() const { return lastAnalysisMicros; }
+    uint32_t getFrameCount() const { return frameCount; }
+
+    // Called after every locally analysed frame (used by the mesh "ear")
+    void setFrameListener(std::function<void(const AudioFeatures&)> listener) { frameListener = listener; }
+
+    // Remote features (called from the mesh task). While frames keep arriving,
+    // update() paces itself on them instead of sampling the local source.
+    void injectRemoteFeatures(const AudioFeatures& features);
+    bool isRemoteFed() const;
+
+    static const unsigned long REMOTE_TIMEOUT_MS = 500;
+
+private:
+    static AudioAnalyzer* bound;
+
+    bool analyseNext();
+    bool takeRemoteFrame();
+    void detectBeat();
+    void buildFeatures(AudioFeatures& out) const;
+    void pushSpectrogramRow();
+
+    float window[SAMPLES]; // Raw samples, oldest first
+    float vReal[SAMPLES];
+    float vImag[SAMPLES];
+    SemaphoreHandle_t updateMutex;
+    ArduinoFFT<float> FFT;
+
+    AdcAudioSource micSource;
+    AudioSource* source;
+
+    uint32_t lastAnalysisMicros;
+    uint32_t frameCount;
+
+    // Beat detection state
+    bool beat;
+    float bassAverage;
+    unsigned long lastBeatTime;
+
+    std::function<void(const AudioFeatures&)> frameListener;
+
+    uint8_t spectrogram[SPECTROGRAM_ROWS][SPECTROGRAM_BINS];
+    int spectrogramHead;
+    int spectrogramDepth;
+
+    // Latest remote frame, handed from the mesh task to the animation task
+    portMUX_TYPE remoteMux = portMUX_INITIALIZER_UNLOCKED;
+    SemaphoreHandle_t remoteReady;
+    AudioFeatures remoteFeatures;
+    volatile unsigned long lastRemoteTime;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <FastLED.h>
+#include "audio/WavAudioSource.h"
+
+class Animation;
+class AudioAnalyzer;
+
+// Offline tuning harness: pushes a WAV file through a private analyzer and
+// an audio effect as fast as its time slices allow, then reports analysis
+// cost and the delay between each kick in the file and the LED response it
+// produced. The live analyzer, its listener and the strip are left alone.
+class AudioBenchmark {
+public:
+    struct Result {
+        bool ok = false;
+        std::string error;
+
+        uint32_t frames = 0;
+        uint32_t avgAnalysisMicros = 0;
+        uint32_t maxAnalysisMicros = 0;
+        uint32_t avgRenderMicros = 0;
+        uint32_t maxRenderMicros = 0;
+
+        uint32_t kicks = 0;      // Onsets found in the raw PCM
+        uint32_t responses = 0;  // Kicks followed by an LED attack
+        float avgLatencyMs = 0.0f;
+        float maxLatencyMs = 0.0f;
+    };
+
+    // Kick detector tuning (raw PCM, independent of the effect under test)
+    static const int ONSET_BLOCK = 32;          // samples per energy block (4ms @ 8kHz)
+    static constexpr float ONSET_RATIO = 3.0f;  // block energy vs running average
+    static const int ONSET_HOLDOFF_MS = 120;    // ignore re-triggers within a kick
+
+    // LED response: rise in average light between frames
+    static const uint8_t RESPONSE_DELTA = 24;
+    static const int RESPONSE_WINDOW_MS = 250;
+
+    // Work done per step(), so the caller's frame rate survives a long file
+    static const uint32_t SLICE_MICROS = 2000;
+
+    AudioBenchmark();
+    ~AudioBenchmark();
+
+    // Opens the file and sets up the private analyzer. Takes ownership of
+    // anim, which should be an instance of its own: the effects keep state
+    // between frames, so rendering the live one would disturb the strip and
+    // skew the measurement. False (with the reason in getResult().error) if
+    // there is nothing to run.
+    bool start(const char* wavPath, Animation* anim, int numLeds);
+    // Renders frames for up to SLICE_MICROS. Returns false once the file is
+    // done and getResult() holds the outcome.
+    bool step();
+    bool isRunning() const { return running; }
+    float getProgress() const;
+    const Result& getResult() const { return result; }
+
+private:
+    class OnsetTapSource;
+
+    bool renderFrame();
+    void finish();
+    void release();
+
+    bool running = false;
+    std::string path;
+    Animation* anim = nullptr;
+    WavAudioSource wav;
+    OnsetTapSource* tap = nullptr;
+    AudioAnalyzer* analyzer = nullptr;
+    Result result;
+
+    // Render into a scratch buffer so the strip keeps its current state
+    std::vector<CRGB> leds;
+    uint8_t lastLight = 0;
+
+    // Responses as (sample position at end of frame, processing micros)
+    struct Response { uint32_t sample; uint32_t micros; };
+    std::vector<Response> responses;
+
+    uint64_t totalAnalysis = 0;
+    uint64_t totalRender = 0;
+};
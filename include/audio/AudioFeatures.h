@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <cmath>
+
+// Compact summary of one analysis frame, small enough to broadcast to
+// mic-less nodes many times a second.
+#define AUDIO_FEATURE_BANDS 32
+
+struct AudioFeatures {
+    uint8_t bands[AUDIO_FEATURE_BANDS]; // Log-encoded band energy (see encodeLogMagnitude)
+    bool beat;
+};
+
+// 8-bit log encoding of FFT magnitudes: ~6% steps, saturates around 2.5M
+// which is above anything the 12-bit ADC produces for a band.
+inline uint8_t encodeLogMagnitude(float magnitude) {
+    if (magnitude <= 0.0f) return 0;
+    float v = log2f(1.0f + magnitude) * 12.0f;
+    return v >= 255.0f ? 255 : (uint8_t)(v + 0.5f);
+}
+
+inline float decodeLogMagnitude(uint8_t level) {
+    return exp2f(level / 12.0f) - 1.0f;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+// Abstract PCM input for the audio pipeline.
+// Samples are delivered as floats centred on zero and scaled to the
+// range of the 12-bit microphone ADC (+/-2048), so thresholds tuned
+// against one source carry over to the others.
+class AudioSource {
+public:
+    virtual ~AudioSource() {}
+
+    // Fill 'out' with up to 'count' samples at getSampleRate().
+    // Returns the number of samples written (0 when the source is exhausted).
+    virtual int readSamples(float* out, int count) = 0;
+
+    virtual uint32_t getSampleRate() const = 0;
+};
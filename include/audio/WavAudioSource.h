@@ -0,0 +1,51 @@
+#pragma once
+#include <LittleFS.h>
+#include "audio/AudioSource.h"
+
+// Streams PCM from a WAV file on LittleFS.
+// Supports 8/16-bit mono or stereo PCM; stereo is mixed down and the
+// file is resampled to the analyzer rate. In real-time mode reads are
+// paced to wall-clock like the ADC; otherwise they return immediately
+// so a whole file can be pushed through the pipeline at max speed.
+class WavAudioSource : public AudioSource {
+public:
+    WavAudioSource(uint32_t targetRate);
+    ~WavAudioSource();
+
+    bool open(const char* path, bool realtime = true, bool loop = false);
+    void close();
+    bool isOpen() const { return file ? true : false; }
+
+    int readSamples(float* out, int count) override;
+    uint32_t getSampleRate() const override { return targetRate; }
+
+    // Position in output samples since open() (or since the last loop)
+    uint32_t getPosition() const { return position; }
+    // Fraction of the data chunk read so far (0..1)
+    float getProgress() const { return dataSize ? (float)dataRead / dataSize : 0.0f; }
+
+private:
+    bool readHeader();
+    bool readFrame(float& sample);
+
+    File file;
+    uint32_t targetRate;
+    bool realtime;
+    bool loop;
+
+    uint32_t fileRate;
+    uint16_t channels;
+    uint16_t bitsPerSample;
+    uint32_t dataStart;
+    uint32_t dataSize;
+    uint32_t dataRead;
+
+    // Linear resampling state
+    float step;
+    float frac;
+    float prevSample;
+    float nextSample;
+
+    uint32_t position;
+    unsigned long startMicros;
+};
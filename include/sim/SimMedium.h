@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+#include "system/MeshRadio.h"
+
+// Host simulator (native build only): a shared radio medium and a skewed
+// clock per node, so many MeshNetworkManagers can run in one process.
+// Simulated time lives in host::nowMicros and only moves under runUntil().
+
+struct SimMediumConfig {
+    float lossRate = 0.0f;        // Chance each receiver misses a frame, independently
+    uint32_t latencyMicros = 500; // Radio stack on top of airtime, each frame
+    uint32_t jitterMicros = 300;  // Uniform, added to the latency
+    float rangeMeters = 100.0f;   // Nothing is heard further away than this
+    float bitrateMbps = 1.0f;     // ESP-NOW's default PHY rate
+};
+
+// A node's crystal: starts at zero when the node boots and runs driftPpm fast
+class SimClock : public MeshClock {
+public:
+    SimClock(int64_t bootMicros, double driftPpm) : bootMicros(bootMicros), driftPpm(driftPpm) {}
+    int64_t micros() const override;
+
+private:
+    int64_t bootMicros;
+    double driftPpm;
+};
+
+class SimMedium;
+
+class SimRadio : public MeshRadio {
+public:
+    SimRadio(SimMedium& medium, int index, float x, float y);
+
+    bool begin() override { return true; }
+    void macAddress(uint8_t* mac) const override;
+    bool addPeer(const uint8_t* mac) override;
+    void removePeer(const uint8_t* mac) override;
+    bool send(const uint8_t* mac, const uint8_t* data, size_t len) override;
+
+    // Powered off: sends fail and nothing is heard
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    int getIndex() const { return index; }
+    float getX() const { return x; }
+    float getY() const { return y; }
+    uint64_t getAirtimeMicros() const { return airtimeMicros; }
+    uint32_t getFramesSent() const { return framesSent; }
+
+private:
+    friend class SimMedium;
+    static const size_t MAX_PEERS = 20; // ESP-NOW's unicast peer table
+
+    SimMedium& medium;
+    int index;
+    float x;
+    float y;
+    bool enabled = true;
+    std::vector<uint64_t> peers;
+    int64_t busyUntil = 0; // One frame on the air at a time per radio
+    uint64_t airtimeMicros = 0;
+    uint32_t framesSent = 0;
+};
+
+class SimMedium {
+public:
+    static const uint32_t PHY_PREAMBLE_MICROS = 192; // 802.11b long preamble + PLCP header
+    static const size_t MAC_OVERHEAD_BYTES = 43;     // Header, action frame + vendor IE, FCS
+    static const uint32_t ACK_MICROS = 314;          // SIFS + ACK at 1 Mbps, unicast only
+    static const int UNICAST_TRIES = 4;              // MAC-level retries before reporting failure
+
+    SimMedium(const SimMediumConfig& config, uint32_t seed);
+
+    SimRadio& addRadio(float x, float y);
+    size_t size() const { return radios.size(); }
+    SimRadio& radio(size_t index) { return *radios[index]; }
+
+    // Deliver the frames and send completions due up to 'until' (µs), moving
+    // host::nowMicros along with them
+    void runUntil(int64_t until);
+
+    // Called with the radio index before its callbacks run (output tagging)
+    void setEnterCallback(std::function<void(int index)> callback) { enterCallback = callback; }
+
+    uint64_t getAirtimeMicros() const { return airtimeMicros; }
+    uint32_t airtime(size_t len) const;
+
+    static uint64_t macToId(const uint8_t* mac);
+
+private:
+    friend class SimRadio;
+
+    struct Event {
+        int64_t time;
+        uint64_t order;  // FIFO among events due at the same time
+        bool sent;       // Send completion for 'radio', else a frame for it
+        int radio;
+        int from;
+        bool broadcast;
+        bool delivered;
+        int8_t rssi;
+        std::vector<uint8_t> data;
+    };
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            return a.time != b.time ? a.time > b.time : a.order > b.order;
+        }
+    };
+
+    bool transmit(SimRadio& from, const uint8_t* mac, const uint8_t* data, size_t len);
+    bool hears(const SimRadio& from, const SimRadio& to, int8_t& rssi) const;
+    void schedule(Event&& event);
+
+    SimMediumConfig config;
+    std::mt19937 rng;
+    std::vector<std::unique_ptr<SimRadio>> radios;
+    std::priority_queue<Event, std::vector<Event>, Later> events;
+    uint64_t nextOrder = 0;
+    uint64_t airtimeMicros = 0;
+    std::function<void(int index)> enterCallback;
+};
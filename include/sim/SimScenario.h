@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "sim/SimMedium.h"
+
+// One simulated deployment: N mesh nodes booting over a few seconds on a
+// shared medium, each on its own skewed clock, run for durationMs of
+// simulated time while the runner measures how the group behaves.
+struct SimScenario {
+    std::string name = "custom";
+    int nodes = 10;
+    uint32_t seed = 1;
+    uint32_t durationMs = 60000;
+
+    // Placement: at random in a square this wide, or in a line this far apart
+    float areaMeters = 30.0f;
+    float lineSpacingMeters = 0.0f; // > 0 places nodes in a line
+
+    uint32_t bootSpreadMs = 2000; // Power-on times spread over this
+    float skewPpm = 40.0f;        // Crystal error, uniform within +/- this
+    bool relay = false;
+    int groups = 1;      // Nodes join this many groups in turn
+    bool stream = false; // Master streams pixels to its group, as with pixel streaming on
+
+    uint32_t eventIntervalMs = 5000; // Master fires a probe event this often once settled (0 = never)
+    uint32_t failoverAtMs = 0;       // Master hands over and powers off at this time (0 = never)
+    bool handover = true;            // false: it just loses power, and its lease has to lapse
+
+    bool stable = false;  // Any disruption after convergence fails the run
+    float maxSyncP95Micros = 0.0f; // A p95 sync error above this fails the run (0 = no limit)
+    bool verbose = false; // Mesh log output, tagged per node
+
+    SimMediumConfig medium;
+};
+
+struct SimReport {
+    // Time until exactly one master with everyone else following it first; < 0 if never
+    float convergenceMs = -1.0f;
+    uint32_t disruptions = 0; // Times a settled group came apart again (the failover aside)
+    int masters = 0;          // At the end of the run
+
+    // |network time - master's network time|, sampled every SYNC_SAMPLE_MS once settled
+    uint32_t syncSamples = 0;
+    float syncMeanMicros = 0.0f;
+    float syncP95Micros = 0.0f;
+    float syncMaxMicros = 0.0f;
+
+    // Probe events: master's broadcast until each follower in its group has it staged
+    uint32_t probes = 0;
+    uint32_t probeTargets = 0;
+    uint32_t probeReached = 0;
+    float propagationMeanMs = 0.0f;
+    float propagationP95Ms = 0.0f;
+    float propagationMaxMs = 0.0f;
+
+    // Relay, summed over all nodes; eventCopies counts probe events a node
+    // handled more than once, which the relay's duplicate check should prevent
+    uint32_t relayed = 0;
+    uint32_t relaySuppressed = 0;
+    uint32_t duplicates = 0;
+    uint32_t eventCopies = 0;
+
+    // From the master's leave request until the group first settles again; < 0 if never or not run
+    float failoverMs = -1.0f;
+    uint32_t takeovers = 0; // Successors claiming the lease from the failover on, summed over nodes
+    uint32_t elections = 0; // Full elections from the failover on, summed over nodes
+
+    // Share of the run each was on the air (one collision domain assumed)
+    uint64_t airtimeMicros = 0;
+    uint32_t framesSent = 0;
+    float channelUse = 0.0f;
+    float busiestNodeUse = 0.0f;
+};
+
+class SimRunner {
+public:
+    static const uint32_t TICK_MICROS = 1000;       // Mesh task wake-ups and metric checks
+    static const int LEDS = 60;                     // Per node, and per streamed frame
+    static const uint32_t SYNC_SAMPLE_MS = 100;
+    static const uint32_t SYNC_SETTLE_MS = 3000;    // After convergence, before sync is sampled
+    static const uint32_t PROBE_WINDOW_MS = 1000;   // A follower without the event by then missed it
+
+    static SimReport run(const SimScenario& scenario);
+    static void print(const SimScenario& scenario, const SimReport& report);
+};
@@ -18,5 +18,8 @@
 #define MESH_TASK_STACK_SIZE 4096
 #define ANIMATION_TASK_PRIORITY 1
 #define MESH_TASK_PRIORITY 1
+#define AUDIO_TASK_STACK_SIZE 4096
+#define AUDIO_TASK_PRIORITY 1
 #define ANIMATION_TASK_CORE 1
 #define MESH_TASK_CORE 0
+#define AUDIO_TASK_CORE 0
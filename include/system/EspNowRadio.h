@@ -0,0 +1,32 @@
+#pragma once
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <esp_timer.h>
+#include "system/MeshRadio.h"
+
+class EspClock : public MeshClock {
+public:
+    int64_t micros() const override { return esp_timer_get_time(); }
+};
+
+// ESP-NOW on the station interface's current channel
+class EspNowRadio : public MeshRadio {
+public:
+    bool begin() override;
+    void macAddress(uint8_t* mac) const override;
+    bool addPeer(const uint8_t* mac) override;
+    void removePeer(const uint8_t* mac) override;
+    bool send(const uint8_t* mac, const uint8_t* data, size_t len) override;
+
+private:
+    static EspNowRadio* instance;
+
+    // Signal strength of the last ESP-NOW frame the sniffer saw. The sniffer
+    // and receive callbacks both run in the Wi-Fi task, one after the other.
+    int8_t sniffedRssi = 0;
+    uint8_t sniffedMac[6] = {0};
+
+    static void onReceiveWrapper(const uint8_t* mac, const uint8_t* data, int len);
+    static void onSendWrapper(const uint8_t* mac, esp_now_send_status_t status);
+    static void onPromiscuousWrapper(void* buf, wifi_promiscuous_pkt_type_t type);
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// FNV-1a 32-bit. Used for compact on-air identifiers (group names etc.)
+// so receivers can compare a fixed-size value instead of strings.
+static const uint32_t FNV1A_SEED = 2166136261u;
+
+inline uint32_t fnv1a32(const uint8_t* data, size_t len, uint32_t hash = FNV1A_SEED) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+inline uint32_t fnv1a32(const char* str, uint32_t hash = FNV1A_SEED) {
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// LZSS for bulk payloads (preset JSON is mostly repeated keys). The stream is
+// groups of one flag byte followed by up to eight items, lowest bit first:
+//   bit set    literal: one byte copied as is
+//   bit clear  match:   two bytes, 12-bit offset - 1 then 4-bit length - MIN_MATCH,
+//                       copying from that far back in the output (may overlap)
+// Nothing else is stored; the caller carries the decoded length.
+class Lzss {
+public:
+    static const size_t WINDOW = 4096;
+    static const size_t MIN_MATCH = 3;
+    static const size_t MAX_MATCH = 18;
+    static const size_t MAX_INPUT = 65535; // Hash chains hold 16-bit positions
+
+    // Returns bytes written, or 0 if in is too long or the result would not
+    // fit in capacity (pass length to only accept a saving).
+    static size_t encode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity);
+
+    // Returns bytes written to out, or -1 if malformed or longer than capacity.
+    static int decode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity);
+};
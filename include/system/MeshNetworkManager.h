@@ -1,9 +1,20 @@
 #pragma once
-#include <esp_now.h>
 #include <WiFi.h>
 #include <vector>
+#include <cstddef>
 #include <functional> // Added for std::function
+#include <atomic>
+#include <mutex>
 #include "system/LedController.h"
+#include "animation/AnimationParameter.h"
+#include "system/SpscRing.h"
+#include "system/PeerTable.h"
+#include "system/MeshStats.h"
+#include "system/MeshOutbox.h"
+#include "system/MeshRadio.h"
+#include "system/EspNowRadio.h"
+#include "system/TrickleTimer.h"
+#include "audio/AudioFeatures.h"
 
 enum class NodeState {
     STARTUP,
@@ -20,7 +31,7 @@ enum class MessageType : uint8_t {
     COORDINATOR = 3,
     PEER_ANNOUNCEMENT = 5,
     SHUTDOWN = 6,
-    TIME_SYNC = 7, // New 
+    // 7: retired one-way TIME_SYNC, replaced by TIME_SYNC_REQUEST / TIME_SYNC_RESPONSE
     ANIMATION_STATE = 8,
     QUERY_PRESET = 9,
     PRESET_EXIST_RESPONSE = 10,
@@ -31,41 +42,235 @@ enum class MessageType : uint8_t {
     ASSIGN_GROUP = 15,
     SYNC_PARAM = 16,
     SYNC_POWER = 17,
-    REQUEST_SYNC_PRESETS = 18,
-    PRESET_MANIFEST = 19,
-    REQUEST_PRESET_DATA = 20
+    // 18, 19: retired per-name manifest sync, replaced by PRESET_DIGEST
+    REQUEST_PRESET_DATA = 20,
+    AUDIO_FEATURES = 21,
+    BULK_END = 22,
+    BULK_NACK = 23,
+    PRESET_DIGEST = 24,
+    PRESET_BUCKET_REQUEST = 25,
+    PRESET_BUCKET_ENTRIES = 26,
+    TIME_SYNC_REQUEST = 27,
+    TIME_SYNC_RESPONSE = 28,
+    PIXEL_FRAME = 29,
+    HANDOVER = 30,
+    EVENT = 31
 };
 
+// Outbound scheduling classes, most urgent first
+enum class MeshPriority : uint8_t {
+    REALTIME = 0, // Time sync, audio beats: never paced
+    CONTROL = 1,  // Elections, parameters, commands
+    STREAM = 2,   // Pixel frames
+    BULK = 3      // Preset transfer and anti-entropy
+};
+#define MESH_PRIORITY_CLASSES 4
+
+// ANIMATION_STATE: a scene commit. Every node of the group stages it and
+// switches on its first frame at or after applyAt, so the group cuts over
+// together. The rest of the frame is an optional JSON object in the preset
+// "params" format, applied on top of the preset.
 struct __attribute__((packed)) AnimationStatePayload {
-    char animationName[32];
-    char groupName[32]; // New
-    uint32_t startTime;
+    uint32_t applyAt;       // Network time (ms)
+    char animationName[32]; // Preset; empty keeps the current one
 };
 
 struct __attribute__((packed)) MeshMessage {
     MessageType type;
-    uint64_t senderId;
+    uint64_t senderId;       // Origin, kept unchanged by relays
     uint32_t sequenceNumber;
     uint8_t totalPackets;
     uint8_t packetIndex;
     uint8_t dataLength;
-    uint8_t data[230]; // 246 total - 16 bytes header = 230 for data
+    uint8_t ttl;             // Relay hops left
+    uint16_t relayId;        // Per-origin frame counter for duplicate suppression
+    uint32_t groupHash;      // fnv1a32 of the group a group-scoped frame is for, else 0
+    uint8_t data[226]; // 249 total - 23 bytes header = 226 for data
+};
+
+// Only the header and dataLength bytes of data go on air
+static constexpr size_t MESH_HEADER_SIZE = offsetof(MeshMessage, data);
+static constexpr size_t MESH_MAX_DATA = sizeof(MeshMessage::data);
+static_assert(sizeof(MeshMessage) <= MESH_RADIO_MAX_FRAME, "MeshMessage exceeds a radio frame");
+
+#define MESH_DEFAULT_TTL 3
+
+#define AUDIO_FLAG_BEAT 0x01
+
+// HEARTBEAT: the master's lease beacon. Any frame from the master renews its
+// lease; the beacon adds the term and who takes over, in order, if it lapses.
+#define LEASE_MAX_SUCCESSORS 4
+
+struct __attribute__((packed)) LeaderBeaconPayload {
+    uint32_t term;    // Bumped at every takeover; higher term wins, then higher ID
+    uint16_t leaseMs; // Lease length from the last frame heard from the master
+    uint8_t successorCount;
+    uint64_t successors[LEASE_MAX_SUCCESSORS];
+};
+
+// COORDINATOR: a node claiming leadership for a term
+struct __attribute__((packed)) CoordinatorPayload {
+    uint32_t term;
+};
+
+// HANDOVER: a master leaving on purpose names its successor and passes on its
+// clock and scene; the successor confirms by claiming the term with COORDINATOR
+struct __attribute__((packed)) HandoverPayload {
+    uint64_t successorId;
+    uint32_t term;          // Term the successor takes
+    int64_t networkTime;    // Master's network time (µs) as the frame leaves, stamped by dispatch()
+    uint32_t groupHash;     // Scene below is for this group
+    uint8_t powerOn;
+    char animationName[32];
+};
+
+// EVENT: a beat, tap or trigger at a moment in network time. Every node of
+// the group, the sender included, fires it EVENT_SHOW_DELAY_MS later as a
+// colour flash fading out over durationMs, so radio and relay jitter never
+// puts nodes out of step.
+enum class MeshEventKind : uint8_t {
+    BEAT = 0,
+    FLASH = 1,
+    TRIGGER = 2
+};
+
+struct __attribute__((packed)) EventPayload {
+    uint32_t eventTime;  // Network time (ms) it happened
+    MeshEventKind kind;  // What raised it; all kinds draw the same flash
+    uint8_t r, g, b;
+    uint8_t intensity;   // Peak blend toward the colour
+    uint16_t durationMs;
+};
+
+struct __attribute__((packed)) AudioFeaturesPayload {
+    uint32_t captureTime; // Network time (ms) the frame was analysed
+    uint16_t frameIndex;
+    uint8_t flags;
+    uint8_t bands[AUDIO_FEATURE_BANDS];
+};
+
+// SYNC_PARAM: header followed by the raw value for its type
+//   PARAM_INT / PARAM_FLOAT: 4 bytes, PARAM_BYTE / PARAM_BOOL: 1 byte,
+//   PARAM_COLOR: r g b, PARAM_DYNAMIC_PALETTE: count then count * (r g b)
+struct __attribute__((packed)) SyncParamHeader {
+    uint32_t paramId; // AnimationParameter::id
+    uint8_t type;     // ParameterType
+};
+
+struct __attribute__((packed)) SyncPowerPayload {
+    uint8_t powerOn;
 };
 
+// Bulk transfers: chunks go out as their own MessageType with sequenceNumber
+// holding the transfer ID and packetIndex the chunk; each chunk but the last
+// carries MESH_MAX_DATA bytes. BULK_END closes a send round, receivers answer
+// with BULK_NACK listing the chunks they still miss.
+#define BULK_MAX_PACKETS 255
+#define BULK_BITMAP_BYTES ((BULK_MAX_PACKETS + 7) / 8)
+
+// Set in a transfer ID when its payload is a BulkLzssHeader followed by an
+// Lzss stream. Only used when every known peer announces MESH_CAP_LZSS and
+// it saves at least one packet.
+#define BULK_TRANSFER_LZSS 0x80000000u
+
+struct __attribute__((packed)) BulkLzssHeader {
+    uint16_t rawLength;
+};
+
+struct __attribute__((packed)) BulkEndPayload {
+    uint32_t transferId;
+    MessageType type;
+    uint8_t totalPackets;
+    uint8_t round;
+};
+
+struct __attribute__((packed)) BulkNackPayload {
+    uint64_t originId;   // Sender of the transfer
+    uint32_t transferId;
+    uint8_t totalPackets;
+    uint8_t missing[BULK_BITMAP_BYTES]; // Bit i set = chunk i missing; trimmed to totalPackets on air
+};
+
+// Preset anti-entropy: presets hash into buckets by name, each bucket sums
+// the content hashes of its presets and the root hashes the bucket array.
+#define PRESET_DIGEST_BUCKETS 16
+
+struct __attribute__((packed)) PresetDigestPayload {
+    uint32_t root;
+    uint16_t count;
+    uint32_t buckets[PRESET_DIGEST_BUCKETS];
+};
+
+struct __attribute__((packed)) PresetBucketRequestPayload {
+    uint64_t targetId;
+    uint16_t bucketMask;
+};
+
+// PRESET_BUCKET_ENTRIES: requester ID, then repeated (uint32 contentHash, name\0)
+struct __attribute__((packed)) PresetBucketEntriesHeader {
+    uint64_t requesterId;
+};
+
+// Two-way time sync, NTP style. t1/t4 are the slave's local microseconds at
+// request send / response receive, t2/t3 the source's network microseconds
+// at request receive / response send. The source is the master, or out of
+// its range a neighbour that is itself synced (see MESH_TIME_STRATUM_NONE).
+struct __attribute__((packed)) TimeSyncRequestPayload {
+    uint64_t sourceId;
+    int64_t t1;
+};
+
+struct __attribute__((packed)) TimeSyncResponsePayload {
+    uint64_t requesterId;
+    int64_t t1;
+    int64_t t2;
+    int64_t t3;
+    uint8_t stratum; // Source's hops from the master's clock; the requester is one more
+};
+
+// PIXEL_FRAME: sequenceNumber is the frame ID, totalPackets / packetIndex split
+// the frame. Each packet is this header plus a PixelCodec chunk starting at
+// pixelStart. Delta frames apply on top of baseFrameId; keyframes stand alone.
+#define PIXEL_FRAME_KEY 0x01
+
+struct __attribute__((packed)) PixelFrameHeader {
+    uint32_t displayTime; // Network time (ms) to show the frame
+    uint32_t baseFrameId;
+    uint16_t totalPixels;
+    uint16_t pixelStart;
+    uint8_t flags;
+};
+
+// Feature bits in PeerAnnouncementPayload::capabilities
+#define MESH_CAP_LZSS 0x01 // Decodes BULK_TRANSFER_LZSS transfers
+
+// Time stratum: 0 for the master, n for a node synced n exchanges away from
+// it. Nodes out of the master's range sync to the lowest stratum neighbour.
+#define MESH_TIME_STRATUM_NONE 0xFF // Not synced (or older firmware)
+
 struct __attribute__((packed)) PeerAnnouncementPayload {
     uint32_t ip;
     NodeState role;
     char groupName[32];
     char deviceName[32];
+    uint8_t capabilities; // MESH_CAP_* bits; missing (0) from older firmware
+    uint8_t timeStratum;  // Missing from older firmware
 };
 
 struct PeerInfo {
     uint64_t id;
     uint32_t ip;
     NodeState role;
-    std::string groupName;
-    std::string deviceName;
+    char groupName[32];
+    char deviceName[32];
+    uint8_t capabilities;           // MESH_CAP_* from their announcements
     unsigned long lastSeen;
+    unsigned long lastSeenReported; // lastSeen as of the last generation bump
+    int8_t rssi;                    // Of their last frame, 0 = unknown
+    unsigned long lastHeard;        // Last frame from their own radio (sent or relayed), 0 = never
+    uint8_t timeStratum;            // From their announcements, MESH_TIME_STRATUM_NONE if unsynced
+    uint8_t sequenced;              // Bit per MeshPriority class with a lastSequence
+    uint32_t lastSequence[MESH_PRIORITY_CLASSES]; // Highest sequence number seen per class, for duplicate / reorder counts
 };
 
 // Forward declaration
@@ -76,27 +281,59 @@ public:
 
     MeshNetworkManager(LedController& ledController);
 
+    // Runs on ESP-NOW and the ESP32 timer unless given another radio and clock
+    // (e.g. a simulated medium) before begin()
+    void setRadio(MeshRadio* radio, const MeshClock* clock) { this->radio = radio; this->clock = clock; }
+
     void begin();
     void update();
+
+    // Task woken when frames arrive; update() should run in that task
+    void setTaskHandle(TaskHandle_t handle) { rxTask = handle; }
     
     // Set Animation Manager for preset operations
     void setAnimationManager(AnimationManager* am) { animManager = am; }
 
-    // New: Broadcast Animation State
-    void broadcastAnimationState(const char* name, uint32_t startTime);
+    // Scene commit: switch preset and/or parameters across the group at a
+    // network time far enough ahead for the frame to reach everyone (applied
+    // locally right away when not in a group). Returns the network time (ms)
+    // it takes effect, or 0 if the parameters don't fit in a frame.
+    uint32_t commitScene(const char* name, const char* paramsJson = nullptr);
+    uint32_t getSceneLeadMs() const;
+    // Animation task, before rendering the frame for frameTime; true if a staged scene was applied
+    bool applyDueScene(uint32_t frameTime);
+    void setSceneCallback(std::function<void()> callback) { sceneCallback = callback; }
+
+    // Events: flash every node of the group on the same frame, EVENT_SHOW_DELAY_MS
+    // after now (applied locally when not in a group). Returns the network
+    // time (ms) it fires.
+    static const uint32_t EVENT_SHOW_DELAY_MS = 100; // Covers relays: MESH_DEFAULT_TTL hops of RELAY_JITTER_MAX_MS
+    uint32_t broadcastEvent(MeshEventKind kind, CRGB color, uint8_t intensity, uint16_t durationMs);
+    // Animation task: blends the events showing at frameTime over a rendered frame
+    void renderEvents(uint32_t frameTime, CRGB* leds, int numLeds);
 
     // New: Get synchronized network time
     uint32_t getNetworkTime() const;
+    int64_t getNetworkTimeMicros() const;
+    float getClockDriftPpm() const { return clockDrift * 1e6f; }
 
     // Preset Propagation
-    bool checkPresetExists(const std::string& name); // Blocking check
+    // Does any node have this preset? Never blocks: the callback runs exactly
+    // once, right away when the answer is local or cached, otherwise on the
+    // mesh task when a peer answers or PRESET_QUERY_TIMEOUT_MS passes.
+    // Returns the query ID handed to the callback, or 0 without calling it
+    // when MAX_PRESET_QUERIES are already in flight (busy, not "missing").
+    typedef std::function<void(uint32_t queryId, bool exists)> PresetQueryCallback;
+    uint32_t queryPresetExists(const std::string& name, PresetQueryCallback callback);
+    // Answer from what we already know: 1 exists, 0 doesn't, -1 unknown
+    int lookupPresetExists(const std::string& name);
     void broadcastSavePreset(const std::string& name, const std::string& baseType, const std::string& paramsJson);
     // Removed duplicate declaration
     void broadcastDeletePreset(const std::string& name);
     void broadcastRenamePreset(const std::string& oldName, const std::string& newName);
     
     // Preset Synchronization
-    void broadcastRequestSyncPresets();
+    void broadcastPresetDigest();
     void broadcastRequestPresetData(const std::string& name, uint64_t targetId);
 
     // OTA / Updates
@@ -105,66 +342,289 @@ public:
 
     // Group Management
     void broadcastAssignGroup(uint64_t targetId, const char* newGroupName);
-    std::string getGroupName() const { return myGroupName; }
+    std::string getGroupName() const;
     void setGroupName(const std::string& name); // Persist logic will be in SystemManager
+
+    // Extra memberships on top of the group above, e.g. a room plus an "all
+    // lights" group. Commands (scenes, parameters, power) for any of them
+    // apply here; we send and stream (audio, pixels) in the primary group
+    // only. Frames for groups we're not in are dropped after a header compare.
+    static const size_t MAX_GROUP_MEMBERSHIPS = 4; // Primary included
+    void setExtraGroups(const std::vector<std::string>& names);
+    std::vector<std::string> getExtraGroups() const;
+    bool isGroupMember(uint32_t groupHash) const;
     
     // Device Name
     std::string getDeviceName() const { return myDeviceName; }
     void setDeviceName(const std::string& name);
+
+    // Audio Features: a node designated as its group's ear samples the mic
+    // and shares band energies; the rest skip ADC + FFT. Opt-in, since most
+    // nodes have no microphone at all.
+    void setAudioEar(bool designated) { audioEarDesignated = designated; }
+    bool getAudioEar() const { return audioEarDesignated; }
+    bool isAudioEar() const { return audioEarDesignated; }
+    void broadcastAudioFeatures(const AudioFeatures& features);
+    void setAudioFeaturesCallback(std::function<void(const AudioFeatures&)> callback) { audioFeaturesCallback = callback; }
     
+    // Pixel streaming: with streaming enabled the master renders frames and
+    // streams them to its group, which shows them at the tagged network time
+    // instead of running the effect itself.
+    static const uint32_t PIXEL_STREAM_DELAY_MS = 60;
+    void setPixelStream(bool enabled) { pixelStreamEnabled = enabled; }
+    bool getPixelStream() const { return pixelStreamEnabled; }
+    bool isPixelStreamSource() const;
+    bool isPixelStreamActive() const; // Source, or receiving a stream for our group
+    bool isPixelStreamFrameDue() const;
+    void streamPixels(const CRGB* frame, int numLeds, uint32_t displayTime);
+    bool presentStreamFrame(CRGB* leds, int numLeds);
+
+    // Multi-hop relay (opt-in): rebroadcast frames from other nodes so the
+    // mesh reaches beyond a single radio hop
+    void setRelay(bool enabled) { relayEnabled = enabled; }
+    bool getRelay() const { return relayEnabled; }
+
+    // How long the mesh task may sleep before update() has timed work to do.
+    // Mesh task only: it reads that task's own timers without locks
+    unsigned long getIdleWaitMs() const;
+
     bool isMaster() const;
     bool isSlave() const;
 
-    void prepareForOTA();
+    // Leaving on purpose (OTA, reboot): a master hands its lease, clock and
+    // scene to its first live successor and waits up to HANDOVER_TIMEOUT_MS
+    // for the takeover; any node stops standing for leader. Call from any task
+    // but the mesh task. True once nobody depends on us; cancelRestart() undoes it.
+    bool prepareForRestart();
+    void cancelRestart();
+
+    // Telemetry
+    const MeshStats& getStats() const { return stats; }
+    static const char* messageTypeName(MessageType type);
 
 private:
     LedController& ledController;
+    EspNowRadio espNowRadio;
+    EspClock espClock;
+    MeshRadio* radio = &espNowRadio;
+    const MeshClock* clock = &espClock;
     AnimationManager* animManager = nullptr;
     uint64_t myId;
     NodeState currentState;
     uint64_t masterId;
     unsigned long lastHeartbeatTime;
     unsigned long lastElectionTime;
-    uint32_t sequenceNumber;
+    unsigned long electionSendAt = 0; // ELECTION goes out after a jitter, from update()
+    bool electionSent = false;
+    std::atomic<uint32_t> sequenceNumber;
     bool electionInProgress;
     bool receivedOK;
     
-    int32_t timeOffset; 
-    double smoothedOffset;
-    bool hasSyncedOnce; 
-
-    // Query state
-    bool lastQueryFound;
-    std::string lastQueryName;
+    // Network clock: network = local + offset + drift * (local - refLocal), in µs.
+    // Slaves fit offset and drift from request/response exchanges with their time
+    // source: the master when it is in range, else the neighbour nearest to it in
+    // strata, so the clock reaches every hop of a relayed mesh. The master keeps
+    // extrapolating its last fit so time stays continuous across elections.
+    static const int TIME_SYNC_WINDOW = 8;
+    static const unsigned long TIME_SYNC_FAST_MS = 250;      // until the window has filled
+    static const unsigned long TIME_SYNC_INTERVAL_MIN_MS = 2000; // doubles while samples agree
+    static const unsigned long TIME_SYNC_INTERVAL_MAX_MS = 16000;
+    static const int64_t TIME_SYNC_CALM_US = 1000;           // error that still counts as agreeing
+    static const int64_t TIME_SYNC_STEP_US = 5000;           // larger errors restart the filter
+    static const int64_t TIME_SYNC_DRIFT_BASELINE_US = 10000000; // min spacing for drift estimates
+    static constexpr double TIME_SYNC_MAX_DRIFT = 200e-6;
+    static const uint8_t TIME_STRATUM_MAX = 16;                 // deeper counts as unsynced (stale loops)
+    static const unsigned long TIME_STRATUM_STALE_MS = 40000;   // unsynced after this long without an answer
+    static const unsigned long TIME_SOURCE_HEARD_MS = 30000;    // neighbours heard this recently can be sources
+    struct ClockSample {
+        int64_t local;  // Local time at the exchange midpoint
+        int64_t offset;
+        int64_t delay;  // Round trip minus master turnaround
+    };
+    ClockSample clockSamples[TIME_SYNC_WINDOW];
+    int clockSampleCount = 0;
+    int clockSampleNext = 0;
+    int64_t clockRefLocal = 0;
+    int64_t clockRefOffset = 0;
+    double clockDrift = 0;
+    bool hasSyncedOnce = false;
+    bool hasDriftBase = false;
+    int64_t driftBaseLocal = 0;
+    int64_t driftBaseOffset = 0;
+    uint64_t timeSyncMasterId = 0;   // Master when the last sample was taken
+    uint64_t timeSyncSourceId = 0;   // Whose clock the samples in the window are of
+    uint64_t pendingTimeSyncSource = 0;
+    uint8_t timeSyncStratum = MESH_TIME_STRATUM_NONE;
+    unsigned long lastTimeSyncAnswer = 0;
+    int64_t pendingTimeSyncT1 = 0;
+    unsigned long nextTimeSyncRequest = 0;
+    unsigned long timeSyncInterval = TIME_SYNC_INTERVAL_MIN_MS;
+    mutable portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Preset existence queries. Names learned from peers (bucket entries,
+    // query answers, delete/rename broadcasts) are cached for a while so most
+    // lookups never touch the radio; misses expire quickly since a preset
+    // can appear on any node.
+    static const unsigned long PRESET_QUERY_TIMEOUT_MS = 500;
+    static const unsigned long PRESET_KNOWN_TTL_MS = 60000;
+    static const unsigned long PRESET_MISSING_TTL_MS = 5000;
+    static const size_t PRESET_CACHE_CAPACITY = 32;
+    static const size_t MAX_PRESET_QUERIES = 8;
+    struct PresetQuery {
+        uint32_t id;
+        std::string name;
+        unsigned long deadline;
+        PresetQueryCallback callback;
+    };
+    struct KnownPreset {
+        std::string name;
+        bool exists;
+        unsigned long expires;
+    };
+    std::vector<PresetQuery> presetQueries;
+    std::vector<KnownPreset> knownPresets;
+    std::mutex presetQueryMutex; // Web task asks, mesh task answers
+    uint32_t nextPresetQueryId = 1;
+    void rememberPreset(const std::string& name, bool exists);
+    void resolvePresetQueries(const std::string& name, bool exists);
+    void processPresetQueries(unsigned long now);
 
     // Callbacks
     std::function<void()> otaCallback;
-
-
-    uint8_t broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-
-    // Frame assembly for slaves
+    std::function<void(const AudioFeatures&)> audioFeaturesCallback;
+    std::function<void()> sceneCallback;
+
+    // Scheduled scenes: staged by the web and mesh tasks, applied by the animation task
+    static const size_t SCENE_PARAMS_MAX = sizeof(MeshMessage::data) - sizeof(AnimationStatePayload);
+    static const uint32_t SCENE_LEAD_MIN_MS = 40;       // a few frames plus task scheduling
+    static const uint32_t SCENE_LEAD_MAX_MS = 500;
+    static const uint32_t SCENE_LEAD_PER_QUEUED_MS = 5; // each urgent frame queued ahead of ours
+    static const uint32_t SCENE_MAX_AHEAD_MS = 5000;    // further out means our clocks disagree
+    struct PendingScene {
+        bool pending;
+        uint32_t applyAt;
+        char name[32];
+        char params[SCENE_PARAMS_MAX + 1];
+    };
+    PendingScene pendingScene = {};
+    portMUX_TYPE sceneMux = portMUX_INITIALIZER_UNLOCKED;
+    void stageScene(uint32_t applyAt, const char* name, const char* params, size_t paramsLength);
+
+    // Events waiting for or showing their flash: staged by the web and mesh
+    // tasks, drawn by the animation task
+    static const size_t MAX_ACTIVE_EVENTS = 4;
+    struct ActiveEvent {
+        bool used;
+        uint32_t fireAt;
+        uint16_t durationMs;
+        uint8_t intensity;
+        CRGB color;
+    };
+    ActiveEvent activeEvents[MAX_ACTIVE_EVENTS] = {};
+    portMUX_TYPE eventMux = portMUX_INITIALIZER_UNLOCKED;
+    void stageEvent(uint32_t fireAt, const EventPayload& event);
+
+    // Audio feature sharing
+    static const unsigned long AUDIO_FEATURE_MIN_INTERVAL_MS = 10; // cap at 100 Hz
+    static const unsigned long AUDIO_SOURCE_TIMEOUT_MS = 500;      // switch ears after this much silence
+    static const uint32_t AUDIO_FEATURE_MAX_AGE_MS = 250;          // drop frames stuck in queues
+    bool audioEarDesignated = false;
+    unsigned long lastAudioSendTime = 0;
+    uint16_t audioFrameIndex = 0;
+    uint64_t audioSourceId = 0;
+    unsigned long lastAudioSourceTime = 0;
+    uint16_t lastAudioFrameIndex = 0;
+
+
+    // Pixel streaming, source side (animation task)
+    static const unsigned long PIXEL_STREAM_INTERVAL_MS = 33;    // ~30 fps
+    static const unsigned long PIXEL_KEYFRAME_INTERVAL_MS = 1000; // also the keep-alive
+    static const unsigned long PIXEL_STREAM_TIMEOUT_MS = 1000;    // fall back to local rendering
+    static const uint8_t PIXEL_STREAM_MAX_PACKETS = 32;
+    bool pixelStreamEnabled = false;
+    std::vector<CRGB> streamLastSent;
+    std::vector<MeshMessage> streamPackets;
+    uint32_t streamFrameId = 0;
+    bool streamHasSent = false;
+    unsigned long lastStreamSendTime = 0;
+    unsigned long lastKeyframeTime = 0;
+
+    // Frame assembly for slaves (mesh task), presented by the animation task.
+    // Buffers are sized to our strip once in begin(); pixels beyond it are dropped.
     struct FrameBuffer {
+        uint64_t senderId;
         uint32_t sequenceNumber;
         uint8_t totalPackets;
         uint8_t receivedPackets;
-        CRGB* leds;
-        unsigned long lastPacketTime;
+        uint8_t received[PIXEL_STREAM_MAX_PACKETS / 8];
+        bool valid;
+        uint32_t displayTime;
     };
-    FrameBuffer frameBuffer = {0, 0, 0, nullptr, 0};
+    FrameBuffer frameBuffer = {};
+    std::vector<CRGB> streamWorking;  // Frame being assembled
+    std::vector<CRGB> streamReady;    // Last complete frame, base for the next delta
+    uint64_t streamReadySender = 0;
+    uint32_t streamReadyId = 0;
+    bool streamHasReady = false;
+    uint32_t streamReadyDisplayTime = 0;
+    bool streamReadyPending = false;
+    unsigned long lastStreamRxTime = 0;
+    portMUX_TYPE streamMux = portMUX_INITIALIZER_UNLOCKED;
     
-    // Preset assembly buffer
-    struct PresetBuffer {
-        uint32_t sequenceNumber;
+    // Bulk transfer, sending side. Submitted from any task, sent one chunk per
+    // ESP-NOW send completion from the mesh task.
+    static const uint8_t BULK_MAX_ROUNDS = 6;
+    static const size_t BULK_MAX_QUEUED = 8;
+    static const unsigned long BULK_LINGER_MS = 150;      // wait for NACKs after BULK_END
+    static const unsigned long TX_COMPLETE_TIMEOUT_MS = 20; // assume done if the send callback never fires
+    struct OutboundTransfer {
+        MessageType type;
+        uint32_t transferId;
+        std::vector<uint8_t> payload;
+        uint8_t totalPackets;
+        uint8_t round;
+        uint8_t cursor;
+        uint8_t toSend[BULK_BITMAP_BYTES];
+        bool lzss;                  // payload is compressed, flagged in the transfer ID
+        bool ending;                // round finished, BULK_END sent
+        unsigned long lingerUntil;
+    };
+    bool outboundActive = false;
+    OutboundTransfer outbound;
+    std::vector<OutboundTransfer> outboundQueue;
+    std::mutex outboundMutex;
+    std::atomic<bool> txBusy{false};
+    unsigned long txStartTime = 0;
+
+    // Bulk transfer, receiving side: a small pool of sessions keyed by
+    // (sender, transfer ID), so transfers from different nodes (everyone
+    // answering the same digest) reassemble side by side. A sender only has
+    // one transfer out at a time; its next one takes over its session.
+    static const unsigned long BULK_NACK_RETRY_MS = 200;  // re-NACK after this much silence
+    static const unsigned long BULK_RX_TIMEOUT_MS = 2000; // abandon an incomplete transfer
+    static const size_t BULK_RX_SESSIONS = 4;
+    // Largest payload each bulk type may carry, enforced by both ends; a
+    // transfer announcing more packets is refused before anything is stored
+    static const size_t BULK_PRESET_MAX_BYTES = 4096;     // name, base type and params JSON
+    static size_t bulkMaxBytes(MessageType type);
+    // Per session, allocated once in begin(): the largest type in whole chunks
+    static const size_t BULK_RX_BUFFER = ((BULK_PRESET_MAX_BYTES + MESH_MAX_DATA - 1) / MESH_MAX_DATA) * MESH_MAX_DATA;
+    struct InboundTransfer {
+        bool active;
+        bool complete;
+        MessageType type;
+        uint64_t senderId;
+        uint32_t transferId;
         uint8_t totalPackets;
         uint8_t receivedPackets;
-        std::string name;
-        std::string baseType;
-        std::vector<uint8_t> data; // Just the JSON part
-        std::vector<bool> receivedPacketFlags; // Track which packets we have received
-        unsigned long lastPacketTime;
+        uint8_t received[BULK_BITMAP_BYTES];
+        size_t length;              // known once the last chunk is in
+        std::vector<uint8_t> data;  // BULK_RX_BUFFER reserved up front, never grown
+        unsigned long lastActivity;
+        unsigned long nackTime;     // 0 = no NACK scheduled
     };
-    PresetBuffer presetBuffer;
+    InboundTransfer inbound[BULK_RX_SESSIONS] = {};
+    std::vector<uint8_t> bulkDecoded; // Decompressed payload being delivered, reserved once in begin()
 
     // Param assembly buffer
     struct ParamBuffer {
@@ -177,39 +637,19 @@ private:
     };
     ParamBuffer paramBuffer;
 
-    // Pending broadcast queue (to send from main loop, not HTTP callback)
-    struct PendingPresetBroadcast {
-        bool pending = false;
-        std::string name;
-        std::string baseType;
-        std::string paramsJson;
-    };
-    PendingPresetBroadcast pendingSavePreset;
-    std::string pendingDeletePreset;
-    struct PendingRename { std::string oldName; std::string newName; };
-    PendingRename pendingRenamePreset;
-
-    struct PendingGroupAssignment { 
-        bool pending = false;
-        uint64_t targetId; 
-        std::string groupName; 
-    };
-    PendingGroupAssignment pendingGroupAssignment;
-
-    struct PendingParamSync {
-        bool pending = false;
-        std::string paramName;
-        std::string jsonValue;
-    };
-    PendingParamSync pendingParamSync;
-
-    struct PendingPowerSync {
-        bool pending = false;
-        bool powerOn;
-    };
-    PendingPowerSync pendingPowerSync;
-
+    // Set by the mesh task, read by every task: the name under its mutex, the
+    // hash published on its own for the per-frame checks
     std::string myGroupName;
+    mutable std::mutex groupNameMutex;
+    std::atomic<uint32_t> myGroupHash;
+    bool inGroup() const;
+    std::vector<std::string> extraGroups;
+    mutable std::mutex extraGroupsMutex;
+    uint32_t memberHashes[MAX_GROUP_MEMBERSHIPS] = {}; // Primary first when set
+    size_t memberCount = 0;
+    mutable portMUX_TYPE groupMux = portMUX_INITIALIZER_UNLOCKED;
+    void rebuildMemberships();
+    static bool isGroupScoped(MessageType type);
     std::string myDeviceName;
     
     // Track requested presets to avoid spamming requests
@@ -219,13 +659,26 @@ private:
     };
     std::vector<RequestTracker> requestedPresets; 
     
-    // Non-blocking sync queues
-    struct ManifestQueue {
-        std::vector<std::string> names;
-        unsigned long nextSendTime = 0;
-        bool active = false;
+    // Digest exchange, on a Trickle timer: a digest matching ours counts as
+    // consistent, so in a settled mesh about one node per interval speaks. A
+    // peer's differing buckets are pulled at most once per (their root, our
+    // root) pair, so sets that differ only in ways we can't fix (they lack our
+    // presets) stop generating traffic until something changes.
+    static const unsigned long PRESET_DIGEST_IMIN_MS = 2000;
+    static const unsigned long PRESET_DIGEST_IMAX_MS = 64000;
+    static const uint8_t PRESET_DIGEST_REDUNDANCY = 1;
+    static const unsigned long PRESET_DIGEST_CHECK_MS = 1000; // how often our own root is recomputed
+    static const unsigned long PRESET_RECONCILE_MEMORY_MS = 60000;
+    TrickleTimer digestTrickle{PRESET_DIGEST_IMIN_MS, PRESET_DIGEST_IMAX_MS, PRESET_DIGEST_REDUNDANCY};
+    uint32_t lastDigestRoot = 0;
+    unsigned long lastDigestCheck = 0;
+    struct ReconcileState {
+        uint64_t peerId;
+        uint32_t peerRoot;
+        uint32_t myRoot;
+        unsigned long time;
     };
-    ManifestQueue manifestQueue;
+    std::vector<ReconcileState> reconciled;
     
     struct DataRequestQueue {
         struct Request {
@@ -237,13 +690,38 @@ private:
     };
     DataRequestQueue dataRequestQueue;
     
-    static MeshNetworkManager* instance;
-
-    static void onReceiveWrapper(const uint8_t* mac, const uint8_t* data, int len);
+    // Raw frames queued by the radio callback, drained by update() in the mesh task
+    struct RxFrame {
+        uint8_t mac[6];
+        uint8_t len;
+        int64_t rxMicros; // clock->micros() at reception, before queueing delay
+        int8_t rssi;      // 0 when unknown
+        uint8_t data[sizeof(MeshMessage)];
+    };
+    static const size_t RX_QUEUE_SIZE = 32;
+    SpscRing<RxFrame, RX_QUEUE_SIZE> rxQueue;
+    TaskHandle_t volatile rxTask = nullptr;
+    int64_t currentRxMicros = 0; // rxMicros of the frame being handled
+    int8_t currentRxRssi = 0;
+    void processReceived();
+
+    void onRadioReceive(const uint8_t* mac, const uint8_t* data, int len, int8_t rssi);
+    void onRadioSent(const uint8_t* mac, bool delivered);
     void onReceive(const uint8_t* mac, const uint8_t* data, int len);
 
-    void sendTimeSync();
-    void handleTimeSync(const MeshMessage& msg);
+    // Telemetry
+    static const int32_t SEQUENCE_REORDER_WINDOW = 1024; // further back counts as a sender restart
+    MeshStats stats;
+    uint64_t statsMasterId = 0;
+    void trackPeerFrame(const MeshMessage& msg, uint64_t from); // from: the radio we heard, origin or relay
+
+    int64_t localToNetworkMicros(int64_t local) const;
+    void sendTimeSyncRequest();
+    uint64_t chooseTimeSource() const;
+    uint8_t getTimeStratum() const;
+    void handleTimeSyncRequest(const MeshMessage& msg);
+    void handleTimeSyncResponse(const MeshMessage& msg);
+    void addClockSample(int64_t local, int64_t offset, int64_t delay);
     void handleAnimationState(const MeshMessage& msg);
     void handleHeartbeat(const MeshMessage& msg);
     void handleElection(const MeshMessage& msg);
@@ -255,8 +733,7 @@ private:
     
     void handleQueryPreset(const MeshMessage& msg);
     void handlePresetExistResponse(const MeshMessage& msg);
-    void handleSavePreset(const MeshMessage& msg);
-    // Removed duplicate handleSavePreset
+    void handleSavePreset(uint64_t senderId, const uint8_t* data, size_t length);
     void handleDeletePreset(const MeshMessage& msg);
     void handleRenamePreset(const MeshMessage& msg);
     void handleCheckForUpdates(const MeshMessage& msg);
@@ -264,31 +741,180 @@ private:
     void handleSyncParam(const MeshMessage& msg);
     void handleSyncPower(const MeshMessage& msg);
     
-    void handleRequestSyncPresets(const MeshMessage& msg);
-    void handlePresetManifest(const MeshMessage& msg);
+    void buildPresetDigest(PresetDigestPayload& digest) const;
+    void handlePresetDigest(const MeshMessage& msg);
+    void handlePresetBucketRequest(const MeshMessage& msg);
+    void handlePresetBucketEntries(const MeshMessage& msg);
+    void requestMissingPreset(const char* name, uint64_t sourceId);
     void handleRequestPresetData(const MeshMessage& msg);
-
-    // Actual broadcast implementations (called from update())
-    void doSendSavePreset(const std::string& name, const std::string& baseType, const std::string& paramsJson);
-    void doSendDeletePreset(const std::string& name);
-    void doSendRenamePreset(const std::string& oldName, const std::string& newName);
-    void doSendAssignGroup(uint64_t targetId, const std::string& groupName);
-    void doSendSyncParam(const std::string& paramName, const std::string& jsonValue);
-    void doSendSyncPower(bool powerOn);
+    void handleAudioFeatures(const MeshMessage& msg);
+    void handleEvent(const MeshMessage& msg);
+
+    // Bulk transfer layer
+    void sendBulk(MessageType type, std::vector<uint8_t>&& payload);
+    bool peersSupport(uint8_t capability) const;
+    void deliverBulk(const InboundTransfer& session);
+    void processOutbound();
+    void sendBulkChunk(uint8_t index);
+    void handleBulkChunk(const MeshMessage& msg);
+    void handleBulkEnd(const MeshMessage& msg);
+    void handleBulkNack(const MeshMessage& msg);
+    void processInbound();
+    InboundTransfer* findInbound(uint64_t senderId, uint32_t transferId);
+    InboundTransfer* startInbound(uint64_t senderId, uint32_t transferId, MessageType type, uint8_t totalPackets);
+    void releaseInbound(InboundTransfer& session);
+    void sendBulkNack(const InboundTransfer& session);
+
+    size_t encodeSyncParam(const AnimationParameter& param, uint8_t* out, size_t capacity) const;
     
+    // Leadership: the master holds a lease, renewed by any frame it sends and
+    // backed by a beacon when it has nothing else to say. When the lease lapses
+    // the successors named in the beacon claim in turn, one slot apart, so
+    // takeover is sub-second without an election. The bully election only
+    // runs when nobody is ranked (cold start, or every successor gone too).
+    static const unsigned long LEASE_MS = 1000;
+    static const unsigned long LEASE_RENEW_MS = 300;          // beacon after this much silence
+    static const unsigned long LEASE_BEACON_REFRESH_MS = 5000; // beacon regardless, for the successor list
+    static const unsigned long TAKEOVER_SLOT_MS = 150;        // between successive successors' claims
+    static const unsigned long IDLE_LISTEN_MS = 2000;         // on boot, before calling an election
+    static const unsigned long SUCCESSOR_FRESH_MS = 20000;    // covers the slowest time-sync cadence
+    uint32_t leaderTerm = 0;
+    unsigned long leaseMs = LEASE_MS;
+    int successorRank = -1; // Our place in the master's successor list, -1 = not listed
+    uint64_t successorList[LEASE_MAX_SUCCESSORS] = {};
+    uint8_t successorCount = 0;
+    unsigned long lastBeaconTime = 0;
+    unsigned long lastSuccessorCheck = 0;
+    bool beaconDue = false;
+    bool outranks(uint32_t term, uint64_t id) const; // (term, id) beats the leader we follow
+    bool acceptLeader(uint64_t id, uint32_t term);
+    bool refreshSuccessors();
     void startElection();
-    void becomeCoordinator();
+    void sendElection();
+    void becomeCoordinator(uint32_t term);
     void sendHeartbeat();
-    void sendMessage(const MeshMessage& msg);
+
+    // Planned handover (requested from other tasks, run by the mesh task)
+    static const unsigned long HANDOVER_TIMEOUT_MS = 2000;
+    static const unsigned long HANDOVER_RETRY_MS = 150;
+    static const uint8_t HANDOVER_ATTEMPTS = 3; // per successor, then the next one
+    enum HandoverState : uint8_t { HANDOVER_NONE, HANDOVER_REQUESTED, HANDOVER_ACTIVE, HANDOVER_DONE, HANDOVER_FAILED };
+    std::atomic<uint8_t> handoverState{HANDOVER_NONE};
+    std::atomic<bool> retiring{false}; // Leaving soon: never claim leadership
+    uint64_t handoverTargets[LEASE_MAX_SUCCESSORS] = {};
+    uint8_t handoverTargetCount = 0;
+    uint8_t handoverTarget = 0;
+    uint8_t handoverAttempts = 0;
+    unsigned long nextHandoverSend = 0;
+    void processHandover(unsigned long now);
+    void sendHandover(uint64_t successorId);
+    void handleHandover(const MeshMessage& msg);
+    void releaseLease();
+
+    // Sending. sendMessage / sendTo stamp a frame we originate and queue it from
+    // any task; the mesh task drains the queue, so only it touches the radio.
+    void sendMessage(MeshMessage& msg);
+    void sendTo(uint64_t nodeId, MeshMessage& msg); // Unicast
+    void enqueue(const MeshMessage& msg, uint64_t dest, uint64_t key);
+    static MeshPriority priorityFor(MessageType type);
+    static uint64_t coalesceKey(const MeshMessage& msg);
+    void processOutbox();
+    void dispatch(MeshMessage& msg, uint64_t dest);
+    bool transmit(const MeshMessage& msg, const uint8_t* dest = nullptr); // nullptr = broadcast
+
+    // Outbound queue. One frame is on air at a time; everything but REALTIME
+    // also waits for airtime credit, which refills at AIRTIME_SHARE_PERCENT of
+    // wall time so we leave the channel room for the rest of the mesh.
+    static const size_t OUTBOX_CAPACITY = 48; // a full pixel frame plus control traffic
+    static const int64_t AIRTIME_SHARE_PERCENT = 50;
+    static const int64_t AIRTIME_BURST_US = 20000;
+    MeshOutbox<MeshMessage, OUTBOX_CAPACITY> outbox;
+    mutable portMUX_TYPE outboxMux = portMUX_INITIALIZER_UNLOCKED;
+    int64_t airtimeCredit = AIRTIME_BURST_US;
+    int64_t airtimeRefillTime = 0;
+    size_t outboxCount(MeshPriority priority) const;
+
+    // Unicast: point-to-point frames go to the target's MAC so only it wakes up,
+    // and the link layer ACKs and retries them. ESP-NOW caps registered peers
+    // (20 unencrypted), so the least recently used registration makes room.
+    // Payloads still carry the target ID, so when the link layer gives up the
+    // frame can go out again as a relayable broadcast.
+    static const size_t UNICAST_MAX_PEERS = 8;
+    struct UnicastPeer {
+        uint64_t id;
+        unsigned long lastUsed;
+    };
+    UnicastPeer unicastPeers[UNICAST_MAX_PEERS] = {};
+    bool registerUnicastPeer(uint64_t id, const uint8_t* mac);
+    struct UnicastFallback {
+        uint8_t mac[6];
+        MeshMessage msg;
+    };
+    UnicastFallback unicastFallback = {}; // Last unicast only
+    std::atomic<bool> unicastFallbackArmed{false};
+    std::atomic<bool> unicastFallbackDue{false};
+    void processUnicastFallback();
+
+    // Flooding relay. Every frame carries its origin's relayId; the seen cache
+    // drops copies, and a scheduled rebroadcast is called off once enough
+    // neighbours are heard repeating the same frame. Pixel frames are never relayed.
+    static const size_t RELAY_SEEN_SIZE = 64;
+    static const unsigned long RELAY_SEEN_MS = 5000;
+    static const size_t RELAY_MAX_PENDING = 16;  // room for a typical bulk transfer in flight
+    static const unsigned long RELAY_JITTER_MIN_MS = 2;
+    static const unsigned long RELAY_JITTER_MAX_MS = 30;
+    static const uint8_t RELAY_SUPPRESS_COPIES = 2; // relays by others heard before ours is dropped
+    struct SeenFrame {
+        uint64_t origin;
+        uint16_t relayId;
+        unsigned long time;
+    };
+    SeenFrame relaySeen[RELAY_SEEN_SIZE] = {};
+    size_t relaySeenNext = 0;
+    struct PendingRelay {
+        bool active;
+        uint8_t copiesHeard;
+        unsigned long due;
+        MeshMessage msg;
+    };
+    PendingRelay pendingRelays[RELAY_MAX_PENDING] = {};
+    bool relayEnabled = false;
+    std::atomic<uint16_t> nextRelayId{0};
+    bool acceptRelayFrame(const MeshMessage& msg); // false = copy of a frame already handled
+    void processRelays();
     
     // New: Peer Discovery
     void sendPeerAnnouncement();
-    std::vector<PeerInfo> knownPeers;
+    void buildPeerAnnouncement(PeerAnnouncementPayload& payload) const;
+    static const size_t PEER_TABLE_CAPACITY = 64;
+    static const unsigned long PEER_EXPIRY_MISSED = 3;         // announcement intervals at Imax
+    static const unsigned long PEER_SEEN_RESOLUTION_MS = 10000; // lastSeen granularity seen by readers
+    PeerTable<PeerInfo, PEER_TABLE_CAPACITY> knownPeers;
+    mutable portMUX_TYPE peerMux = portMUX_INITIALIZER_UNLOCKED;
+    unsigned long lastPeerExpiry = 0;
+    unsigned long peerExpiryMs() const { return PEER_EXPIRY_MISSED * announceTrickle.getMax() + ANNOUNCE_IMIN_MS; }
+
+    // Background gossip. Announcements back off from Imin while nothing about
+    // us or our neighbours changes; Imax grows with the mesh so the combined
+    // rate stays near one per ANNOUNCE_SPACING_MS. Any frame from the master
+    // renews its lease, so HEARTBEAT only goes out after a silence.
+    static const unsigned long ANNOUNCE_IMIN_MS = 1000;
+    static const unsigned long ANNOUNCE_IMAX_MIN_MS = 8000;
+    static const unsigned long ANNOUNCE_IMAX_MAX_MS = 60000;
+    static const unsigned long ANNOUNCE_SPACING_MS = 1000;
+    TrickleTimer announceTrickle{ANNOUNCE_IMIN_MS, ANNOUNCE_IMAX_MIN_MS, 0};
+    uint32_t lastAnnouncementHash = 0;
+    unsigned long lastBroadcastTime = 0;
+    void processGossip(unsigned long now);
 
 public: 
     // Group Sync
-    void broadcastSyncParam(const std::string& paramName, const std::string& jsonValue); // JSON value for simplicity
+    void broadcastSyncParam(const AnimationParameter& param); // Sends the parameter's current value
     void broadcastSyncPower(bool powerOn);
     
-    std::vector<PeerInfo> getPeers() const { return knownPeers; }
+    // Peer table snapshot: copies up to maxPeers entries, returns the count.
+    // The generation changes whenever anything a snapshot shows has changed.
+    static const size_t MAX_PEERS = PeerTable<PeerInfo, PEER_TABLE_CAPACITY>::MaxEntries;
+    size_t getPeers(PeerInfo* out, size_t maxPeers) const;
+    uint32_t getPeerGeneration() const;
 };
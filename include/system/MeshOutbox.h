@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity outbound queue with priority classes (0 = most urgent) and
+// per-key coalescing: pushing a message whose key is already queued replaces
+// the queued copy in place, so only the latest value goes out and it keeps its
+// turn. Key 0 never coalesces. Within a class messages leave in push order.
+// When full, a less urgent message is evicted to make room (the newest of the
+// least urgent class). Not thread-safe: callers hold their own lock.
+template <typename Message, size_t Capacity>
+class MeshOutbox {
+public:
+    struct Entry {
+        uint64_t key;
+        uint64_t dest; // 0 = broadcast, else the target node ID
+        uint8_t priority;
+        Message msg;
+    };
+
+    enum class Result { QUEUED, COALESCED, EVICTED, DROPPED };
+
+    Result push(uint8_t priority, uint64_t key, uint64_t dest, const Message& msg) {
+        if (key) {
+            for (size_t i = 0; i < Capacity; i++) {
+                if (used_[i] && slots_[i].key == key) {
+                    slots_[i].dest = dest;
+                    slots_[i].priority = priority;
+                    slots_[i].msg = msg;
+                    return Result::COALESCED;
+                }
+            }
+        }
+
+        Result result = Result::QUEUED;
+        size_t slot = Capacity;
+        for (size_t i = 0; i < Capacity; i++) {
+            if (!used_[i]) {
+                slot = i;
+                break;
+            }
+        }
+
+        if (slot == Capacity) {
+            for (size_t i = 0; i < Capacity; i++) {
+                if (slots_[i].priority <= priority) continue;
+                if (slot == Capacity || slots_[i].priority > slots_[slot].priority ||
+                    (slots_[i].priority == slots_[slot].priority && (int32_t)(order_[i] - order_[slot]) > 0)) {
+                    slot = i;
+                }
+            }
+            if (slot == Capacity) return Result::DROPPED;
+            used_[slot] = false;
+            count_--;
+            result = Result::EVICTED;
+        }
+
+        slots_[slot].key = key;
+        slots_[slot].dest = dest;
+        slots_[slot].priority = priority;
+        slots_[slot].msg = msg;
+        order_[slot] = nextOrder_++;
+        used_[slot] = true;
+        count_++;
+        return result;
+    }
+
+    // Most urgent, oldest entry; nullptr when empty. Stays queued until popFront().
+    const Entry* front() const {
+        size_t best = frontIndex();
+        return best == Capacity ? nullptr : &slots_[best];
+    }
+
+    void popFront() {
+        size_t best = frontIndex();
+        if (best == Capacity) return;
+        used_[best] = false;
+        count_--;
+    }
+
+    size_t size() const { return count_; }
+    size_t free() const { return Capacity - count_; }
+
+    size_t count(uint8_t priority) const {
+        size_t n = 0;
+        for (size_t i = 0; i < Capacity; i++) {
+            if (used_[i] && slots_[i].priority == priority) n++;
+        }
+        return n;
+    }
+
+private:
+    Entry slots_[Capacity] = {};
+    uint32_t order_[Capacity] = {};
+    bool used_[Capacity] = {};
+    size_t count_ = 0;
+    uint32_t nextOrder_ = 0;
+
+    size_t frontIndex() const {
+        size_t best = Capacity;
+        for (size_t i = 0; i < Capacity; i++) {
+            if (!used_[i]) continue;
+            if (best == Capacity || slots_[i].priority < slots_[best].priority ||
+                (slots_[i].priority == slots_[best].priority && (int32_t)(order_[i] - order_[best]) < 0)) {
+                best = i;
+            }
+        }
+        return best;
+    }
+};
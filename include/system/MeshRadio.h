@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Seam between the mesh protocol and the hardware under it. The firmware runs
+// on EspNowRadio and the ESP32 timer; a host build can hand MeshNetworkManager
+// a simulated medium and a skewed clock per node instead.
+
+#define MESH_RADIO_MAX_FRAME 250 // ESP-NOW payload limit
+
+// Monotonic time for protocol timers and timestamps
+class MeshClock {
+public:
+    virtual ~MeshClock() {}
+    virtual int64_t micros() const = 0;
+    unsigned long millis() const { return (unsigned long)(micros() / 1000); }
+};
+
+// Frame transport. Callbacks fire in the radio's own context (the Wi-Fi task
+// on hardware) and must only copy data out.
+class MeshRadio {
+public:
+    typedef std::function<void(const uint8_t* mac, const uint8_t* data, int len, int8_t rssi)> ReceiveCallback; // rssi 0 = unknown
+    typedef std::function<void(const uint8_t* mac, bool delivered)> SendCallback;
+
+    virtual ~MeshRadio() {}
+
+    virtual bool begin() = 0;
+    virtual void macAddress(uint8_t* mac) const = 0;
+
+    // Unicast destinations must be registered first; capacity is limited
+    virtual bool addPeer(const uint8_t* mac) = 0;
+    virtual void removePeer(const uint8_t* mac) = 0;
+
+    // mac == nullptr broadcasts. Completion is reported through the send callback.
+    virtual bool send(const uint8_t* mac, const uint8_t* data, size_t len) = 0;
+
+    void setReceiveCallback(ReceiveCallback callback) { receiveCallback = callback; }
+    void setSendCallback(SendCallback callback) { sendCallback = callback; }
+
+protected:
+    ReceiveCallback receiveCallback;
+    SendCallback sendCallback;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Mesh telemetry. Counters are relaxed atomics bumped from the Wi-Fi callbacks,
+// the mesh task and the animation task; readers get a near-consistent view
+// without taking any lock.
+#define MESH_STATS_TYPES 32 // MessageType values stay below this
+
+struct MeshStats {
+    typedef std::atomic<uint32_t> Counter;
+
+    struct TypeCounters {
+        Counter rxPackets{0};
+        Counter rxBytes{0};
+        Counter txPackets{0};
+        Counter txBytes{0};
+    };
+    TypeCounters types[MESH_STATS_TYPES];
+
+    Counter txFailures{0};         // esp_now_send refused the frame
+    Counter txCallbackFailures{0}; // send callback reported a failed transmission
+    Counter unicastFallbacks{0};   // unicasts never ACKed, sent again as broadcast
+    Counter rxQueueDrops{0};       // receive ring was full
+    Counter outboxCoalesced{0};    // queued frames replaced by a newer value for the same key
+    Counter outboxDrops{0};        // frames evicted or refused by a full outbound queue
+    Counter rxMalformed{0};        // bad length or header
+    Counter groupFiltered{0};      // group-scoped frames for groups we're not in
+    Counter duplicates{0};         // same frame heard again (relayed copies, repeated sequence numbers)
+    Counter outOfOrder{0};         // older sequence number than the last one from a peer in the same priority class
+    Counter reassemblyTimeouts{0}; // bulk transfers abandoned incomplete
+    Counter bulkRetransmits{0};    // chunks resent after a NACK
+    Counter pixelFramesDropped{0}; // streamed frames abandoned or missing their base
+    Counter pixelFramesSkipped{0}; // source frames not sent because the last one was still queued
+    Counter relayed{0};            // frames rebroadcast for other nodes
+    Counter relaySuppressed{0};    // rebroadcasts called off because neighbours covered them
+    Counter gossipSuppressed{0};   // periodic announcements skipped because neighbours covered them
+    Counter scenesLate{0};         // scene commits that arrived after their deadline
+    Counter eventsLate{0};         // events that arrived after their flash was due
+    Counter takeovers{0};          // successors claiming a lapsed lease
+    Counter handovers{0};          // leadership passed on by a master leaving on purpose
+    Counter elections{0};          // full elections (nobody ranked to take over)
+    Counter masterChanges{0};
+
+    // Time sync, in microseconds (written by the mesh task only)
+    std::atomic<int32_t> syncOffsetError{0}; // Last sample against the clock model
+    Counter syncJitter{0};                   // Running average of |error|
+    Counter syncDelay{0};                    // Last round trip minus master turnaround
+    Counter syncSamples{0};
+    Counter syncSteps{0};
+
+    static inline void bump(Counter& c, uint32_t n = 1) {
+        c.fetch_add(n, std::memory_order_relaxed);
+    }
+};
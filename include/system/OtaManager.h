@@ -3,6 +3,7 @@
 #include <Update.h>
 #include <ArduinoJson.h>
 #include <Preferences.h>
+#include <functional>
 #include "system/WifiManager.h"
 #include "system/LedController.h"
 
@@ -16,6 +17,10 @@ public:
     void begin();
     void update();
     void forceCheck();
+    void requestCheck() { checkRequested = true; } // Safe from other tasks; runs in update()
+    // Called with true before a firmware download starts (the node will reboot),
+    // and with false if the update then fails and the node stays up
+    void setRestartCallback(std::function<void(bool restarting)> callback) { restartCallback = callback; }
     String getVersion() const { return currentVersion; }
 
 private:
@@ -27,6 +32,8 @@ private:
     unsigned long checkInterval;
     unsigned long lastCheck = 0;
     bool wasDisconnected = false;
+    volatile bool checkRequested = false;
+    std::function<void(bool restarting)> restartCallback;
 
     Preferences prefs;
     String currentVersion;
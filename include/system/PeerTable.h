@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity open-addressed table keyed by 64-bit node ID (linear probing,
+// backward-shift deletion, no tombstones). Entry needs `uint64_t id` and
+// `unsigned long lastSeen`. Holds at most MaxEntries so probes stay short; when
+// full the stalest entry makes room. Not thread-safe: callers hold their own lock.
+template <typename Entry, size_t Capacity>
+class PeerTable {
+    static_assert(Capacity >= 4 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static const size_t MaxEntries = Capacity * 3 / 4;
+
+    Entry* find(uint64_t id) {
+        for (size_t i = home(id), n = 0; used_[i] && n < Capacity; i = next(i), n++) {
+            if (slots_[i].id == id) return &slots_[i];
+        }
+        return nullptr;
+    }
+
+    const Entry* find(uint64_t id) const {
+        return const_cast<PeerTable*>(this)->find(id);
+    }
+
+    // Returns the entry for id, adding a value-initialised one (with id set) if new
+    Entry* upsert(uint64_t id, bool& isNew) {
+        Entry* existing = find(id);
+        if (existing) {
+            isNew = false;
+            return existing;
+        }
+
+        if (count_ >= MaxEntries) evictStalest();
+
+        size_t i = home(id);
+        while (used_[i]) i = next(i);
+        slots_[i] = Entry();
+        slots_[i].id = id;
+        used_[i] = true;
+        count_++;
+        generation_++;
+        isNew = true;
+        return &slots_[i];
+    }
+
+    bool remove(uint64_t id) {
+        for (size_t i = home(id), n = 0; used_[i] && n < Capacity; i = next(i), n++) {
+            if (slots_[i].id == id) {
+                eraseAt(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Drops entries not seen for maxAge; returns how many went
+    size_t expire(unsigned long now, unsigned long maxAge) {
+        size_t removed = 0;
+        for (size_t i = 0; i < Capacity; ) {
+            if (used_[i] && now - slots_[i].lastSeen > maxAge) {
+                eraseAt(i); // May shift a later entry into i, so look at i again
+                removed++;
+            } else {
+                i++;
+            }
+        }
+        return removed;
+    }
+
+    template <typename F>
+    void forEach(F fn) const {
+        for (size_t i = 0; i < Capacity; i++) {
+            if (used_[i]) fn(slots_[i]);
+        }
+    }
+
+    size_t size() const { return count_; }
+
+    // Bumped on add/remove; callers bump it via touch() when they change visible fields
+    uint32_t generation() const { return generation_; }
+    void touch() { generation_++; }
+
+private:
+    Entry slots_[Capacity] = {};
+    bool used_[Capacity] = {};
+    size_t count_ = 0;
+    uint32_t generation_ = 0;
+
+    static size_t home(uint64_t id) {
+        // Fibonacci hashing; MAC-derived IDs share long prefixes
+        return (size_t)((id * 0x9E3779B97F4A7C15ull) >> 40) & (Capacity - 1);
+    }
+
+    static size_t next(size_t i) { return (i + 1) & (Capacity - 1); }
+
+    void eraseAt(size_t hole) {
+        used_[hole] = false;
+        count_--;
+        generation_++;
+
+        // Pull back later entries of the probe run that may no longer be reachable
+        for (size_t j = next(hole); used_[j]; j = next(j)) {
+            size_t h = home(slots_[j].id);
+            bool stays = (hole <= j) ? (hole < h && h <= j) : (hole < h || h <= j);
+            if (stays) continue;
+            slots_[hole] = slots_[j];
+            used_[hole] = true;
+            used_[j] = false;
+            hole = j;
+        }
+    }
+
+    void evictStalest() {
+        size_t victim = Capacity;
+        for (size_t i = 0; i < Capacity; i++) {
+            if (used_[i] && (victim == Capacity || (long)(slots_[i].lastSeen - slots_[victim].lastSeen) < 0)) {
+                victim = i;
+            }
+        }
+        if (victim != Capacity) eraseAt(victim);
+    }
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <FastLED.h>
+#include <cstddef>
+#include <cstdint>
+
+// Run-length pixel coding for streamed frames. A chunk is a sequence of ops,
+// each starting with one control byte:
+//   0x00-0x3F  literal: n = (op & 0x3F) + 1 pixels follow as r g b
+//   0x40-0x7F  repeat:  n = (op & 0x3F) + 1 copies of the r g b that follows
+//   0x80-0xFF  skip:    n = (op & 0x7F) + 1 pixels unchanged from the base frame
+// Skips only appear in delta chunks. Each chunk covers a contiguous pixel range
+// so a lost packet never corrupts pixels outside its own range.
+class PixelCodec {
+public:
+    static const int MAX_LITERAL = 64;
+    static const int MAX_REPEAT = 64;
+    static const int MAX_SKIP = 128;
+
+    // Encodes frame[start, start + maxCount) into out, against base when base is
+    // non-null. Stops early when the next op would not fit; encodedCount reports
+    // how many pixels the chunk covers. Returns bytes written.
+    static size_t encode(const CRGB* frame, const CRGB* base, int start, int maxCount,
+                         uint8_t* out, size_t capacity, int& encodedCount);
+
+    // Applies a chunk to dst starting at pixel start. Pixels at or beyond limit
+    // are decoded but dropped. Returns pixels covered, or -1 if malformed.
+    static int decode(const uint8_t* in, size_t length, CRGB* dst, int start, int limit);
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single-producer / single-consumer ring buffer.
+// One task (or callback) may push while exactly one other task pops.
+// Capacity must be a power of two; one slot is never used to tell full from empty.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false (and counts a drop) when the ring is full.
+    bool push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t next = (head + 1) & (Capacity - 1);
+        if (next == tail_.load(std::memory_order_acquire)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[head] = item;
+        head_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side, zero-copy: fill the slot returned by reserve(), then commit().
+    // reserve() returns nullptr (and counts a drop) when the ring is full.
+    T* reserve() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (((head + 1) & (Capacity - 1)) == tail_.load(std::memory_order_acquire)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots_[head];
+    }
+
+    void commit() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        head_.store((head + 1) & (Capacity - 1), std::memory_order_release);
+    }
+
+    // Consumer side. Returns nullptr when empty; call release() when done with the slot.
+    const T* peek() const {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return nullptr;
+        return &slots_[tail];
+    }
+
+    void release() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        tail_.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+    }
+
+    bool pop(T& out) {
+        const T* item = peek();
+        if (!item) return false;
+        out = *item;
+        release();
+        return true;
+    }
+
+    bool empty() const {
+        return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+    }
+
+    // Drops since the last call (read and reset by the consumer)
+    uint32_t takeDropped() {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    T slots_[Capacity];
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Arduino.h>
+#include <vector>
 #include "system/Config.h"
 #include "system/LedController.h"
 #include "system/WifiManager.h"
@@ -27,14 +28,17 @@ private:
     // Static task entry points
     static void animationTaskTrampoline(void* parameter);
     static void meshTaskTrampoline(void* parameter);
+    static void audioTaskTrampoline(void* parameter);
 
     // Task implementations
     void animationTask();
     void meshTask();
+    void audioTask();
 
     // FreeRTOS Task Handles
     TaskHandle_t animationTaskHandle;
     TaskHandle_t meshTaskHandle;
+    TaskHandle_t audioTaskHandle;
 
     WebManager web;
 
@@ -43,6 +47,13 @@ private:
     void saveConfig();
     std::string lastSavedGroupName;
     std::string lastSavedDeviceName;
+    bool lastSavedAudioEar = false;
+    bool lastSavedPixelStream = false;
+    bool lastSavedMeshRelay = false;
+    std::vector<std::string> lastSavedExtraGroups;
+
+    // Frame the master renders ahead for pixel streaming
+    std::vector<CRGB> streamFrame;
 
 public:
 };
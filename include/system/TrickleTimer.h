@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+
+// Trickle timer (RFC 6206) for periodic announcements, times in ms. Each
+// interval fires once, at a random point in its second half, unless k
+// consistent copies were heard first (k = 0 never suppresses). Intervals
+// double from Imin up to Imax while things stay consistent; inconsistent()
+// drops back to Imin. Not thread-safe: callers hold their own lock.
+class TrickleTimer {
+public:
+    TrickleTimer(unsigned long imin, unsigned long imax, uint8_t k)
+        : imin_(imin), imax_(imax < imin ? imin : imax), k_(k) {}
+
+    void seed(uint32_t seed) { rng_ = seed ? seed : 1; }
+
+    // Takes effect from the next interval
+    void setMax(unsigned long imax) { imax_ = imax < imin_ ? imin_ : imax; }
+    unsigned long getMax() const { return imax_; }
+
+    void start(unsigned long now) {
+        interval_ = imin_;
+        beginInterval(now);
+    }
+
+    // Heard a neighbour say what we would have said
+    void consistent() {
+        if (counter_ < 255) counter_++;
+    }
+
+    // Heard something new or changed ourselves: get the word out quickly
+    void inconsistent(unsigned long now) {
+        if (!started_ || interval_ > imin_) start(now);
+    }
+
+    // Call regularly. True once per interval when it is our turn to transmit;
+    // suppressed is set when the turn came but neighbours had it covered.
+    bool poll(unsigned long now, bool* suppressed = nullptr) {
+        if (!started_) start(now);
+        bool fire = false;
+        if (!fired_ && (long)(now - fireAt_) >= 0) {
+            fired_ = true;
+            fire = k_ == 0 || counter_ < k_;
+            if (suppressed) *suppressed = !fire;
+        }
+        if (now - intervalStart_ >= interval_) {
+            interval_ = interval_ > imax_ / 2 ? imax_ : interval_ * 2;
+            beginInterval(now);
+        }
+        return fire;
+    }
+
+    unsigned long getInterval() const { return interval_; }
+
+private:
+    unsigned long imin_;
+    unsigned long imax_;
+    uint8_t k_;
+    unsigned long interval_ = 0;
+    unsigned long intervalStart_ = 0;
+    unsigned long fireAt_ = 0;
+    uint8_t counter_ = 0;
+    bool fired_ = false;
+    bool started_ = false;
+    uint32_t rng_ = 1;
+
+    void beginInterval(unsigned long now) {
+        started_ = true;
+        intervalStart_ = now;
+        counter_ = 0;
+        fired_ = false;
+        unsigned long half = interval_ / 2;
+        fireAt_ = now + half + (half ? nextRandom() % (interval_ - half) : 0);
+    }
+
+    uint32_t nextRandom() {
+        // xorshift32: plenty to spread nodes across an interval
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        return rng_;
+    }
+};
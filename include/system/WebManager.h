@@ -3,6 +3,8 @@
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
+#include <mutex>
+#include <vector>
 #include "animation/AnimationManager.h"
 #include "system/MeshNetworkManager.h"
 #include "system/OtaManager.h"
@@ -13,6 +15,8 @@ public:
     
     void begin();
     void update(); // Call in loop for WS cleanup if needed
+    // Runs from update() when a client asks for a reboot; the owner hands over and restarts
+    void setRestartCallback(std::function<void()> callback) { restartCallback = callback; }
 
 private:
     AnimationManager& animManager;
@@ -21,6 +25,14 @@ private:
     AsyncWebServer server;
     AsyncWebSocket ws;
     bool fsMounted;
+    volatile bool restartRequested = false; // Set on the web task, acted on in update()
+    volatile bool sceneChanged = false;     // Set on the animation task, pushed in update()
+    // WebSocket events raised on other tasks, sent from update()
+    static const size_t MAX_PENDING_EVENTS = 8;
+    std::vector<String> pendingEvents;
+    std::mutex pendingEventsMutex;
+    void queueEvent(String&& json);
+    std::function<void()> restartCallback;
 
     void setupRoutes();
     void setupWebSocket();
@@ -35,4 +47,15 @@ private:
 
 
     String getPeersJson();
+    // Peers JSON is rebuilt only when the peer table or our own entry changes
+    PeerInfo peerScratch[MeshNetworkManager::MAX_PEERS];
+    String peersJsonCache;
+    bool peersJsonValid = false;
+    uint32_t peersJsonGeneration = 0;
+    bool peersJsonMaster = false;
+    std::string peersJsonGroup;
+    std::string peersJsonName;
+    String getAudioBenchmarkJson();
+    String getMeshStatsJson();
+    uint32_t triggerEvent(JsonObject args);
 };
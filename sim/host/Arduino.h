@@ -0,0 +1,126 @@
+#pragma once
+// Host stand-in for the parts of the Arduino core the mesh and the audio
+// path use, for the native builds only (never on the include path of the
+// esp32 build). Time is whatever the simulator says it is, and Serial
+// output is tagged with the node that printed it. There is no microphone:
+// the ADC reads mid-scale silence.
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <random>
+#include "HostSim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+namespace host {
+    inline std::mt19937 rng(1);        // random(); seeded per run for repeatable scenarios
+    inline bool serialEnabled = false;
+    inline std::string serialTag;      // Node currently running, prefixed to its output
+}
+
+inline unsigned long micros() { return (unsigned long)host::clockMicros(); }
+inline unsigned long millis() { return (unsigned long)(host::clockMicros() / 1000); }
+inline void delay(unsigned long ms) { if (host::delayHook) host::delayHook(ms); }
+
+inline void randomSeed(unsigned long seed) { host::rng.seed(seed); }
+inline long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) return howsmall;
+    return howsmall + (long)(host::rng() % (uint32_t)(howbig - howsmall));
+}
+inline long random(long howbig) { return random(0, howbig); }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    if (in_max == in_min) return out_min;
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+enum adc_attenuation_t { ADC_0db, ADC_2_5db, ADC_6db, ADC_11db };
+inline void analogSetPinAttenuation(uint8_t, adc_attenuation_t) {}
+inline void analogReadResolution(uint8_t) {}
+inline uint16_t analogRead(uint8_t) { return 2048; }
+
+#define HEX 16
+#define DEC 10
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+
+class String {
+public:
+    String() {}
+    String(const char* s) : str(s ? s : "") {}
+    String(const std::string& s) : str(s) {}
+    String(int value, int base = DEC) : String((long long)value, base) {}
+    String(unsigned value, int base = DEC) : String((unsigned long long)value, base) {}
+    String(long value, int base = DEC) : String((long long)value, base) {}
+    String(unsigned long value, int base = DEC) : String((unsigned long long)value, base) {}
+    String(long long value, int base = DEC) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), base == HEX ? "%llx" : "%lld", value);
+        str = buf;
+    }
+    String(unsigned long long value, int base = DEC) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), base == HEX ? "%llx" : "%llu", value);
+        str = buf;
+    }
+
+    const char* c_str() const { return str.c_str(); }
+    unsigned length() const { return str.length(); }
+    String& operator+=(const String& other) { str += other.str; return *this; }
+    String operator+(const String& other) const { return String(str + other.str); }
+    bool operator==(const String& other) const { return str == other.str; }
+
+private:
+    std::string str;
+};
+
+inline String operator+(const char* a, const String& b) { return String(a) + b; }
+
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+
+    size_t printf(const char* format, ...) {
+        char buf[512];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        write(buf);
+        return n > 0 ? n : 0;
+    }
+
+    void print(const char* s) { write(s); }
+    void print(const String& s) { write(s.c_str()); }
+    void print(long long n) { write(String(n).c_str()); }
+    void println(const char* s = "") { write(s); write("\n"); }
+    void println(const String& s) { println(s.c_str()); }
+    void println(long long n) { println(String(n)); }
+
+private:
+    bool lineStart = true;
+
+    void write(const char* s) {
+        if (!host::serialEnabled) return;
+        for (; *s; s++) {
+            if (*s == '\r') continue;
+            if (lineStart) {
+                fprintf(stdout, "%10.3f %s ", host::clockMicros() / 1e6, host::serialTag.c_str());
+                lineStart = false;
+            }
+            fputc(*s, stdout);
+            if (*s == '\n') lineStart = true;
+        }
+    }
+};
+
+inline HardwareSerial Serial;
@@ -0,0 +1,153 @@
+#pragma once
+// Host stand-in for the slice of FastLED the mesh, the LED controller and
+// the effects use: pixel values, 8-bit math, palettes and fills, with no
+// strip behind them. The math follows FastLED's formulas; palette lookups
+// and HSV are close to FastLED's, not bit-exact.
+#include "Arduino.h"
+
+typedef uint8_t fract8;
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) { unsigned t = i + j; return t > 255 ? 255 : t; }
+inline uint8_t qsub8(uint8_t i, uint8_t j) { return i > j ? i - j : 0; }
+inline uint8_t qmul8(uint8_t i, uint8_t j) { unsigned p = i * j; return p > 255 ? 255 : p; }
+inline uint8_t scale8(uint8_t i, fract8 scale) { return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8; }
+inline uint8_t scale8_video(uint8_t i, fract8 scale) { return (((int)i * (int)scale) >> 8) + ((i && scale) ? 1 : 0); }
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+    uint16_t partial = (a << 8) | b;
+    partial += b * amountOfB;
+    partial -= a * amountOfB;
+    return partial >> 8;
+}
+
+// FastLED keeps its own generator; the host one shares random()'s seed
+inline uint8_t random8() { return (uint8_t)host::rng(); }
+inline uint8_t random8(uint8_t lim) { return (uint8_t)((random8() * lim) >> 8); }
+inline uint8_t random8(uint8_t min, uint8_t lim) { return min + random8(lim - min); }
+
+struct CHSV {
+    uint8_t h, s, v;
+    CHSV(uint8_t h, uint8_t s, uint8_t v) : h(h), s(s), v(v) {}
+};
+
+struct CRGB {
+    union {
+        struct {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+        };
+        uint8_t raw[3];
+    };
+
+    typedef enum : uint32_t {
+        Black = 0x000000,
+        White = 0xFFFFFF,
+        Red = 0xFF0000,
+        Green = 0x008000,
+        Blue = 0x0000FF,
+        Cyan = 0x00FFFF,
+        DarkBlue = 0x00008B,
+        Orange = 0xFFA500,
+        Purple = 0x800080,
+        Teal = 0x008080,
+        Yellow = 0xFFFF00,
+    } HTMLColorCode;
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t r, uint8_t g, uint8_t b) : r(r), g(g), b(b) {}
+    CRGB(uint32_t colorcode) : r(colorcode >> 16), g(colorcode >> 8), b(colorcode) {}
+    CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+    CRGB(const CHSV& hsv) {
+        // Plain six-sector spectrum; FastLED's "rainbow" spends more of the
+        // wheel on yellow, which is cosmetic here
+        uint8_t sector = hsv.h / 43;
+        uint8_t rise = (hsv.h - sector * 43) * 6;
+        uint8_t low = scale8(hsv.v, 255 - hsv.s);
+        uint8_t up = low + scale8(hsv.v - low, rise);
+        uint8_t down = hsv.v - scale8(hsv.v - low, rise);
+        switch (sector) {
+            case 0: r = hsv.v; g = up; b = low; break;
+            case 1: r = down; g = hsv.v; b = low; break;
+            case 2: r = low; g = hsv.v; b = up; break;
+            case 3: r = low; g = down; b = hsv.v; break;
+            case 4: r = up; g = low; b = hsv.v; break;
+            default: r = hsv.v; g = low; b = down; break;
+        }
+    }
+
+    uint8_t& operator[](uint8_t x) { return raw[x]; }
+    const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+
+    CRGB& operator+=(const CRGB& rhs) { r = qadd8(r, rhs.r); g = qadd8(g, rhs.g); b = qadd8(b, rhs.b); return *this; }
+    CRGB& nscale8(uint8_t scale) { r = scale8(r, scale); g = scale8(g, scale); b = scale8(b, scale); return *this; }
+    CRGB& nscale8_video(uint8_t scale) { r = scale8_video(r, scale); g = scale8_video(g, scale); b = scale8_video(b, scale); return *this; }
+
+    uint8_t getAverageLight() const { return (uint8_t)(((uint16_t)r * 85 + (uint16_t)g * 85 + (uint16_t)b * 85) >> 8); }
+};
+
+inline bool operator==(const CRGB& a, const CRGB& b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+inline bool operator!=(const CRGB& a, const CRGB& b) { return !(a == b); }
+inline CRGB operator*(const CRGB& p, uint8_t d) { return CRGB(qmul8(p.r, d), qmul8(p.g, d), qmul8(p.b, d)); }
+
+inline CRGB blend(const CRGB& p1, const CRGB& p2, fract8 amountOfP2) {
+    return CRGB(blend8(p1.r, p2.r, amountOfP2), blend8(p1.g, p2.g, amountOfP2), blend8(p1.b, p2.b, amountOfP2));
+}
+
+struct CRGBPalette16 {
+    CRGB entries[16];
+
+    CRGBPalette16() {}
+    CRGBPalette16(const CRGB& c) { for (auto& e : entries) e = c; }
+    operator CRGB*() { return entries; }
+    const CRGB& operator[](int x) const { return entries[x]; }
+};
+
+enum TBlendType { NOBLEND = 0, LINEARBLEND = 1 };
+
+inline CRGB ColorFromPalette(const CRGBPalette16& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND) {
+    uint8_t hi4 = index >> 4;
+    uint8_t lo4 = index & 0x0F;
+    CRGB color = pal[hi4];
+    if (lo4 && blendType != NOBLEND) {
+        color = blend(color, pal[(hi4 + 1) & 0x0F], lo4 << 4);
+    }
+    if (brightness != 255) color.nscale8_video(brightness);
+    return color;
+}
+
+inline void fill_solid(CRGB* leds, int numToFill, const CRGB& color) {
+    for (int i = 0; i < numToFill; i++) leds[i] = color;
+}
+
+inline void fill_gradient_RGB(CRGB* leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor) {
+    if (endpos < startpos) {
+        std::swap(startpos, endpos);
+        std::swap(startcolor, endcolor);
+    }
+    uint16_t span = endpos - startpos;
+    for (uint16_t i = startpos; i <= endpos; i++) {
+        uint16_t t = span ? (uint16_t)((i - startpos) * 255 / span) : 0;
+        for (int c = 0; c < 3; c++) {
+            leds[i][c] = (uint8_t)(startcolor[c] + ((int)endcolor[c] - (int)startcolor[c]) * t / 255);
+        }
+    }
+}
+
+inline CRGB& nblend(CRGB& existing, const CRGB& overlay, uint8_t amountOfOverlay) {
+    for (int c = 0; c < 3; c++) {
+        existing[c] = (uint8_t)(existing[c] + (((int)overlay[c] - (int)existing[c]) * amountOfOverlay) / 255);
+    }
+    return existing;
+}
+
+enum { WS2812B, GRB };
+
+class CFastLED {
+public:
+    template<int CHIPSET, int DATA_PIN, int RGB_ORDER>
+    void addLeds(CRGB*, int) {}
+    void setBrightness(uint8_t) {}
+    void show() {}
+};
+
+inline CFastLED FastLED;
@@ -0,0 +1,20 @@
+#pragma once
+// Shared state of the host stand-ins, owned by the simulator
+#include <cstdint>
+#include <functional>
+#include <chrono>
+
+namespace host {
+    inline int64_t nowMicros = 0; // Simulated time, advanced by the simulator
+    // Tools that measure real cost (the audio benchmark) read the host's
+    // clock instead; the mesh simulator never sets this
+    inline bool wallClock = false;
+    inline int64_t clockMicros() {
+        if (!wallClock) return nowMicros;
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    // Called from delay()/vTaskDelay(): code that waits (a handover) lets the
+    // rest of the simulation run in the meantime
+    inline std::function<void(uint32_t ms)> delayHook;
+}
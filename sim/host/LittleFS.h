@@ -0,0 +1,38 @@
+#pragma once
+#include "Arduino.h"
+#include <memory>
+
+// Read-only LittleFS over a host directory (host::fsRoot, PlatformIO's
+// data/ by default, the tree `pio run -t uploadfs` flashes), so the same
+// paths work on the device and on the host. Writes are refused.
+namespace host {
+    inline std::string fsRoot = "data";
+}
+
+#define FILE_READ "r"
+
+class File {
+public:
+    File() {}
+    explicit File(FILE* f) { if (f) handle.reset(f, fclose); }
+
+    explicit operator bool() const { return handle != nullptr; }
+    size_t read(uint8_t* buf, size_t size) { return handle ? fread(buf, 1, size, handle.get()) : 0; }
+    bool seek(uint32_t pos) { return handle && fseek(handle.get(), pos, SEEK_SET) == 0; }
+    size_t position() const { return handle ? (size_t)ftell(handle.get()) : 0; }
+    void close() { handle.reset(); }
+
+private:
+    std::shared_ptr<FILE> handle;
+};
+
+class HostLittleFS {
+public:
+    bool begin(bool = false) { return true; }
+    File open(const char* path, const char* mode = FILE_READ) {
+        if (strcmp(mode, FILE_READ) != 0) return File();
+        return File(fopen((host::fsRoot + path).c_str(), "rb"));
+    }
+};
+
+inline HostLittleFS LittleFS;
@@ -0,0 +1,21 @@
+#pragma once
+#include "Arduino.h"
+
+class IPAddress {
+public:
+    IPAddress(uint32_t address = 0) : address(address) {}
+    operator uint32_t() const { return address; }
+
+private:
+    uint32_t address;
+};
+
+// Simulated nodes have no station interface; the mesh radio supplies the MAC
+class WiFiClass {
+public:
+    IPAddress localIP() const { return IPAddress(); }
+    void macAddress(uint8_t* mac) const { memset(mac, 0, 6); }
+    int channel() const { return 1; }
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,73 @@
+#pragma once
+// Host stand-in for the arduinoFFT 2.x calls the audio analyzer makes:
+// Hamming window, in-place radix-2 FFT and magnitudes, same layout and
+// scaling as the library so the effects' energy thresholds carry over.
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+enum class FFTDirection { Reverse, Forward };
+enum class FFTWindow { Rectangle, Hamming };
+
+#define FFT_FORWARD FFTDirection::Forward
+#define FFT_REVERSE FFTDirection::Reverse
+#define FFT_WIN_TYP_RECTANGLE FFTWindow::Rectangle
+#define FFT_WIN_TYP_HAMMING FFTWindow::Hamming
+
+template <typename T>
+class ArduinoFFT {
+public:
+    ArduinoFFT(T* vReal, T* vImag, uint_fast16_t samples, T samplingFrequency, bool = false) {}
+
+    void windowing(T* vData, uint_fast16_t samples, FFTWindow windowType, FFTDirection dir) {
+        if (windowType != FFTWindow::Hamming) return;
+        // Symmetric window, applied to both halves from the outside in
+        T last = samples - 1;
+        for (uint_fast16_t i = 0; i < (samples >> 1); i++) {
+            T factor = 0.54 - 0.46 * std::cos(2.0 * M_PI * i / last);
+            if (dir == FFTDirection::Forward) {
+                vData[i] *= factor;
+                vData[samples - (i + 1)] *= factor;
+            } else {
+                vData[i] /= factor;
+                vData[samples - (i + 1)] /= factor;
+            }
+        }
+    }
+
+    void compute(T* vReal, T* vImag, uint_fast16_t samples, FFTDirection dir) {
+        // Bit-reversal permutation
+        for (uint_fast16_t i = 1, j = 0; i < samples; i++) {
+            uint_fast16_t bit = samples >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) {
+                std::swap(vReal[i], vReal[j]);
+                std::swap(vImag[i], vImag[j]);
+            }
+        }
+        // Butterflies
+        T sign = dir == FFTDirection::Forward ? -1 : 1;
+        for (uint_fast16_t len = 2; len <= samples; len <<= 1) {
+            T angle = sign * 2.0 * M_PI / len;
+            for (uint_fast16_t start = 0; start < samples; start += len) {
+                for (uint_fast16_t k = 0; k < len / 2; k++) {
+                    T wr = std::cos(angle * k), wi = std::sin(angle * k);
+                    uint_fast16_t a = start + k, b = a + len / 2;
+                    T tr = vReal[b] * wr - vImag[b] * wi;
+                    T ti = vReal[b] * wi + vImag[b] * wr;
+                    vReal[b] = vReal[a] - tr;
+                    vImag[b] = vImag[a] - ti;
+                    vReal[a] += tr;
+                    vImag[a] += ti;
+                }
+            }
+        }
+    }
+
+    void complexToMagnitude(T* vReal, T* vImag, uint_fast16_t samples) {
+        for (uint_fast16_t i = 0; i < samples; i++) {
+            vReal[i] = std::sqrt(vReal[i] * vReal[i] + vImag[i] * vImag[i]);
+        }
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+// ESP-NOW is never up on the host: every call fails, and simulated nodes
+// are handed a SimRadio instead
+#include <cstdint>
+#include <cstddef>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum {
+    ESP_NOW_SEND_SUCCESS = 0,
+    ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+typedef struct {
+    uint8_t peer_addr[6];
+    uint8_t channel;
+    bool encrypt;
+} esp_now_peer_info_t;
+
+typedef void (*esp_now_recv_cb_t)(const uint8_t* mac, const uint8_t* data, int len);
+typedef void (*esp_now_send_cb_t)(const uint8_t* mac, esp_now_send_status_t status);
+
+inline esp_err_t esp_now_init() { return ESP_FAIL; }
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t) { return ESP_FAIL; }
+inline esp_err_t esp_now_register_send_cb(esp_now_send_cb_t) { return ESP_FAIL; }
+inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t*) { return ESP_FAIL; }
+inline esp_err_t esp_now_del_peer(const uint8_t*) { return ESP_FAIL; }
+inline esp_err_t esp_now_send(const uint8_t*, const uint8_t*, size_t) { return ESP_FAIL; }
@@ -0,0 +1,4 @@
+#pragma once
+#include "HostSim.h"
+
+inline int64_t esp_timer_get_time() { return host::nowMicros; }
@@ -0,0 +1,10 @@
+#pragma once
+#include "HostSim.h"
+#include "freertos/FreeRTOS.h"
+
+// There is one (simulator) task; nothing is ever notified or woken. A delay
+// hands control back to the simulator so simulated time moves on.
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline void vTaskDelay(TickType_t ticks) { if (host::delayHook) host::delayHook(ticks * portTICK_PERIOD_MS); }
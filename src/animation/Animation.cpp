@@ -10,6 +10,15 @@ AnimationParameter* Animation::findParameter(const std::string& paramName) {
     return nullptr;
 }
 
+AnimationParameter* Animation::findParameter(uint32_t id) {
+    for (auto& param : parameters) {
+        if (param.id == id) {
+            return &param;
+        }
+    }
+    return nullptr;
+}
+
 bool Animation::setParam(const std::string& paramName, int value) {
     AnimationParameter* param = findParameter(paramName);
     if (!param) return false;
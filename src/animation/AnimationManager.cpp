@@ -1,9 +1,11 @@
 #include "animation/AnimationManager.h"
 #include "animation/AnimationPresets.h"
+#include "audio/AudioAnalyzer.h"
+#include "system/Hash.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 
-AnimationManager::AnimationManager(LedController& ctrl) : controller(ctrl), currentAnimation(nullptr), powerState(true), devicePhase(0.0f) {
+AnimationManager::AnimationManager(LedController& ctrl) : controller(ctrl), currentAnimation(nullptr), powerState(true), devicePhase(0.0f), replaySource(SAMPLING_FREQ) {
     if (!LittleFS.begin(true)) {
         // Serial.println("LittleFS Mount Failed");
         // Handle error?
@@ -112,6 +114,17 @@ void AnimationManager::loadPresets() {
                              p.name = name;
                              p.baseType = baseType;
                              p.filePath = (String("/presets/") + file.name()).c_str();
+
+                             // Hash the same canonical form getPresetData() sends over the mesh
+                             std::string paramsJson;
+                             if (doc.containsKey("params")) serializeJson(doc["params"], paramsJson);
+                             else paramsJson = "{}";
+                             p.contentHash = fnv1a32(name);
+                             p.contentHash = fnv1a32((const uint8_t*)"", 1, p.contentHash);
+                             p.contentHash = fnv1a32(baseType, p.contentHash);
+                             p.contentHash = fnv1a32((const uint8_t*)"", 1, p.contentHash);
+                             p.contentHash = fnv1a32((const uint8_t*)paramsJson.data(), paramsJson.length(), p.contentHash);
+
                              presets.push_back(p);
                          }
                      }
@@ -368,6 +381,15 @@ std::vector<std::string> AnimationManager::getPresetNames() const {
     return names;
 }
 
+std::vector<AnimationManager::PresetDigestEntry> AnimationManager::getPresetDigests() const {
+    std::vector<PresetDigestEntry> entries;
+    entries.reserve(presets.size());
+    for (const auto& p : presets) {
+        entries.push_back({p.name, p.contentHash});
+    }
+    return entries;
+}
+
 std::vector<std::string> AnimationManager::getBaseAnimationNames() const {
     std::vector<std::string> names;
     for (auto const& kv : baseAnimations) {
@@ -377,18 +399,32 @@ std::vector<std::string> AnimationManager::getBaseAnimationNames() const {
 }
 
 
+void AnimationManager::renderFrame(uint32_t epoch, CRGB* leds, int numLeds) {
+    processAudioRequests();
+
+    if (!currentAnimation || !powerState) {
+        fill_solid(leds, numLeds, CRGB::Black);
+        return;
+    }
+
+    currentAnimation->setDevicePhase(devicePhase);
+    currentAnimation->render(epoch, leds, numLeds);
+    
+    // Apply Animation Brightness
+    uint8_t animBrightness = currentAnimation->getBrightness();
+    if (animBrightness < 255) {
+         nscale8_video(leds, numLeds, animBrightness);
+    }
+
+    if (frameOverlay) frameOverlay(epoch, leds, numLeds);
+}
+
 void AnimationManager::update(uint32_t epoch, float phase) {
+    processAudioRequests();
+
     if (currentAnimation && !controller.isOtaInProgress()) {
         if (powerState) {
-            currentAnimation->setDevicePhase(devicePhase);
-            currentAnimation->render(epoch, controller.getLeds(), controller.getNumLeds());
-            
-            // Apply Animation Brightness
-            uint8_t animBrightness = currentAnimation->getBrightness();
-            if (animBrightness < 255) {
-                 nscale8_video(controller.getLeds(), controller.getNumLeds(), animBrightness);
-            }
-
+            renderFrame(epoch, controller.getLeds(), controller.getNumLeds());
             controller.render();
         } else {
             controller.clear();
@@ -444,3 +480,110 @@ void AnimationManager::saveLastPreset() {
         f.close();
     }
 }
+
+// ==========================================
+// AUDIO REPLAY / BENCHMARK
+// ==========================================
+
+void AnimationManager::startAudioReplay(const std::string& path, bool realtime, bool loop) {
+    std::lock_guard<std::mutex> lock(audioRequestMutex);
+    pendingReplay.path = path;
+    pendingReplay.realtime = realtime;
+    pendingReplay.loop = loop;
+    pendingReplay.stop = false;
+    pendingReplay.pending = true;
+}
+
+void AnimationManager::stopAudioReplay() {
+    std::lock_guard<std::mutex> lock(audioRequestMutex);
+    pendingReplay.stop = true;
+    pendingReplay.pending = true;
+}
+
+void AnimationManager::requestAudioBenchmark(const std::string& path) {
+    std::lock_guard<std::mutex> lock(audioRequestMutex);
+    pendingBenchmark.path = path;
+    pendingBenchmark.pending = true;
+}
+
+bool AnimationManager::isAudioBenchmarkPending() const {
+    std::lock_guard<std::mutex> lock(audioRequestMutex);
+    return pendingBenchmark.pending || benchmarkRunning;
+}
+
+AudioBenchmark::Result AnimationManager::getAudioBenchmarkResult() const {
+    std::lock_guard<std::mutex> lock(audioRequestMutex);
+    return lastBenchmark;
+}
+
+void AnimationManager::processAudioRequests() {
+    AudioAnalyzer& analyzer = AudioAnalyzer::shared();
+
+    // Take the requests as they stand; file work happens outside the lock
+    PendingReplay replay;
+    PendingBenchmark bench;
+    {
+        std::lock_guard<std::mutex> lock(audioRequestMutex);
+        replay = pendingReplay;
+        pendingReplay.pending = false;
+        bench = pendingBenchmark;
+        pendingBenchmark.pending = false;
+        // Counts as running from here, so isAudioBenchmarkPending() never sees a gap
+        if (bench.pending) benchmarkRunning = true;
+    }
+
+    if (replay.pending) {
+        analyzer.setSource(nullptr);
+        replaySource.close();
+        audioReplayActive = false;
+
+        if (!replay.stop && replaySource.open(replay.path.c_str(), replay.realtime, replay.loop)) {
+            analyzer.setSource(&replaySource);
+            audioReplayActive = true;
+        }
+    }
+
+    // A non-looping replay that hit EOF hands back to the microphone
+    if (audioReplayActive && !replaySource.isOpen()) {
+        analyzer.setSource(nullptr);
+        audioReplayActive = false;
+    }
+
+    if (bench.pending) {
+        Serial.printf("Audio: Running benchmark on '%s'\r\n", bench.path.c_str());
+        if (benchmark.start(bench.path.c_str(), cloneCurrentAnimation(), controller.getNumLeds())) {
+            benchmarkProgress = 0.0f;
+        } else {
+            std::lock_guard<std::mutex> lock(audioRequestMutex);
+            lastBenchmark = benchmark.getResult();
+            benchmarkRunning = false;
+        }
+    }
+
+    // A slice at a time, so the strip keeps animating while it runs
+    if (benchmarkRunning) {
+        if (benchmark.step()) {
+            benchmarkProgress = benchmark.getProgress();
+        } else {
+            std::lock_guard<std::mutex> lock(audioRequestMutex);
+            lastBenchmark = benchmark.getResult();
+            benchmarkProgress = 1.0f;
+            benchmarkRunning = false;
+        }
+    }
+}
+
+Animation* AnimationManager::cloneCurrentAnimation() const {
+    if (!currentAnimation) return nullptr;
+
+    Animation* clone = AnimationPresets::createAnimation(currentAnimation->getTypeName());
+    if (!clone) return nullptr;
+
+    // Same params as the live effect, through the same path a preset takes
+    DynamicJsonDocument doc(2048);
+    JsonObject params = doc.to<JsonObject>();
+    currentAnimation->serializeParameters(params);
+    clone->deserializeParameters(params);
+    clone->setDevicePhase(devicePhase);
+    return clone;
+}
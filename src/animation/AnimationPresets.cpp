@@ -15,24 +15,49 @@
 #include "animation/user_animations/BouncingBallAnimation.h"
 #include "animation/user_animations/FrequencySpectrumAnimation.h"
 #include "animation/user_animations/ReferenceAudioAnimation.h"
+#include "animation/user_animations/SpectrumWaterfallAnimation.h"
 
 // Define internal resources locally
+namespace {
+
+template <typename T>
+Animation* make() { return new T(); }
+
+// Every base type, in registration order
+Animation* (*const factories[])() = {
+    make<AudioWaveAnimation>,
+    make<KickReactionAnimation>,
+    make<LineAnimation>,
+    make<BreathingAnimation>,
+    make<FireAnimation>,
+    make<AuroraAnimation>,
+    make<StarryNightAnimation>,
+    make<SinusoidalLinesAnimation>,
+    make<BouncingBallAnimation>,
+    make<FrequencySpectrumAnimation>,
+    make<ReferenceAudioAnimation>,
+    make<SpectrumWaterfallAnimation>,
+};
+
+} // namespace
+
 void AnimationPresets::createAnimations(AnimationManager& manager) {
     // 1. Register Base Animations
     // The names are now hardcoded in the animation classes
-    
-    manager.registerBaseAnimation(new AudioWaveAnimation());
-    manager.registerBaseAnimation(new KickReactionAnimation());
-    manager.registerBaseAnimation(new LineAnimation());
-    manager.registerBaseAnimation(new BreathingAnimation());
-    manager.registerBaseAnimation(new FireAnimation());
-    manager.registerBaseAnimation(new AuroraAnimation());
-    manager.registerBaseAnimation(new StarryNightAnimation());
-    manager.registerBaseAnimation(new SinusoidalLinesAnimation());
-    manager.registerBaseAnimation(new BouncingBallAnimation());
-    manager.registerBaseAnimation(new FrequencySpectrumAnimation());
-    manager.registerBaseAnimation(new ReferenceAudioAnimation());
+    for (auto factory : factories) {
+        manager.registerBaseAnimation(factory());
+    }
 
     // 2. Load existing presets
     manager.loadPresets();
 }
+
+Animation* AnimationPresets::createAnimation(const std::string& typeName) {
+    // The type name lives in the class, so build and compare; constructors are cheap
+    for (auto factory : factories) {
+        Animation* anim = factory();
+        if (anim->getTypeName() == typeName) return anim;
+        delete anim;
+    }
+    return nullptr;
+}
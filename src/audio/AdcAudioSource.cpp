@@ -0,0 +1,23 @@
+#include "audio/AdcAudioSource.h"
+#include <Arduino.h>
+
+AdcAudioSource::AdcAudioSource(int pin, uint32_t sampleRate)
+    : pin(pin), sampleRate(sampleRate), configured(false) {}
+
+int AdcAudioSource::readSamples(float* out, int count) {
+    if (!configured) {
+        // Note: These hardware settings are global.
+        analogSetPinAttenuation(pin, ADC_11db);
+        analogReadResolution(12);
+        configured = true;
+    }
+
+    unsigned long samplingPeriod = 1000000 / sampleRate;
+
+    for (int i = 0; i < count; i++) {
+        unsigned long t = micros();
+        out[i] = analogRead(pin) - 2048;
+        while (micros() - t < samplingPeriod);
+    }
+    return count;
+}
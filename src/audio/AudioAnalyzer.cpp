@@ -0,0 +1,178 @@
+#include "audio/AudioAnalyzer.h"
+#include <Arduino.h>
+
+// Bass band used for beat detection
+static const float BEAT_MAX_FREQ = 200.0f;
+static const float BEAT_RATIO = 1.6f;        // vs running average
+static const float BEAT_MIN_ENERGY = 20000.0f;
+static const unsigned long BEAT_HOLDOFF_MS = 150;
+
+AudioAnalyzer* AudioAnalyzer::bound = nullptr;
+
+AudioAnalyzer& AudioAnalyzer::shared() {
+    static AudioAnalyzer analyzer;
+    return analyzer;
+}
+
+AudioAnalyzer::AudioAnalyzer()
+    : FFT(vReal, vImag, SAMPLES, SAMPLING_FREQ, false),
+      micSource(MIC_PIN, SAMPLING_FREQ),
+      source(&micSource),
+      lastAnalysisMicros(0),
+      frameCount(0),
+      beat(false),
+      bassAverage(0.0f),
+      lastBeatTime(0),
+      spectrogramHead(SPECTROGRAM_ROWS - 1),
+      spectrogramDepth(0),
+      lastRemoteTime(0) {
+    for (int i = 0; i < SAMPLES; i++) {
+        window[i] = 0;
+        vReal[i] = 0;
+        vImag[i] = 0;
+    }
+    remoteReady = xSemaphoreCreateBinary();
+    updateMutex = xSemaphoreCreateMutex();
+}
+
+AudioAnalyzer::~AudioAnalyzer() {
+    if (bound == this) bound = nullptr;
+    vSemaphoreDelete(remoteReady);
+    vSemaphoreDelete(updateMutex);
+}
+
+void AudioAnalyzer::setSource(AudioSource* src) {
+    source = src ? src : &micSource;
+}
+
+bool AudioAnalyzer::update() {
+    xSemaphoreTake(updateMutex, portMAX_DELAY);
+    bool ok = analyseNext();
+    xSemaphoreGive(updateMutex);
+    return ok;
+}
+
+bool AudioAnalyzer::analyseNext() {
+    // Mic-less nodes: render in lockstep with the ear's frames
+    if (isRemoteFed()) {
+        if (takeRemoteFrame()) {
+            pushSpectrogramRow();
+            frameCount++;
+            return true;
+        }
+        // Ear went quiet mid-wait; fall through to the local source
+    }
+
+    // Slide the window along by one hop
+    memmove(window, window + AUDIO_HOP, (SAMPLES - AUDIO_HOP) * sizeof(float));
+    float* hop = window + (SAMPLES - AUDIO_HOP);
+    int got = source->readSamples(hop, AUDIO_HOP);
+    if (got <= 0) return false;
+
+    // Zero-pad a short final hop
+    for (int i = got; i < AUDIO_HOP; i++) hop[i] = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        vReal[i] = window[i];
+        vImag[i] = 0;
+    }
+
+    unsigned long t = micros();
+    FFT.windowing(vReal, SAMPLES, FFT_WIN_TYP_HAMMING, FFT_FORWARD);
+    FFT.compute(vReal, vImag, SAMPLES, FFT_FORWARD);
+    FFT.complexToMagnitude(vReal, vImag, SAMPLES);
+    lastAnalysisMicros = micros() - t;
+
+    detectBeat();
+    pushSpectrogramRow();
+    frameCount++;
+
+    if (frameListener) {
+        AudioFeatures features;
+        buildFeatures(features);
+        frameListener(features);
+    }
+    return true;
+}
+
+float AudioAnalyzer::getEnergy(float minFreq, float maxFreq) const {
+    float energy = 0.0f;
+    for (int i = 1; i < SAMPLES / 2; i++) {
+        float freq = (i * SAMPLING_FREQ) / SAMPLES;
+        if (freq >= minFreq && freq <= maxFreq) {
+            energy += vReal[i];
+        }
+    }
+    return energy;
+}
+
+void AudioAnalyzer::detectBeat() {
+    float bass = getEnergy(0.0f, BEAT_MAX_FREQ);
+    unsigned long now = millis();
+
+    beat = bass > BEAT_MIN_ENERGY &&
+           bass > bassAverage * BEAT_RATIO &&
+           now - lastBeatTime > BEAT_HOLDOFF_MS;
+    if (beat) lastBeatTime = now;
+
+    bassAverage = bassAverage * 0.9f + bass * 0.1f;
+}
+
+void AudioAnalyzer::pushSpectrogramRow() {
+    // Overwrite the oldest row in place
+    spectrogramHead = (spectrogramHead + 1) & (SPECTROGRAM_ROWS - 1);
+    uint8_t* row = spectrogram[spectrogramHead];
+    for (int i = 0; i < SPECTROGRAM_BINS; i++) {
+        row[i] = encodeLogMagnitude(vReal[i]);
+    }
+    if (spectrogramDepth < SPECTROGRAM_ROWS) spectrogramDepth++;
+}
+
+void AudioAnalyzer::buildFeatures(AudioFeatures& out) const {
+    for (int b = 0; b < AUDIO_FEATURE_BANDS; b++) {
+        float sum = 0.0f;
+        // Bin 0 is DC and never part of an energy sum
+        for (int i = (b == 0 ? 1 : 0); i < AUDIO_BINS_PER_BAND; i++) {
+            sum += vReal[b * AUDIO_BINS_PER_BAND + i];
+        }
+        out.bands[b] = encodeLogMagnitude(sum);
+    }
+    out.beat = beat;
+}
+
+void AudioAnalyzer::injectRemoteFeatures(const AudioFeatures& features) {
+    portENTER_CRITICAL(&remoteMux);
+    remoteFeatures = features;
+    lastRemoteTime = millis();
+    portEXIT_CRITICAL(&remoteMux);
+    xSemaphoreGive(remoteReady);
+}
+
+bool AudioAnalyzer::isRemoteFed() const {
+    unsigned long last = lastRemoteTime;
+    return last != 0 && millis() - last < REMOTE_TIMEOUT_MS;
+}
+
+bool AudioAnalyzer::takeRemoteFrame() {
+    // Block like the ADC would, but only until the next frame or the timeout
+    if (xSemaphoreTake(remoteReady, pdMS_TO_TICKS(REMOTE_TIMEOUT_MS)) != pdTRUE) {
+        return false;
+    }
+
+    AudioFeatures features;
+    portENTER_CRITICAL(&remoteMux);
+    features = remoteFeatures;
+    portEXIT_CRITICAL(&remoteMux);
+
+    // Spread each band evenly over its bins so getEnergy()/getMagnitude() keep working
+    for (int b = 0; b < AUDIO_FEATURE_BANDS; b++) {
+        int first = (b == 0 ? 1 : 0);
+        float perBin = decodeLogMagnitude(features.bands[b]) / (AUDIO_BINS_PER_BAND - first);
+        for (int i = first; i < AUDIO_BINS_PER_BAND; i++) {
+            vReal[b * AUDIO_BINS_PER_BAND + i] = perBin;
+        }
+    }
+    vReal[0] = 0;
+    beat = features.beat;
+    lastAnalysisMicros = 0;
+    return true;
+}
@@ -0,0 +1,197 @@
+#include "audio/AudioBenchmark.h"
+#include "audio/AudioAnalyzer.h"
+#include "animation/Animation.h"
+#include <Arduino.h>
+
+// Passes samples through to the analyzer while running a simple energy
+// onset detector on the raw PCM, which serves as ground truth for kicks.
+class AudioBenchmark::OnsetTapSource : public AudioSource {
+public:
+    OnsetTapSource(AudioSource& inner) : inner(inner) {}
+
+    int readSamples(float* out, int count) override {
+        int got = inner.readSamples(out, count);
+        uint32_t holdoff = (AudioBenchmark::ONSET_HOLDOFF_MS * getSampleRate()) / 1000;
+
+        for (int i = 0; i < got; i++) {
+            blockEnergy += out[i] * out[i];
+            if (++blockFill < AudioBenchmark::ONSET_BLOCK) continue;
+
+            // Kick = block energy jumps well above the recent average
+            uint32_t blockStart = samplesSeen + i + 1 - AudioBenchmark::ONSET_BLOCK;
+            if (avgEnergy > 0.0f &&
+                blockEnergy > avgEnergy * AudioBenchmark::ONSET_RATIO &&
+                (onsets.empty() || blockStart - onsets.back() > holdoff)) {
+                onsets.push_back(blockStart);
+            }
+            avgEnergy = avgEnergy * 0.95f + blockEnergy * 0.05f;
+            blockEnergy = 0.0f;
+            blockFill = 0;
+        }
+        samplesSeen += got;
+        return got;
+    }
+
+    uint32_t getSampleRate() const override { return inner.getSampleRate(); }
+
+    std::vector<uint32_t> onsets; // sample positions
+    uint32_t samplesSeen = 0;
+
+private:
+    AudioSource& inner;
+    float blockEnergy = 0.0f;
+    float avgEnergy = 0.0f;
+    int blockFill = 0;
+};
+
+namespace {
+
+uint8_t averageLight(const CRGB* leds, int numLeds) {
+    uint32_t sum = 0;
+    for (int i = 0; i < numLeds; i++) {
+        sum += leds[i].getAverageLight();
+    }
+    return numLeds > 0 ? sum / numLeds : 0;
+}
+
+} // namespace
+
+AudioBenchmark::AudioBenchmark() : wav(SAMPLING_FREQ) {}
+
+AudioBenchmark::~AudioBenchmark() {
+    release();
+}
+
+bool AudioBenchmark::start(const char* wavPath, Animation* anim, int numLeds) {
+    release();
+    result = Result();
+    this->anim = anim; // Owned from here on, released with the rest
+
+    if (!anim || numLeds <= 0) {
+        result.error = "No animation";
+        release();
+        return false;
+    }
+    if (!wav.open(wavPath, false, false)) {
+        result.error = "Cannot open WAV";
+        release();
+        return false;
+    }
+
+    // Its own analyzer: no frame listener, never remote-fed, so the replay
+    // doesn't reach the mesh and a mic-less node still measures itself
+    tap = new OnsetTapSource(wav);
+    analyzer = new AudioAnalyzer();
+    analyzer->setSource(tap);
+
+    path = wavPath;
+    leds.assign(numLeds, CRGB::Black);
+    lastLight = 0;
+    responses.clear();
+    totalAnalysis = 0;
+    totalRender = 0;
+    running = true;
+    return true;
+}
+
+bool AudioBenchmark::step() {
+    if (!running) return false;
+
+    // The effect reads whichever analyzer is bound while it renders
+    AudioAnalyzer::bind(analyzer);
+    unsigned long sliceStart = micros();
+    bool more;
+    do {
+        more = renderFrame();
+    } while (more && micros() - sliceStart < SLICE_MICROS);
+    AudioAnalyzer::bind(nullptr);
+
+    if (!more) finish();
+    return more;
+}
+
+float AudioBenchmark::getProgress() const {
+    return running ? wav.getProgress() : 0.0f;
+}
+
+bool AudioBenchmark::renderFrame() {
+    int numLeds = leds.size();
+
+    // render() pulls the next frame through the analyzer itself
+    unsigned long t = micros();
+    uint32_t framesBefore = analyzer->getFrameCount();
+    anim->render(result.frames, leds.data(), numLeds);
+    uint32_t elapsed = micros() - t;
+
+    if (analyzer->getFrameCount() == framesBefore) return false; // end of file
+
+    uint32_t analysis = analyzer->getLastAnalysisMicros();
+    uint32_t render = elapsed > analysis ? elapsed - analysis : 0;
+    totalAnalysis += analysis;
+    totalRender += render;
+    if (analysis > result.maxAnalysisMicros) result.maxAnalysisMicros = analysis;
+    if (render > result.maxRenderMicros) result.maxRenderMicros = render;
+    result.frames++;
+
+    uint8_t light = averageLight(leds.data(), numLeds);
+    if (light >= lastLight + RESPONSE_DELTA) {
+        responses.push_back({tap->samplesSeen, elapsed});
+    }
+    lastLight = light;
+    return true;
+}
+
+void AudioBenchmark::finish() {
+    running = false;
+
+    if (result.frames == 0) {
+        result.error = "No audio frames (empty WAV or animation is not audio reactive)";
+        release();
+        return;
+    }
+
+    result.avgAnalysisMicros = totalAnalysis / result.frames;
+    result.avgRenderMicros = totalRender / result.frames;
+
+    // Pair each kick with the first LED attack that follows it.
+    // Latency = audio still buffering when the kick happened + processing.
+    uint32_t window = (RESPONSE_WINDOW_MS * SAMPLING_FREQ) / 1000;
+    float latencySum = 0.0f;
+    size_t r = 0;
+    result.kicks = tap->onsets.size();
+    for (uint32_t onset : tap->onsets) {
+        while (r < responses.size() && responses[r].sample <= onset) r++;
+        if (r >= responses.size()) break;
+        if (responses[r].sample - onset > window) continue;
+
+        float latencyMs = (responses[r].sample - onset) * 1000.0f / SAMPLING_FREQ
+                          + responses[r].micros / 1000.0f;
+        latencySum += latencyMs;
+        if (latencyMs > result.maxLatencyMs) result.maxLatencyMs = latencyMs;
+        result.responses++;
+        r++;
+    }
+    if (result.responses > 0) {
+        result.avgLatencyMs = latencySum / result.responses;
+    }
+
+    result.ok = true;
+    Serial.printf("Audio: Benchmark '%s' frames=%lu fft=%luus(max %lu) render=%luus kicks=%lu hit=%lu latency=%.1fms(max %.1f)\r\n",
+                  path.c_str(), result.frames, result.avgAnalysisMicros, result.maxAnalysisMicros,
+                  result.avgRenderMicros, result.kicks, result.responses,
+                  result.avgLatencyMs, result.maxLatencyMs);
+    release();
+}
+
+void AudioBenchmark::release() {
+    running = false;
+    delete analyzer;
+    analyzer = nullptr;
+    delete tap;
+    tap = nullptr;
+    wav.close();
+    delete anim;
+    anim = nullptr;
+    std::vector<CRGB>().swap(leds);
+    std::vector<Response>().swap(responses);
+}
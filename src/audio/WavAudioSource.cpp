@@ -0,0 +1,160 @@
+#include "audio/WavAudioSource.h"
+#include <Arduino.h>
+
+WavAudioSource::WavAudioSource(uint32_t targetRate)
+    : targetRate(targetRate), realtime(true), loop(false),
+      fileRate(0), channels(0), bitsPerSample(0),
+      dataStart(0), dataSize(0), dataRead(0),
+      step(1.0f), frac(0.0f), prevSample(0.0f), nextSample(0.0f),
+      position(0), startMicros(0) {}
+
+WavAudioSource::~WavAudioSource() {
+    close();
+}
+
+bool WavAudioSource::open(const char* path, bool realtime, bool loop) {
+    close();
+
+    file = LittleFS.open(path, FILE_READ);
+    if (!file) {
+        Serial.printf("Audio: Failed to open WAV '%s'\r\n", path);
+        return false;
+    }
+
+    if (!readHeader()) {
+        Serial.printf("Audio: Unsupported WAV '%s'\r\n", path);
+        close();
+        return false;
+    }
+
+    this->realtime = realtime;
+    this->loop = loop;
+    step = (float)fileRate / (float)targetRate;
+    frac = 0.0f;
+    dataRead = 0;
+    position = 0;
+    startMicros = micros();
+
+    // Prime the interpolator
+    prevSample = 0.0f;
+    nextSample = 0.0f;
+    readFrame(prevSample);
+    readFrame(nextSample);
+
+    Serial.printf("Audio: WAV '%s' %luHz %u-bit %uch, %lu bytes\r\n",
+                  path, fileRate, bitsPerSample, channels, dataSize);
+    return true;
+}
+
+void WavAudioSource::close() {
+    if (file) {
+        file.close();
+    }
+}
+
+bool WavAudioSource::readHeader() {
+    uint8_t riff[12];
+    if (file.read(riff, 12) != 12) return false;
+    if (memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) return false;
+
+    bool haveFormat = false;
+    uint8_t chunkHeader[8];
+    while (file.read(chunkHeader, 8) == 8) {
+        uint32_t chunkSize;
+        memcpy(&chunkSize, chunkHeader + 4, sizeof(uint32_t));
+
+        if (memcmp(chunkHeader, "fmt ", 4) == 0) {
+            uint8_t fmt[16];
+            if (chunkSize < 16 || file.read(fmt, 16) != 16) return false;
+
+            uint16_t audioFormat;
+            memcpy(&audioFormat, fmt, 2);
+            memcpy(&channels, fmt + 2, 2);
+            memcpy(&fileRate, fmt + 4, 4);
+            memcpy(&bitsPerSample, fmt + 14, 2);
+
+            // Skip any extension bytes
+            if (!file.seek(file.position() + (chunkSize - 16) + (chunkSize & 1))) return false;
+
+            if (audioFormat != 1) return false; // PCM only
+            if (channels < 1 || channels > 2) return false;
+            if (bitsPerSample != 8 && bitsPerSample != 16) return false;
+            if (fileRate == 0) return false;
+            haveFormat = true;
+        } else if (memcmp(chunkHeader, "data", 4) == 0) {
+            if (!haveFormat) return false;
+            dataStart = file.position();
+            dataSize = chunkSize;
+            return true;
+        } else {
+            if (!file.seek(file.position() + chunkSize + (chunkSize & 1))) return false;
+        }
+    }
+    return false;
+}
+
+bool WavAudioSource::readFrame(float& sample) {
+    uint32_t frameBytes = channels * (bitsPerSample / 8);
+
+    if (dataRead + frameBytes > dataSize) {
+        if (!loop) return false;
+        if (!file.seek(dataStart)) return false;
+        dataRead = 0;
+    }
+
+    uint8_t raw[4];
+    if (file.read(raw, frameBytes) != frameBytes) return false;
+    dataRead += frameBytes;
+
+    // Mix down and scale to the +/-2048 range of the 12-bit ADC
+    float sum = 0.0f;
+    for (int c = 0; c < channels; c++) {
+        if (bitsPerSample == 16) {
+            int16_t s;
+            memcpy(&s, raw + c * 2, 2);
+            sum += s / 16.0f;
+        } else {
+            sum += ((int)raw[c] - 128) * 16.0f;
+        }
+    }
+    sample = sum / channels;
+    return true;
+}
+
+int WavAudioSource::readSamples(float* out, int count) {
+    if (!file) return 0;
+
+    int produced = 0;
+    while (produced < count) {
+        // Advance the input until 'frac' sits between prev and next
+        bool exhausted = false;
+        while (frac >= 1.0f) {
+            prevSample = nextSample;
+            if (!readFrame(nextSample)) {
+                exhausted = true;
+                break;
+            }
+            frac -= 1.0f;
+        }
+        if (exhausted) break;
+
+        out[produced++] = prevSample + (nextSample - prevSample) * frac;
+        frac += step;
+    }
+
+    position += produced;
+
+    if (produced == 0) {
+        // End of a non-looping file
+        close();
+        return 0;
+    }
+
+    if (realtime) {
+        // Pace to wall-clock so effects see the same timing as the microphone
+        unsigned long due = startMicros + (unsigned long)((uint64_t)position * 1000000ULL / targetRate);
+        while ((long)(due - micros()) > 0);
+    }
+
+    return produced;
+}
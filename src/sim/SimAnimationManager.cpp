@@ -0,0 +1,17 @@
+// The simulated nodes run the mesh on its own: no AnimationManager is ever
+// attached, so none of these are reached. They only let MeshNetworkManager
+// link without the effect library and LittleFS, and behave like a node with
+// no presets, no effect and the power off.
+#include "animation/AnimationManager.h"
+
+bool AnimationManager::savePresetFromData(const std::string&, const std::string&, const std::string&) { return false; }
+bool AnimationManager::getPresetData(const std::string&, std::string&, std::string&) { return false; }
+bool AnimationManager::renamePreset(const std::string&, const std::string&) { return false; }
+bool AnimationManager::deletePreset(const std::string&) { return false; }
+bool AnimationManager::exists(const std::string&) const { return false; }
+void AnimationManager::setAnimation(const std::string&) {}
+std::string AnimationManager::getCurrentAnimationName() const { return std::string(); }
+std::vector<AnimationManager::PresetDigestEntry> AnimationManager::getPresetDigests() const { return {}; }
+Animation* AnimationManager::getCurrentAnimation() { return nullptr; }
+void AnimationManager::setPower(bool) {}
+bool AnimationManager::getPower() const { return false; }
@@ -0,0 +1,167 @@
+#include "sim/SimMedium.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <cmath>
+
+// Log-distance path loss, only for the RSSI handed to the mesh
+static const float RSSI_AT_1M = -40.0f;
+static const float PATH_LOSS_EXPONENT = 2.7f;
+
+int64_t SimClock::micros() const {
+    int64_t elapsed = host::nowMicros - bootMicros;
+    return elapsed + (int64_t)((double)elapsed * driftPpm * 1e-6);
+}
+
+// ==========================================
+// RADIO
+// ==========================================
+
+SimRadio::SimRadio(SimMedium& medium, int index, float x, float y)
+    : medium(medium), index(index), x(x), y(y) {}
+
+void SimRadio::macAddress(uint8_t* mac) const {
+    // Locally administered, one per node
+    uint32_t n = index + 1;
+    mac[0] = 0x02;
+    mac[1] = 0x00;
+    mac[2] = n >> 24;
+    mac[3] = n >> 16;
+    mac[4] = n >> 8;
+    mac[5] = n;
+}
+
+bool SimRadio::addPeer(const uint8_t* mac) {
+    uint64_t id = SimMedium::macToId(mac);
+    if (std::find(peers.begin(), peers.end(), id) != peers.end()) return true;
+    if (peers.size() >= MAX_PEERS) return false;
+    peers.push_back(id);
+    return true;
+}
+
+void SimRadio::removePeer(const uint8_t* mac) {
+    uint64_t id = SimMedium::macToId(mac);
+    peers.erase(std::remove(peers.begin(), peers.end(), id), peers.end());
+}
+
+bool SimRadio::send(const uint8_t* mac, const uint8_t* data, size_t len) {
+    if (!enabled || len > MESH_RADIO_MAX_FRAME) return false;
+    if (mac && std::find(peers.begin(), peers.end(), SimMedium::macToId(mac)) == peers.end()) return false;
+    return medium.transmit(*this, mac, data, len);
+}
+
+// ==========================================
+// MEDIUM
+// ==========================================
+
+SimMedium::SimMedium(const SimMediumConfig& config, uint32_t seed)
+    : config(config), rng(seed) {}
+
+SimRadio& SimMedium::addRadio(float x, float y) {
+    radios.emplace_back(new SimRadio(*this, radios.size(), x, y));
+    return *radios.back();
+}
+
+uint64_t SimMedium::macToId(const uint8_t* mac) {
+    uint64_t id = 0;
+    for (int i = 0; i < 6; i++) id = (id << 8) | mac[i];
+    return id;
+}
+
+uint32_t SimMedium::airtime(size_t len) const {
+    return PHY_PREAMBLE_MICROS + (uint32_t)((len + MAC_OVERHEAD_BYTES) * 8 / config.bitrateMbps);
+}
+
+bool SimMedium::hears(const SimRadio& from, const SimRadio& to, int8_t& rssi) const {
+    if (!to.enabled) return false;
+    float distance = std::hypot(from.x - to.x, from.y - to.y);
+    if (distance > config.rangeMeters) return false;
+
+    float dbm = RSSI_AT_1M - 10.0f * PATH_LOSS_EXPONENT * std::log10(std::max(distance, 1.0f));
+    rssi = (int8_t)std::max(-100.0f, std::min(-1.0f, dbm)); // 0 would read as "unknown"
+    return true;
+}
+
+bool SimMedium::transmit(SimRadio& from, const uint8_t* mac, const uint8_t* data, size_t len) {
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> jitter(0, config.jitterMicros);
+
+    // Queued behind the radio's previous frame, as the ESP-NOW driver would
+    int64_t start = std::max(host::nowMicros, from.busyUntil);
+    uint32_t frameAir = airtime(len);
+    int64_t end = start + frameAir;
+    uint32_t used = frameAir;
+
+    if (!mac) {
+        // Broadcast: one transmission, each receiver in range gets it or not
+        for (auto& to : radios) {
+            int8_t rssi;
+            if (to.get() == &from || !hears(from, *to, rssi)) continue;
+            if (chance(rng) < config.lossRate) continue;
+            schedule({end + config.latencyMicros + jitter(rng), 0, false, to->index, from.index, true, true, rssi,
+                      std::vector<uint8_t>(data, data + len)});
+        }
+        schedule({end + config.latencyMicros, 0, true, from.index, from.index, true, true, 0, {}});
+    } else {
+        // Unicast: retried until an ACK comes back or the tries run out
+        uint64_t target = macToId(mac);
+        SimRadio* to = nullptr;
+        for (auto& radio : radios) {
+            uint8_t candidate[6];
+            radio->macAddress(candidate);
+            if (macToId(candidate) == target) to = radio.get();
+        }
+
+        int8_t rssi = 0;
+        bool inRange = to && to != &from && hears(from, *to, rssi);
+        bool delivered = false;
+        for (int attempt = 0; attempt < UNICAST_TRIES && !delivered; attempt++) {
+            if (attempt > 0) {
+                end += frameAir;
+                used += frameAir;
+            }
+            delivered = inRange && chance(rng) >= config.lossRate;
+        }
+        if (delivered) {
+            end += ACK_MICROS;
+            used += ACK_MICROS;
+            schedule({end + config.latencyMicros + jitter(rng), 0, false, to->index, from.index, false, true, rssi,
+                      std::vector<uint8_t>(data, data + len)});
+        }
+        schedule({end + config.latencyMicros, 0, true, from.index, from.index, false, delivered, 0,
+                  std::vector<uint8_t>(mac, mac + 6)});
+    }
+
+    from.busyUntil = end;
+    from.airtimeMicros += used;
+    from.framesSent++;
+    airtimeMicros += used;
+    return true;
+}
+
+void SimMedium::schedule(Event&& event) {
+    event.order = nextOrder++;
+    events.push(std::move(event));
+}
+
+void SimMedium::runUntil(int64_t until) {
+    while (!events.empty() && events.top().time <= until) {
+        Event event = events.top();
+        events.pop();
+        if (event.time > host::nowMicros) host::nowMicros = event.time;
+
+        SimRadio& radio = *radios[event.radio];
+        if (enterCallback) enterCallback(radio.index);
+
+        if (event.sent) {
+            // Completions carry the destination, as ESP-NOW's do
+            if (radio.sendCallback) radio.sendCallback(event.broadcast ? nullptr : event.data.data(), event.delivered);
+        } else {
+            // Switched off while the frame was in flight
+            if (!radio.enabled || !radio.receiveCallback) continue;
+            uint8_t mac[6];
+            radios[event.from]->macAddress(mac);
+            radio.receiveCallback(mac, event.data.data(), event.data.size(), event.rssi);
+        }
+    }
+    if (until > host::nowMicros) host::nowMicros = until;
+}
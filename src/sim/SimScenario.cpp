@@ -0,0 +1,393 @@
+#include "sim/SimScenario.h"
+#include "system/MeshNetworkManager.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct SimNode {
+    std::unique_ptr<LedController> leds;
+    std::unique_ptr<MeshNetworkManager> mesh;
+    std::unique_ptr<SimClock> clock;
+    SimRadio* radio;
+    std::string tag;
+    int group;
+    int64_t bootAt;
+    bool booted = false;
+    bool alive = true;
+    bool updating = false; // Inside update(): a delay() there blocks this node's task
+};
+
+struct Probe {
+    int64_t sentAt;
+    uint32_t fireAt;  // Network ms, as handed back by broadcastEvent
+    int master;
+    std::vector<bool> reached;
+};
+
+float percentile(std::vector<float>& values, float p) {
+    if (values.empty()) return 0.0f;
+    std::sort(values.begin(), values.end());
+    size_t i = (size_t)(p * (values.size() - 1) + 0.5f);
+    return values[i];
+}
+
+float mean(const std::vector<float>& values) {
+    if (values.empty()) return 0.0f;
+    double sum = 0.0;
+    for (float v : values) sum += v;
+    return (float)(sum / values.size());
+}
+
+// Runs one scenario; state that the delay hook re-enters lives here
+class Simulation {
+public:
+    Simulation(const SimScenario& scenario)
+        : scenario(scenario), medium(scenario.medium, scenario.seed) {}
+
+    SimReport run();
+
+private:
+    const SimScenario& scenario;
+    SimMedium medium;
+    std::vector<SimNode> nodes;
+    SimReport report;
+
+    int64_t convergedSince = -1;  // µs, -1 while not converged
+    int64_t failoverStart = -1;
+    uint32_t takeoversBefore = 0; // Counters as of the failover
+    uint32_t electionsBefore = 0;
+    int leaving = -1;             // Master handing over, until the group settles without it
+    int64_t nextSyncSample = 0;
+    int64_t nextProbe = 0;
+    std::unique_ptr<Probe> probe;
+    std::vector<float> syncErrors;
+    std::vector<float> propagation;
+    std::vector<CRGB> frame;
+
+    void setup();
+    void advance(int64_t until);
+    void tick();
+    void enter(int index);
+    int singleMaster() const;
+    void sampleSync(int master);
+    void checkProbe();
+    void closeProbe();
+    bool probeTarget(size_t index) const;
+    void streamFrame(SimNode& node);
+    void failover(int master);
+    void countLeadership(uint32_t& takeovers, uint32_t& elections) const;
+};
+
+void Simulation::setup() {
+    std::mt19937 rng(scenario.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (int i = 0; i < scenario.nodes; i++) {
+        float x, y;
+        if (scenario.lineSpacingMeters > 0.0f) {
+            x = i * scenario.lineSpacingMeters;
+            y = 0.0f;
+        } else {
+            x = unit(rng) * scenario.areaMeters;
+            y = unit(rng) * scenario.areaMeters;
+        }
+
+        SimNode node;
+        node.radio = &medium.addRadio(x, y);
+        node.bootAt = (int64_t)(unit(rng) * scenario.bootSpreadMs * 1000.0f);
+        double drift = (unit(rng) * 2.0f - 1.0f) * scenario.skewPpm;
+        node.clock.reset(new SimClock(node.bootAt, drift));
+        node.leds.reset(new LedController(SimRunner::LEDS));
+        node.mesh.reset(new MeshNetworkManager(*node.leds));
+        node.mesh->setRadio(node.radio, node.clock.get());
+        char tag[16];
+        snprintf(tag, sizeof(tag), "[n%02d]", i);
+        node.tag = tag;
+        node.group = i % scenario.groups;
+        nodes.push_back(std::move(node));
+    }
+
+    medium.setEnterCallback([this](int index) { enter(index); });
+    // A node that waits (a handover) lets everyone else run meanwhile
+    host::delayHook = [this](uint32_t ms) { advance(host::nowMicros + (int64_t)ms * 1000); };
+}
+
+void Simulation::enter(int index) {
+    host::serialTag = nodes[index].tag;
+}
+
+SimReport Simulation::run() {
+    host::nowMicros = 0;
+    host::serialEnabled = scenario.verbose;
+    randomSeed(scenario.seed);
+    setup();
+
+    advance((int64_t)scenario.durationMs * 1000);
+    if (probe) closeProbe();
+
+    host::delayHook = nullptr;
+    host::serialTag.clear();
+
+    int64_t end = host::nowMicros;
+    for (const auto& node : nodes) {
+        if (node.alive && node.mesh->isMaster()) report.masters++;
+    }
+
+    report.syncSamples = syncErrors.size();
+    report.syncMeanMicros = mean(syncErrors);
+    report.syncP95Micros = percentile(syncErrors, 0.95f);
+    report.syncMaxMicros = syncErrors.empty() ? 0.0f : syncErrors.back();
+
+    report.propagationMeanMs = mean(propagation);
+    report.propagationP95Ms = percentile(propagation, 0.95f);
+    report.propagationMaxMs = propagation.empty() ? 0.0f : propagation.back();
+
+    if (failoverStart >= 0) {
+        countLeadership(report.takeovers, report.elections);
+        report.takeovers -= takeoversBefore;
+        report.elections -= electionsBefore;
+    }
+
+    for (const auto& node : nodes) {
+        const MeshStats& stats = node.mesh->getStats();
+        report.relayed += stats.relayed.load();
+        report.relaySuppressed += stats.relaySuppressed.load();
+        report.duplicates += stats.duplicates.load();
+        // Only probes send events, and each reaches a node at most once
+        uint32_t events = stats.types[(uint8_t)MessageType::EVENT].rxPackets.load();
+        if (events > report.probes) report.eventCopies += events - report.probes;
+    }
+
+    report.airtimeMicros = medium.getAirtimeMicros();
+    report.channelUse = end > 0 ? (float)report.airtimeMicros / end : 0.0f;
+    for (size_t i = 0; i < medium.size(); i++) {
+        SimRadio& radio = medium.radio(i);
+        report.framesSent += radio.getFramesSent();
+        float use = end > 0 ? (float)radio.getAirtimeMicros() / end : 0.0f;
+        if (use > report.busiestNodeUse) report.busiestNodeUse = use;
+    }
+    return report;
+}
+
+void Simulation::advance(int64_t until) {
+    while (host::nowMicros < until) tick();
+}
+
+void Simulation::tick() {
+    int64_t now = host::nowMicros + SimRunner::TICK_MICROS;
+    medium.runUntil(now);
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        SimNode& node = nodes[i];
+        if (!node.alive || node.updating) continue;
+        enter(i);
+        node.updating = true;
+        if (!node.booted) {
+            if (now < node.bootAt) {
+                node.updating = false;
+                continue;
+            }
+            node.mesh->begin();
+            node.mesh->setGroupName(scenario.groups > 1 ? "room" + std::to_string(node.group) : "sim");
+            node.mesh->setRelay(scenario.relay);
+            node.mesh->setPixelStream(scenario.stream);
+            node.booted = true;
+        }
+        // Stands in for the mesh task, which wakes at least this often under load
+        node.mesh->update();
+        if (scenario.stream) streamFrame(node);
+        node.updating = false;
+    }
+    host::serialTag.clear();
+
+    // Everyone up, one master, the rest following it
+    int master = singleMaster();
+    if (master == leaving) master = -1; // Still leading while it hands over
+    if (master < 0) {
+        if (convergedSince >= 0) report.disruptions++;
+        convergedSince = -1;
+    } else if (convergedSince < 0) {
+        convergedSince = now;
+        if (report.convergenceMs < 0.0f) report.convergenceMs = now / 1000.0f;
+        if (leaving >= 0) {
+            report.failoverMs = (now - failoverStart) / 1000.0f;
+            leaving = -1;
+        }
+    }
+
+    if (master >= 0 && now >= nextSyncSample && now - convergedSince >= (int64_t)SimRunner::SYNC_SETTLE_MS * 1000) {
+        sampleSync(master);
+        nextSyncSample = now + (int64_t)SimRunner::SYNC_SAMPLE_MS * 1000;
+    }
+
+    if (probe) checkProbe();
+    if (!probe && master >= 0 && scenario.eventIntervalMs && now >= nextProbe &&
+        now - convergedSince >= (int64_t)SimRunner::SYNC_SETTLE_MS * 1000) {
+        probe.reset(new Probe());
+        probe->sentAt = now;
+        probe->master = master;
+        probe->reached.assign(nodes.size(), false);
+        enter(master);
+        probe->fireAt = nodes[master].mesh->broadcastEvent(MeshEventKind::FLASH, CRGB(255, 255, 255), 255, 1000);
+        host::serialTag.clear();
+        report.probes++;
+        nextProbe = now + (int64_t)scenario.eventIntervalMs * 1000;
+    }
+
+    if (scenario.failoverAtMs && failoverStart < 0 && now >= (int64_t)scenario.failoverAtMs * 1000 && master >= 0) {
+        failover(master);
+    }
+}
+
+int Simulation::singleMaster() const {
+    int master = -1;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const SimNode& node = nodes[i];
+        if (!node.alive) continue;
+        if (!node.booted) return -1;
+        if (node.mesh->isMaster()) {
+            if (master >= 0) return -1;
+            master = i;
+        } else if (!node.mesh->isSlave()) {
+            return -1;
+        }
+    }
+    return master;
+}
+
+void Simulation::sampleSync(int master) {
+    int64_t reference = nodes[master].mesh->getNetworkTimeMicros();
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if ((int)i == master || !nodes[i].alive) continue;
+        int64_t error = nodes[i].mesh->getNetworkTimeMicros() - reference;
+        syncErrors.push_back((float)(error < 0 ? -error : error));
+    }
+}
+
+void Simulation::checkProbe() {
+    // Staged = renders at its fire time; rendering doesn't consume it
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!probeTarget(i) || probe->reached[i]) continue;
+        CRGB pixel = CRGB::Black;
+        nodes[i].mesh->renderEvents(probe->fireAt, &pixel, 1);
+        if (pixel != CRGB(CRGB::Black)) {
+            probe->reached[i] = true;
+            propagation.push_back((host::nowMicros - probe->sentAt) / 1000.0f);
+        }
+    }
+    if (host::nowMicros - probe->sentAt >= (int64_t)SimRunner::PROBE_WINDOW_MS * 1000) closeProbe();
+}
+
+void Simulation::closeProbe() {
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!probeTarget(i)) continue;
+        report.probeTargets++;
+        if (probe->reached[i]) report.probeReached++;
+    }
+    probe.reset();
+}
+
+// Events are for the master's group; the other groups rightly ignore them
+bool Simulation::probeTarget(size_t index) const {
+    const SimNode& node = nodes[index];
+    return (int)index != probe->master && node.alive && node.group == nodes[probe->master].group;
+}
+
+void Simulation::streamFrame(SimNode& node) {
+    // Stands in for the animation task: a frame that changes every time, so
+    // each one goes out as a delta
+    if (!node.mesh->isPixelStreamSource() || !node.mesh->isPixelStreamFrameDue()) return;
+    uint32_t displayTime = node.mesh->getNetworkTime() + MeshNetworkManager::PIXEL_STREAM_DELAY_MS;
+    frame.assign(SimRunner::LEDS, CRGB::Black);
+    frame[(displayTime / 20) % SimRunner::LEDS] = CRGB::White;
+    node.mesh->streamPixels(frame.data(), frame.size(), displayTime);
+}
+
+void Simulation::failover(int master) {
+    failoverStart = host::nowMicros;
+    countLeadership(takeoversBefore, electionsBefore);
+    leaving = master;
+    convergedSince = -1; // Two masters while handing over isn't a disruption
+    if (probe) closeProbe();
+
+    // Waits (in simulated time) for a successor to take over, as before an OTA
+    // reboot; the group may settle with the old master following meanwhile
+    if (scenario.handover) {
+        enter(master);
+        nodes[master].mesh->prepareForRestart();
+        host::serialTag.clear();
+    }
+    nodes[master].alive = false;
+    nodes[master].radio->setEnabled(false);
+    convergedSince = -1;
+}
+
+void Simulation::countLeadership(uint32_t& takeovers, uint32_t& elections) const {
+    takeovers = 0;
+    elections = 0;
+    for (const auto& node : nodes) {
+        const MeshStats& stats = node.mesh->getStats();
+        takeovers += stats.takeovers.load();
+        elections += stats.elections.load();
+    }
+}
+
+} // namespace
+
+SimReport SimRunner::run(const SimScenario& scenario) {
+    Simulation simulation(scenario);
+    return simulation.run();
+}
+
+void SimRunner::print(const SimScenario& scenario, const SimReport& report) {
+    const SimMediumConfig& m = scenario.medium;
+    printf("== %s: %d nodes, ", scenario.name.c_str(), scenario.nodes);
+    if (scenario.lineSpacingMeters > 0.0f) printf("line %.0f m apart", scenario.lineSpacingMeters);
+    else printf("%.0f m square", scenario.areaMeters);
+    printf(", range %.0f m, loss %.0f%%, latency %.1f+%.1f ms, skew +/-%.0f ppm",
+           m.rangeMeters, m.lossRate * 100.0f, m.latencyMicros / 1000.0f, m.jitterMicros / 1000.0f, scenario.skewPpm);
+    if (scenario.groups > 1) printf(", %d groups", scenario.groups);
+    printf("%s%s, %.0f s\n", scenario.relay ? ", relay" : "", scenario.stream ? ", streaming" : "",
+           scenario.durationMs / 1000.0f);
+
+    if (report.convergenceMs >= 0.0f) {
+        printf("  convergence  %.0f ms, %u disruption(s) after, %d master(s) at the end\n",
+               report.convergenceMs, report.disruptions, report.masters);
+    } else {
+        printf("  convergence  never (%d masters at the end)\n", report.masters);
+    }
+
+    if (report.syncSamples) {
+        printf("  sync error   mean %.0f us, p95 %.0f us, max %.0f us (%u samples)\n",
+               report.syncMeanMicros, report.syncP95Micros, report.syncMaxMicros, report.syncSamples);
+    } else {
+        printf("  sync error   no samples\n");
+    }
+
+    if (report.probeTargets) {
+        printf("  propagation  mean %.1f ms, p95 %.1f ms, max %.1f ms, %u/%u delivered (%u events)\n",
+               report.propagationMeanMs, report.propagationP95Ms, report.propagationMaxMs,
+               report.probeReached, report.probeTargets, report.probes);
+    } else {
+        printf("  propagation  no events\n");
+    }
+
+    if (scenario.relay) {
+        printf("  relay        %u relayed, %u suppressed, %u duplicates dropped, %u events handled twice\n",
+               report.relayed, report.relaySuppressed, report.duplicates, report.eventCopies);
+    }
+
+    if (scenario.failoverAtMs) {
+        if (report.failoverMs >= 0.0f) {
+            printf("  failover     %.0f ms%s, %u takeover(s), %u election(s)\n", report.failoverMs,
+                   scenario.handover ? "" : " (power loss)", report.takeovers, report.elections);
+        }
+        else printf("  failover     no new master (%d at the end)\n", report.masters);
+    }
+
+    printf("  airtime      %.2f%% of the channel, busiest node %.2f%% (%u frames)\n",
+           report.channelUse * 100.0f, report.busiestNodeUse * 100.0f, report.framesSent);
+}
@@ -0,0 +1,7 @@
+// The audio tool builds its effect straight from AnimationPresets; these
+// only let AnimationPresets.cpp link without the rest of AnimationManager
+// and never run.
+#include "animation/AnimationManager.h"
+
+void AnimationManager::registerBaseAnimation(Animation* anim) { delete anim; }
+void AnimationManager::loadPresets() {}
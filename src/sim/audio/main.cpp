@@ -0,0 +1,147 @@
+// Offline audio tuning on the host (native-audio build): runs the same
+// AudioBenchmark the device runs from /api/audio/benchmark over WAV files
+// and prints its figures, so an effect's params can be tuned against a
+// recording without flashing anything. Paths are LittleFS paths under
+// --fs (data/ by default), e.g.
+//   .pio/build/native-audio/program --effect=KickReaction --set=Threshold=120 /audio/kick.wav
+#include "animation/AnimationPresets.h"
+#include "animation/Animation.h"
+#include "audio/AudioBenchmark.h"
+#include "system/Config.h"
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct ToolOptions {
+    std::string effect;
+    std::string preset;
+    std::vector<std::pair<std::string, std::string>> overrides; // Param name, JSON value
+    std::vector<std::string> files;
+    int leds = NUM_LEDS;
+    bool verbose = false;
+};
+
+static void usage() {
+    printf("Usage: program [options] /file.wav...\n"
+           "  --effect=TYPE    base animation to run (KickReaction, or the preset's)\n"
+           "  --preset=PATH    start from a preset file, e.g. /presets/party.json\n"
+           "  --set=NAME=JSON  override one param, e.g. --set=Gain=1.5 (repeatable)\n"
+           "  --fs=DIR         host directory standing in for LittleFS (data)\n"
+           "  --leds=N         strip length (%d)\n"
+           "  --verbose        WAV and benchmark log output\n", NUM_LEDS);
+}
+
+static bool parse(int argc, char** argv, ToolOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (arg[0] != '-') {
+            options.files.push_back(arg);
+            continue;
+        }
+        const char* eq = strchr(arg, '=');
+        std::string value = eq ? eq + 1 : "";
+        size_t len = eq ? (size_t)(eq - arg) : strlen(arg);
+        auto is = [&](const char* name) { return strlen(name) == len && strncmp(arg, name, len) == 0; };
+
+        if (is("--effect")) options.effect = value;
+        else if (is("--preset")) options.preset = value;
+        else if (is("--fs")) host::fsRoot = value;
+        else if (is("--leds")) options.leds = atoi(value.c_str());
+        else if (is("--verbose")) options.verbose = true;
+        else if (is("--set")) {
+            size_t split = value.find('=');
+            if (split == std::string::npos) return false;
+            options.overrides.push_back({value.substr(0, split), value.substr(split + 1)});
+        }
+        else return false;
+    }
+    return !options.files.empty() && options.leds > 0;
+}
+
+// The effect under test, set up the way the device would have it
+static Animation* buildAnimation(const ToolOptions& options) {
+    DynamicJsonDocument preset(2048);
+    std::string type = options.effect;
+    if (!options.preset.empty()) {
+        File file = LittleFS.open(options.preset.c_str(), FILE_READ);
+        std::string json;
+        uint8_t buf[256];
+        size_t got;
+        while (file && (got = file.read(buf, sizeof(buf))) > 0) json.append((const char*)buf, got);
+        if (json.empty() || deserializeJson(preset, json)) {
+            fprintf(stderr, "Cannot read preset '%s'\n", options.preset.c_str());
+            return nullptr;
+        }
+        if (type.empty()) type = preset["baseType"] | "";
+    }
+    if (type.empty()) type = "KickReaction";
+
+    Animation* anim = AnimationPresets::createAnimation(type);
+    if (!anim) {
+        fprintf(stderr, "Unknown effect '%s'\n", type.c_str());
+        return nullptr;
+    }
+    if (preset.containsKey("params")) {
+        JsonObject params = preset["params"];
+        anim->deserializeParameters(params);
+    }
+
+    // Each override goes through the same parser a preset's params do
+    for (const auto& override : options.overrides) {
+        DynamicJsonDocument value(512);
+        DynamicJsonDocument doc(512);
+        if (deserializeJson(value, override.second)) {
+            fprintf(stderr, "Bad value for %s: %s\n", override.first.c_str(), override.second.c_str());
+            delete anim;
+            return nullptr;
+        }
+        doc[override.first] = value.as<JsonVariant>();
+        JsonObject params = doc.as<JsonObject>();
+        if (!anim->findParameter(override.first) || !anim->deserializeParameters(params)) {
+            fprintf(stderr, "%s has no param %s of that type\n", type.c_str(), override.first.c_str());
+            delete anim;
+            return nullptr;
+        }
+    }
+    return anim;
+}
+
+int main(int argc, char** argv) {
+    ToolOptions options;
+    if (!parse(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    host::wallClock = true; // Analysis and render costs are measured for real
+    host::serialEnabled = options.verbose;
+
+    int failures = 0;
+    for (const std::string& path : options.files) {
+        AudioBenchmark benchmark;
+        Animation* anim = buildAnimation(options);
+        if (!anim) return 2;
+
+        // step() slices the file; on the host there is nothing to yield to
+        if (benchmark.start(path.c_str(), anim, options.leds)) {
+            while (benchmark.step()) {}
+        }
+
+        const AudioBenchmark::Result& r = benchmark.getResult();
+        if (!r.ok) {
+            printf("%s: %s\n", path.c_str(), r.error.c_str());
+            failures++;
+            continue;
+        }
+        printf("%s: %lu frames, analysis %lu us (max %lu), render %lu us (max %lu), "
+               "%lu/%lu kicks answered, latency %.1f ms (max %.1f)\n",
+               path.c_str(), (unsigned long)r.frames,
+               (unsigned long)r.avgAnalysisMicros, (unsigned long)r.maxAnalysisMicros,
+               (unsigned long)r.avgRenderMicros, (unsigned long)r.maxRenderMicros,
+               (unsigned long)r.responses, (unsigned long)r.kicks, r.avgLatencyMs, r.maxLatencyMs);
+    }
+    return failures ? 1 : 0;
+}
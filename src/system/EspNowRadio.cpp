@@ -0,0 +1,88 @@
+#include "system/EspNowRadio.h"
+#include <Arduino.h>
+#include <WiFi.h>
+
+EspNowRadio* EspNowRadio::instance = nullptr;
+
+static const uint8_t broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+bool EspNowRadio::begin() {
+    instance = this;
+
+    if (esp_now_init() != ESP_OK) {
+        Serial.println("ESP-NOW init failed");
+        return false;
+    }
+
+    esp_now_register_recv_cb(onReceiveWrapper);
+    esp_now_register_send_cb(onSendWrapper);
+
+    // ESP-NOW's receive callback carries no signal strength; sniff management
+    // frames (ESP-NOW travels as vendor action frames) to pick it up
+    wifi_promiscuous_filter_t filter = {};
+    filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
+    esp_wifi_set_promiscuous_filter(&filter);
+    esp_wifi_set_promiscuous_rx_cb(onPromiscuousWrapper);
+    esp_wifi_set_promiscuous(true);
+
+    if (!addPeer(broadcastAddress)) {
+        Serial.println("Failed to add broadcast peer");
+        return false;
+    }
+
+    Serial.print("ESP-NOW initialized on channel ");
+    Serial.println(WiFi.channel());
+    return true;
+}
+
+void EspNowRadio::macAddress(uint8_t* mac) const {
+    WiFi.macAddress(mac);
+}
+
+bool EspNowRadio::addPeer(const uint8_t* mac) {
+    esp_now_peer_info_t peerInfo = {};
+    memcpy(peerInfo.peer_addr, mac, 6);
+    peerInfo.channel = 0;  // Use current channel (dictated by WiFi)
+    peerInfo.encrypt = false;
+    return esp_now_add_peer(&peerInfo) == ESP_OK;
+}
+
+void EspNowRadio::removePeer(const uint8_t* mac) {
+    esp_now_del_peer(mac);
+}
+
+bool EspNowRadio::send(const uint8_t* mac, const uint8_t* data, size_t len) {
+    esp_err_t result = esp_now_send(mac ? mac : broadcastAddress, data, len);
+    if (result != ESP_OK) {
+        Serial.print("Send failed: ");
+        Serial.println(result);
+        return false;
+    }
+    return true;
+}
+
+void EspNowRadio::onReceiveWrapper(const uint8_t* mac, const uint8_t* data, int len) {
+    if (!instance || !instance->receiveCallback) return;
+    int8_t rssi = memcmp(instance->sniffedMac, mac, 6) == 0 ? instance->sniffedRssi : 0;
+    instance->receiveCallback(mac, data, len, rssi);
+}
+
+void EspNowRadio::onSendWrapper(const uint8_t* mac, esp_now_send_status_t status) {
+    if (!instance || !instance->sendCallback) return;
+    // Broadcasts come back as a null MAC, matching send()
+    bool broadcast = mac && memcmp(mac, broadcastAddress, 6) == 0;
+    instance->sendCallback(broadcast ? nullptr : mac, status == ESP_NOW_SEND_SUCCESS);
+}
+
+void EspNowRadio::onPromiscuousWrapper(void* buf, wifi_promiscuous_pkt_type_t type) {
+    // Wi-Fi task, every management frame: keep this to a few compares
+    if (type != WIFI_PKT_MGMT || !instance) return;
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    const uint8_t* p = pkt->payload;
+    if (pkt->rx_ctrl.sig_len < 28) return;
+
+    // Action frame (subtype 13), vendor specific category, Espressif OUI
+    if (p[0] != 0xD0 || p[24] != 127 || p[25] != 0x18 || p[26] != 0xFE || p[27] != 0x34) return;
+    memcpy(instance->sniffedMac, p + 10, 6); // Transmitter address
+    instance->sniffedRssi = pkt->rx_ctrl.rssi;
+}
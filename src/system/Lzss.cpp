@@ -0,0 +1,102 @@
+#include "system/Lzss.h"
+#include <vector>
+
+static const size_t HASH_SIZE = 1024;
+static const int MAX_CHAIN = 32; // Candidates tried per position
+
+static inline size_t hash3(const uint8_t* p) {
+    return ((p[0] << 6) ^ (p[1] << 3) ^ p[2]) & (HASH_SIZE - 1);
+}
+
+size_t Lzss::encode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+    if (length > MAX_INPUT) return 0;
+
+    // Positions + 1, so 0 ends a chain
+    std::vector<uint16_t> head(HASH_SIZE, 0);
+    std::vector<uint16_t> prev(WINDOW, 0);
+
+    size_t pos = 0;
+    size_t flagPos = 0;
+    int bit = 8;
+    size_t i = 0;
+
+    while (i < length) {
+        if (bit == 8) {
+            if (pos + 1 > capacity) return 0;
+            flagPos = pos++;
+            out[flagPos] = 0;
+            bit = 0;
+        }
+
+        // Longest earlier match within the window
+        size_t bestLen = 0;
+        size_t bestOffset = 0;
+        if (i + MIN_MATCH <= length) {
+            size_t limit = length - i < MAX_MATCH ? length - i : MAX_MATCH;
+            uint16_t candidate = head[hash3(in + i)];
+            for (int depth = 0; candidate && depth < MAX_CHAIN; depth++) {
+                size_t p = candidate - 1;
+                if (i - p > WINDOW) break;
+                size_t n = 0;
+                while (n < limit && in[p + n] == in[i + n]) n++;
+                if (n > bestLen) {
+                    bestLen = n;
+                    bestOffset = i - p;
+                    if (n == limit) break;
+                }
+                uint16_t next = prev[p % WINDOW];
+                if (next >= candidate) break; // Chain wrapped onto newer positions
+                candidate = next;
+            }
+        }
+
+        size_t step;
+        if (bestLen >= MIN_MATCH) {
+            if (pos + 2 > capacity) return 0;
+            size_t offset = bestOffset - 1;
+            out[pos++] = (uint8_t)(offset >> 4);
+            out[pos++] = (uint8_t)(((offset & 0x0F) << 4) | (bestLen - MIN_MATCH));
+            step = bestLen;
+        } else {
+            if (pos + 1 > capacity) return 0;
+            out[flagPos] |= 1 << bit;
+            out[pos++] = in[i];
+            step = 1;
+        }
+        bit++;
+
+        for (size_t k = 0; k < step; k++, i++) {
+            if (i + MIN_MATCH > length) continue;
+            size_t h = hash3(in + i);
+            prev[i % WINDOW] = head[h];
+            head[h] = (uint16_t)(i + 1);
+        }
+    }
+
+    return pos;
+}
+
+int Lzss::decode(const uint8_t* in, size_t length, uint8_t* out, size_t capacity) {
+    size_t pos = 0;
+    size_t i = 0;
+
+    while (i < length) {
+        uint8_t flags = in[i++];
+        for (int bit = 0; bit < 8 && i < length; bit++) {
+            if (flags & (1 << bit)) {
+                if (pos >= capacity) return -1;
+                out[pos++] = in[i++];
+                continue;
+            }
+
+            if (i + 2 > length) return -1;
+            size_t offset = (((size_t)in[i] << 4) | (in[i + 1] >> 4)) + 1;
+            size_t n = (in[i + 1] & 0x0F) + MIN_MATCH;
+            i += 2;
+            if (offset > pos || pos + n > capacity) return -1;
+            for (size_t k = 0; k < n; k++, pos++) out[pos] = out[pos - offset];
+        }
+    }
+
+    return (int)pos;
+}
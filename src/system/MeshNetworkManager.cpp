@@ -1,9 +1,21 @@
 #include "system/MeshNetworkManager.h"
 #include "animation/AnimationManager.h"
+#include "system/Hash.h"
+#include "system/PixelCodec.h"
+#include "system/Lzss.h"
 #include <Arduino.h>
+#include <algorithm>
 
-// Static instance pointer for callback
-MeshNetworkManager* MeshNetworkManager::instance = nullptr;
+// Node IDs are the station MAC, big-endian in the low 48 bits
+static inline uint64_t macToId(const uint8_t* mac) {
+    uint64_t id = 0;
+    for (int i = 0; i < 6; i++) id = (id << 8) | mac[i];
+    return id;
+}
+
+static inline void idToMac(uint64_t id, uint8_t* mac) {
+    for (int i = 5; i >= 0; i--, id >>= 8) mac[i] = id & 0xFF;
+}
 
 MeshNetworkManager::MeshNetworkManager(LedController& ledController)
     : ledController(ledController),
@@ -13,64 +25,60 @@ MeshNetworkManager::MeshNetworkManager(LedController& ledController)
       lastHeartbeatTime(0),
       sequenceNumber(0),
       electionInProgress(false),
-      timeOffset(0),
-      smoothedOffset(0),
-      hasSyncedOnce(false),
-      myGroupName("") {}
+      myGroupName(""),
+      myGroupHash(fnv1a32("")) {}
 
 void MeshNetworkManager::begin() {
     Serial.println("=== Mesh Network Manager Starting ===");
     
-    // Set static instance for callbacks
-    instance = this;
-    
     // Get MAC address as unique ID
     uint8_t mac[6];
-    WiFi.macAddress(mac);
-    myId = 0;
-    for (int i = 0; i < 6; i++) {
-        myId = (myId << 8) | mac[i];
-    }
+    radio->macAddress(mac);
+    myId = macToId(mac);
     
     Serial.print("My ID: ");
     Serial.println(String(myId, HEX));
 
-    // Initialize ESP-NOW
-    if (esp_now_init() != ESP_OK) {
-        Serial.println("ESP-NOW init failed");
-        return;
-    }
-
-    // Register receive callback
-    esp_now_register_recv_cb(onReceiveWrapper);
-
-    // Set up broadcast peer - use WiFi's channel
-    esp_now_peer_info_t peerInfo = {};
-    memset(&peerInfo, 0, sizeof(peerInfo));
-    memcpy(peerInfo.peer_addr, broadcastAddress, 6);
-    peerInfo.channel = 0;  // Use current channel (dictated by WiFi)
-    peerInfo.encrypt = false;
-    
-    if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-        Serial.println("Failed to add broadcast peer");
-        return;
-    }
-
-    Serial.print("ESP-NOW initialized on channel ");
-    Serial.println(WiFi.channel());
+    // Pixel stream buffers match our own strip
+    int numLeds = ledController.getNumLeds();
+    streamLastSent.assign(numLeds, CRGB::Black);
+    streamWorking.assign(numLeds, CRGB::Black);
+    streamReady.assign(numLeds, CRGB::Black);
+
+    // Reassembly buffers up front, while the heap is still in one piece
+    for (auto& session : inbound) session.data.reserve(BULK_RX_BUFFER);
+    bulkDecoded.reserve(BULK_PRESET_MAX_BYTES);
+
+    radio->setReceiveCallback([this](const uint8_t* mac, const uint8_t* data, int len, int8_t rssi) {
+        onRadioReceive(mac, data, len, rssi);
+    });
+    // Send completions pace the outbox
+    radio->setSendCallback([this](const uint8_t* mac, bool delivered) {
+        onRadioSent(mac, delivered);
+    });
+    if (!radio->begin()) return;
 
     currentState = NodeState::IDLE;
-    lastHeartbeatTime = millis();
+    lastHeartbeatTime = clock->millis();
     
     Serial.println("Mesh network initialized, listening for master...");
     
-    // Request sync on startup (after a short delay to allow connections to stabilize)
-    // We can't delay here, so just send it.
-    broadcastRequestSyncPresets();
+    // Gossip starts in fast mode; per-node seeds keep a fleet powering up together from colliding
+    announceTrickle.seed((uint32_t)(myId ^ (myId >> 32)));
+    digestTrickle.seed((uint32_t)(myId ^ (myId >> 32)) * 2654435761u);
+    announceTrickle.start(clock->millis());
+    digestTrickle.start(clock->millis());
 }
 
 void MeshNetworkManager::update() {
-    unsigned long now = millis();
+    processReceived();
+
+    unsigned long now = clock->millis();
+
+    if (masterId != statsMasterId) {
+        if (masterId != 0) MeshStats::bump(stats.masterChanges);
+        statsMasterId = masterId;
+    }
 
     switch (currentState) {
         case NodeState::STARTUP:
@@ -79,18 +87,22 @@ void MeshNetworkManager::update() {
 
         case NodeState::IDLE:
             // No master detected, start election after timeout
-            if (now - lastHeartbeatTime > 2000) {
+            if (now - lastHeartbeatTime > IDLE_LISTEN_MS && !retiring) {
                 Serial.println("No master detected, starting election");
                 startElection();
             }
             break;
 
         case NodeState::ELECTION:
+            if (!electionSent) {
+                if ((long)(now - electionSendAt) >= 0) sendElection();
+                break;
+            }
             // Wait for OK responses or timeout
             if (now - lastElectionTime > 300) {
                 if (!receivedOK) {
                     // No higher priority nodes, become master
-                    becomeCoordinator();
+                    becomeCoordinator(leaderTerm + 1);
                 }
                 // If we received OK, wait for coordinator announcement
                 else if (now - lastElectionTime > 800) {
@@ -102,86 +114,59 @@ void MeshNetworkManager::update() {
             break;
 
         case NodeState::MASTER:
-            // Send heartbeat every 5 seconds
-            if (now - lastHeartbeatTime > 5000) {
-                sendHeartbeat();
-                lastHeartbeatTime = now;
+            if (now - lastSuccessorCheck >= LEASE_RENEW_MS) {
+                lastSuccessorCheck = now;
+                if (refreshSuccessors()) beaconDue = true;
             }
-            // Send time sync every 10 seconds (separate from heartbeat)
-            static unsigned long lastTimeSyncTime = 0;
-            if (now - lastTimeSyncTime > 10000) {
-                sendTimeSync();
-                lastTimeSyncTime = now;
+            // Our other broadcasts renew the lease; beacon only after a silence
+            if (beaconDue || now - lastBroadcastTime > LEASE_RENEW_MS || now - lastBeaconTime > LEASE_BEACON_REFRESH_MS) {
+                sendHeartbeat();
             }
             break;
 
-        case NodeState::SLAVE:
-            // Check for master heartbeat timeout - 15s to allow for 5s heartbeat interval + OTA checks
-            if (now - lastHeartbeatTime > 15000) {
-                Serial.println("Master heartbeat timeout, starting election");
+        case NodeState::SLAVE: {
+            // Successors claim one slot apart once the lease lapses; anyone
+            // unranked waits for all of them before calling an election
+            unsigned long silence = now - lastHeartbeatTime;
+            if (retiring) {
+                // Leaving soon: leave the lease to nodes that will still be here
+            } else if (successorRank >= 0 && silence > leaseMs + successorRank * TAKEOVER_SLOT_MS) {
+                Serial.printf("Mesh: lease of %llX lapsed, taking over as successor %d\r\n", masterId, successorRank);
+                MeshStats::bump(stats.takeovers);
+                becomeCoordinator(leaderTerm + 1);
+                break;
+            } else if (silence > leaseMs + (LEASE_MAX_SUCCESSORS + 1) * TAKEOVER_SLOT_MS) {
+                Serial.println("Master lease lapsed with no successor, starting election");
                 startElection();
+                break;
+            }
+            // A new master gets sampled right away rather than at our backed-off cadence
+            if (masterId != timeSyncMasterId && (long)(nextTimeSyncRequest - now) > (long)TIME_SYNC_FAST_MS) {
+                nextTimeSyncRequest = now;
+            }
+            if ((long)(now - nextTimeSyncRequest) >= 0) {
+                sendTimeSyncRequest();
             }
             break;
+        }
     }
-    // Periodically announce self to mesh (every 5 seconds)
-    static unsigned long lastAnnouncement = 0;
-    if (millis() - lastAnnouncement > 5000) {
-        sendPeerAnnouncement();
-        lastAnnouncement = millis();
-    }
-
-    // Handle pending group assignment broadcast (from main loop)
-    if (pendingGroupAssignment.pending) {
-        doSendAssignGroup(pendingGroupAssignment.targetId, pendingGroupAssignment.groupName);
-        pendingGroupAssignment.pending = false;
-    }
-
-    // Handle pending param sync
-    if (pendingParamSync.pending) {
-        doSendSyncParam(pendingParamSync.paramName, pendingParamSync.jsonValue);
-        pendingParamSync.pending = false;
-    }
-
-    // Handle pending power sync
-    if (pendingPowerSync.pending) {
-        doSendSyncPower(pendingPowerSync.powerOn);
-        pendingPowerSync.pending = false;
+    processHandover(now);
+    processPresetQueries(now);
+
+    // Forget peers that stopped announcing
+    if (now - lastPeerExpiry > 1000) {
+        lastPeerExpiry = now;
+        portENTER_CRITICAL(&peerMux);
+        size_t expired = knownPeers.expire(now, peerExpiryMs());
+        portEXIT_CRITICAL(&peerMux);
+        if (expired) Serial.printf("Mesh: Expired %u peer(s)\r\n", expired);
     }
 
-
-    // Periodic Sync Request (every 60 seconds)
-    static unsigned long lastSyncRequest = 0;
-    if (now - lastSyncRequest > 10000) {
-        broadcastRequestSyncPresets();
-        lastSyncRequest = now;
-    }
-    
-    // Process manifest queue (non-blocking, one per cycle)
-    if (manifestQueue.active && !manifestQueue.names.empty() && now >= manifestQueue.nextSendTime) {
-        std::string name = manifestQueue.names.back();
-        manifestQueue.names.pop_back();
-        
-        MeshMessage response;
-        response.type = MessageType::PRESET_MANIFEST;
-        response.senderId = myId;
-        response.sequenceNumber = sequenceNumber++;
-        response.totalPackets = 1;
-        response.packetIndex = 0;
-        
-        strncpy((char*)response.data, name.c_str(), 229);
-        response.data[229] = '\0';
-        response.dataLength = strlen((char*)response.data) + 1;
-        
-        sendMessage(response);
-        
-        // Schedule next send with 100ms spacing
-        manifestQueue.nextSendTime = now + 100;
-        
-        if (manifestQueue.names.empty()) {
-            manifestQueue.active = false;
-            Serial.println("Mesh: Manifest queue complete");
-        }
-    }
+    processGossip(now);
+    processRelays();
+    processUnicastFallback();
+    processOutbound();
+    processInbound();
     
     // Process data request queue (non-blocking, one per cycle)
     if (!dataRequestQueue.requests.empty() && now >= dataRequestQueue.nextSendTime) {
@@ -196,21 +181,54 @@ void MeshNetworkManager::update() {
         msg.packetIndex = 0;
         
         memcpy(msg.data, &req.targetId, sizeof(uint64_t));
-        strncpy((char*)msg.data + sizeof(uint64_t), req.name.c_str(), 229 - sizeof(uint64_t));
-        ((char*)msg.data)[229] = '\0';
-        msg.dataLength = sizeof(uint64_t) + strlen(req.name.c_str()) + 1;
+        strncpy((char*)msg.data + sizeof(uint64_t), req.name.c_str(), MESH_MAX_DATA - 1 - sizeof(uint64_t));
+        ((char*)msg.data)[MESH_MAX_DATA - 1] = '\0';
+        msg.dataLength = sizeof(uint64_t) + strlen((char*)msg.data + sizeof(uint64_t)) + 1;
         
-        sendMessage(msg);
+        sendTo(req.targetId, msg);
         Serial.printf("Mesh: Sent data request for '%s'\r\n", req.name.c_str());
         
         // Schedule next request with 500ms spacing (allow time for response)
         dataRequestQueue.nextSendTime = now + 500;
     }
+
+    processOutbox();
+}
+
+// ==========================================
+// SCHEDULED SCENES
+// ==========================================
+
+uint32_t MeshNetworkManager::getSceneLeadMs() const {
+    // One-way delay is about half the measured round trip; allow a few times
+    // the clock jitter on top, plus whatever urgent traffic is queued ahead of
+    // us and, with relaying on, the rebroadcast hold-off at each hop
+    uint32_t delayUs = stats.syncDelay.load(std::memory_order_relaxed) / 2 +
+                       4 * stats.syncJitter.load(std::memory_order_relaxed);
+    uint32_t lead = SCENE_LEAD_MIN_MS + delayUs / 1000;
+    lead += (outboxCount(MeshPriority::REALTIME) + outboxCount(MeshPriority::CONTROL)) * SCENE_LEAD_PER_QUEUED_MS;
+    if (relayEnabled) lead += MESH_DEFAULT_TTL * RELAY_JITTER_MAX_MS;
+    return lead < SCENE_LEAD_MAX_MS ? lead : SCENE_LEAD_MAX_MS;
 }
 
-// New: Broadcast Animation State
-void MeshNetworkManager::broadcastAnimationState(const char* name, uint32_t startTime) {
-    // if (currentState != NodeState::MASTER) return; // Allow anyone to broadcast in a group
+uint32_t MeshNetworkManager::commitScene(const char* name, const char* paramsJson) {
+    size_t paramsLength = paramsJson ? strlen(paramsJson) : 0;
+    if (paramsLength > SCENE_PARAMS_MAX) {
+        Serial.printf("Mesh: scene params too large (%u bytes)\r\n", (unsigned)paramsLength);
+        return 0;
+    }
+
+    uint32_t now = getNetworkTime();
+    if (!inGroup()) {
+        stageScene(now, name, paramsJson, paramsLength);
+        return now;
+    }
+
+    uint32_t applyAt = now + getSceneLeadMs();
+
+    AnimationStatePayload payload = {};
+    payload.applyAt = applyAt;
+    strncpy(payload.animationName, name ? name : "", sizeof(payload.animationName) - 1);
 
     MeshMessage msg;
     msg.type = MessageType::ANIMATION_STATE;
@@ -218,23 +236,161 @@ void MeshNetworkManager::broadcastAnimationState(const char* name, uint32_t star
     msg.sequenceNumber = sequenceNumber++;
     msg.totalPackets = 1;
     msg.packetIndex = 0;
-    msg.dataLength = sizeof(AnimationStatePayload);
-    
-    AnimationStatePayload payload;
-    strncpy(payload.animationName, name, 31);
-    payload.animationName[31] = '\0'; // Ensure null termination
-    strncpy(payload.groupName, myGroupName.c_str(), 31);
-    payload.groupName[31] = '\0';
-    payload.startTime = startTime;
-    
+    msg.dataLength = sizeof(AnimationStatePayload) + paramsLength;
     memcpy(msg.data, &payload, sizeof(AnimationStatePayload));
+    if (paramsLength) memcpy(msg.data + sizeof(AnimationStatePayload), paramsJson, paramsLength);
+    sendMessage(msg);
 
+    stageScene(applyAt, payload.animationName, paramsJson, paramsLength);
+    Serial.printf("Mesh: scene '%s' at %u (+%u ms)\r\n", payload.animationName, applyAt, applyAt - now);
+    return applyAt;
+}
+
+void MeshNetworkManager::stageScene(uint32_t applyAt, const char* name, const char* params, size_t paramsLength) {
+    portENTER_CRITICAL(&sceneMux);
+    // A newer commit replaces one still waiting
+    pendingScene.pending = true;
+    pendingScene.applyAt = applyAt;
+    strncpy(pendingScene.name, name ? name : "", sizeof(pendingScene.name) - 1);
+    pendingScene.name[sizeof(pendingScene.name) - 1] = '\0';
+    if (paramsLength) memcpy(pendingScene.params, params, paramsLength);
+    pendingScene.params[paramsLength] = '\0';
+    portEXIT_CRITICAL(&sceneMux);
+}
+
+bool MeshNetworkManager::applyDueScene(uint32_t frameTime) {
+    if (!animManager) return false;
+
+    PendingScene scene;
+    portENTER_CRITICAL(&sceneMux);
+    if (!pendingScene.pending || (int32_t)(frameTime - pendingScene.applyAt) < 0) {
+        portEXIT_CRITICAL(&sceneMux);
+        return false;
+    }
+    scene = pendingScene;
+    pendingScene.pending = false;
+    portEXIT_CRITICAL(&sceneMux);
+
+    if (scene.name[0]) animManager->setAnimation(scene.name);
+
+    if (scene.params[0]) {
+        Animation* current = animManager->getCurrentAnimation();
+        DynamicJsonDocument doc(1024);
+        if (current && !deserializeJson(doc, scene.params)) {
+            current->deserializeParameters(doc.as<JsonObject>());
+        }
+    }
+
+    if (sceneCallback) sceneCallback();
+    return true;
+}
+
+// ==========================================
+// EVENTS
+// ==========================================
+
+uint32_t MeshNetworkManager::broadcastEvent(MeshEventKind kind, CRGB color, uint8_t intensity, uint16_t durationMs) {
+    EventPayload event;
+    event.eventTime = getNetworkTime();
+    event.kind = kind;
+    event.r = color.r;
+    event.g = color.g;
+    event.b = color.b;
+    event.intensity = intensity;
+    event.durationMs = durationMs;
+
+    uint32_t fireAt = event.eventTime + EVENT_SHOW_DELAY_MS;
+    stageEvent(fireAt, event);
+    if (!inGroup()) return fireAt;
+
+    MeshMessage msg;
+    msg.type = MessageType::EVENT;
+    msg.senderId = myId;
+    msg.sequenceNumber = sequenceNumber++;
+    msg.totalPackets = 1;
+    msg.packetIndex = 0;
+    msg.dataLength = sizeof(EventPayload);
+    memcpy(msg.data, &event, sizeof(EventPayload));
     sendMessage(msg);
+    return fireAt;
+}
+
+void MeshNetworkManager::handleEvent(const MeshMessage& msg) {
+    if (msg.dataLength < sizeof(EventPayload)) return;
+
+    EventPayload event;
+    memcpy(&event, msg.data, sizeof(EventPayload));
+
+    // Late ones still show whatever is left of their fade
+    uint32_t fireAt = event.eventTime + EVENT_SHOW_DELAY_MS;
+    int32_t late = (int32_t)(getNetworkTime() - fireAt);
+    if (late > 0) {
+        MeshStats::bump(stats.eventsLate);
+        if (late >= (int32_t)event.durationMs) return;
+    }
+    stageEvent(fireAt, event);
+}
+
+void MeshNetworkManager::stageEvent(uint32_t fireAt, const EventPayload& event) {
+    portENTER_CRITICAL(&eventMux);
+    // A free slot, else the one due first (most likely already faded)
+    ActiveEvent* slot = &activeEvents[0];
+    for (auto& active : activeEvents) {
+        if (!active.used) {
+            slot = &active;
+            break;
+        }
+        if ((int32_t)(active.fireAt - slot->fireAt) < 0) slot = &active;
+    }
+    slot->used = true;
+    slot->fireAt = fireAt;
+    slot->durationMs = event.durationMs ? event.durationMs : 1;
+    slot->intensity = event.intensity;
+    slot->color = CRGB(event.r, event.g, event.b);
+    portEXIT_CRITICAL(&eventMux);
+}
+
+void MeshNetworkManager::renderEvents(uint32_t frameTime, CRGB* leds, int numLeds) {
+    ActiveEvent showing[MAX_ACTIVE_EVENTS];
+    size_t count = 0;
+    portENTER_CRITICAL(&eventMux);
+    for (auto& active : activeEvents) {
+        if (!active.used) continue;
+        int32_t age = (int32_t)(frameTime - active.fireAt);
+        if (age < 0) continue;
+        if (age >= (int32_t)active.durationMs) {
+            active.used = false;
+            continue;
+        }
+        showing[count++] = active;
+    }
+    portEXIT_CRITICAL(&eventMux);
+
+    // Oldest first, so the newest flash ends up on top
+    std::sort(showing, showing + count, [](const ActiveEvent& a, const ActiveEvent& b) {
+        return (int32_t)(a.fireAt - b.fireAt) < 0;
+    });
+    for (size_t i = 0; i < count; i++) {
+        uint32_t remaining = showing[i].durationMs - (frameTime - showing[i].fireAt);
+        uint8_t amount = (uint8_t)((uint32_t)showing[i].intensity * remaining / showing[i].durationMs);
+        for (int led = 0; led < numLeds; led++) nblend(leds[led], showing[i].color, amount);
+    }
 }
 
 // New: Get synchronized network time
 uint32_t MeshNetworkManager::getNetworkTime() const {
-    return millis() + timeOffset;
+    return (uint32_t)(getNetworkTimeMicros() / 1000);
+}
+
+int64_t MeshNetworkManager::getNetworkTimeMicros() const {
+    return localToNetworkMicros(clock->micros());
+}
+
+int64_t MeshNetworkManager::localToNetworkMicros(int64_t local) const {
+    portENTER_CRITICAL(&clockMux);
+    int64_t offset = clockRefOffset + (int64_t)(clockDrift * (double)(local - clockRefLocal));
+    portEXIT_CRITICAL(&clockMux);
+    return local + offset;
 }
 
 
@@ -247,70 +403,143 @@ bool MeshNetworkManager::isSlave() const {
     return currentState == NodeState::SLAVE;
 }
 
-void MeshNetworkManager::prepareForOTA() {
-    if (currentState == NodeState::MASTER) {
-        Serial.println("Master preparing for OTA, sending shutdown message");
-        MeshMessage msg;
-        msg.type = MessageType::SHUTDOWN;
-        msg.senderId = myId;
-        msg.sequenceNumber = sequenceNumber++;
-        msg.totalPackets = 1;
-        msg.packetIndex = 0;
-        msg.dataLength = 0;
-        
-        sendMessage(msg);
-        delay(100); // Give time for message to send
+bool MeshNetworkManager::prepareForRestart() {
+    retiring = true;
+    if (currentState != NodeState::MASTER) return true;
+
+    // The mesh task does the handover; we only wait for it
+    if (rxTask && xTaskGetCurrentTaskHandle() == rxTask) return false;
+    Serial.println("Mesh: master leaving, handing over");
+    handoverState = HANDOVER_REQUESTED;
+    TaskHandle_t task = rxTask;
+    if (task) xTaskNotifyGive(task);
+
+    unsigned long start = clock->millis();
+    while (clock->millis() - start < HANDOVER_TIMEOUT_MS) {
+        uint8_t state = handoverState;
+        if (state == HANDOVER_DONE) return true;
+        if (state == HANDOVER_FAILED) return false;
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
-    currentState = NodeState::IDLE;
+    return false;
+}
+
+void MeshNetworkManager::cancelRestart() {
+    retiring = false;
+    handoverState = HANDOVER_NONE;
+}
+
+void MeshNetworkManager::releaseLease() {
+    // Slaves treat our lease as lapsed and the ranked successors take over
+    MeshMessage msg;
+    msg.type = MessageType::SHUTDOWN;
+    msg.senderId = myId;
+    msg.sequenceNumber = sequenceNumber++;
+    msg.totalPackets = 1;
+    msg.packetIndex = 0;
+    msg.dataLength = 0;
+    sendMessage(msg);
 }
 
-void MeshNetworkManager::onReceiveWrapper(const uint8_t* mac, const uint8_t* data, int len) {
-    if (instance) {
-        instance->onReceive(mac, data, len);
+void MeshNetworkManager::onRadioReceive(const uint8_t* mac, const uint8_t* data, int len, int8_t rssi) {
+    // Runs in the radio's context: copy the frame and get out, no logging or parsing here
+    if (len <= 0 || len > (int)sizeof(MeshMessage)) return;
+
+    RxFrame* frame = rxQueue.reserve();
+    if (!frame) return; // Full, counted as a drop and reported from update()
+
+    memcpy(frame->mac, mac, 6);
+    frame->len = (uint8_t)len;
+    frame->rxMicros = clock->micros();
+    frame->rssi = rssi;
+    memcpy(frame->data, data, len);
+    rxQueue.commit();
+
+    TaskHandle_t task = rxTask;
+    if (task) xTaskNotifyGive(task);
+}
+
+void MeshNetworkManager::onRadioSent(const uint8_t* mac, bool delivered) {
+    // Radio context: the radio is free again, let the mesh task push the next frame
+    if (!delivered) MeshStats::bump(stats.txCallbackFailures);
+    if (mac && unicastFallbackArmed && memcmp(mac, unicastFallback.mac, 6) == 0) {
+        unicastFallbackArmed = false;
+        if (!delivered) unicastFallbackDue = true;
+    }
+    txBusy = false;
+    TaskHandle_t task = rxTask;
+    if (task) xTaskNotifyGive(task);
+}
+
+void MeshNetworkManager::processReceived() {
+    const RxFrame* frame;
+    while ((frame = rxQueue.peek()) != nullptr) {
+        currentRxMicros = frame->rxMicros;
+        currentRxRssi = frame->rssi;
+        onReceive(frame->mac, frame->data, frame->len);
+        rxQueue.release();
+    }
+
+    uint32_t dropped = rxQueue.takeDropped();
+    if (dropped) {
+        MeshStats::bump(stats.rxQueueDrops, dropped);
+        Serial.printf("Mesh: RX queue full, dropped %u frames\r\n", dropped);
     }
 }
 
 void MeshNetworkManager::onReceive(const uint8_t* mac, const uint8_t* data, int len) {
-    // Debug: Log ALL incoming ESP-NOW packets
-    Serial.printf("ESP-NOW RX: len=%d, expected=%d\r\n", len, sizeof(MeshMessage));
-    
-    // if (len != sizeof(MeshMessage)) {
-    //     Serial.printf("ESP-NOW: Dropping packet, wrong size: got %d, expected %d\r\n", len, sizeof(MeshMessage));
-    //     return;
-    // }
+    // Frames carry the fixed header plus only dataLength bytes of payload
+    if (len < (int)MESH_HEADER_SIZE || len > (int)sizeof(MeshMessage)) {
+        MeshStats::bump(stats.rxMalformed);
+        Serial.printf("ESP-NOW: Dropping packet, bad size: %d\r\n", len);
+        return;
+    }
 
     MeshMessage msg;
-    memcpy(&msg, data, sizeof(MeshMessage));
+    memcpy(&msg, data, len);
+
+    if (msg.dataLength > MESH_MAX_DATA || MESH_HEADER_SIZE + msg.dataLength > (size_t)len) {
+        MeshStats::bump(stats.rxMalformed);
+        Serial.printf("ESP-NOW: Dropping packet, truncated: len=%d dataLength=%u\r\n", len, msg.dataLength);
+        return;
+    }
 
-    // Ignore our own messages
+    // Zero the unused tail so string payloads are always terminated
+    memset(msg.data + msg.dataLength, 0, MESH_MAX_DATA - msg.dataLength);
+
+    // Ignore our own messages, including relayed copies
     if (msg.senderId == myId) return;
 
+    // Pixel frames are never relayed, so can't arrive twice
+    if (msg.type != MessageType::PIXEL_FRAME && !acceptRelayFrame(msg)) {
+        MeshStats::bump(stats.duplicates);
+        return;
+    }
+
+    uint8_t typeIndex = (uint8_t)msg.type;
+    if (typeIndex < MESH_STATS_TYPES) {
+        MeshStats::bump(stats.types[typeIndex].rxPackets);
+        MeshStats::bump(stats.types[typeIndex].rxBytes, len);
+    }
+    trackPeerFrame(msg, macToId(mac));
+
+    // Anything the master sends doubles as its heartbeat, even a frame for
+    // another group that goes no further than this
+    if (currentState == NodeState::SLAVE && msg.senderId == masterId) {
+        lastHeartbeatTime = clock->millis();
+    }
+
+    // Most traffic in a multi-room mesh is for other rooms: settle it on the header
+    if ((msg.groupHash != 0 || isGroupScoped(msg.type)) && !isGroupMember(msg.groupHash)) {
+        MeshStats::bump(stats.groupFiltered);
+        return;
+    }
+
     // Only log non-periodic messages to avoid Serial spam
-    // if (msg.type != MessageType::HEARTBEAT && msg.type != MessageType::TIME_SYNC) {
-    if (true){
-        Serial.print("RX: ");
-        switch(msg.type) {
-            case MessageType::ELECTION: Serial.print("ELECTION"); break;
-            case MessageType::OK: Serial.print("OK"); break;
-            case MessageType::COORDINATOR: Serial.print("COORDINATOR"); break;
-            case MessageType::SHUTDOWN: Serial.print("SHUTDOWN"); break;
-            case MessageType::ANIMATION_STATE: Serial.print("ANIMATION_STATE"); break;
-            case MessageType::PEER_ANNOUNCEMENT: Serial.print("PEER_ANNOUNCEMENT"); break;
-            case MessageType::RENAME_PRESET: Serial.print("RENAME_PRESET"); break;
-            case MessageType::SAVE_PRESET: Serial.print("SAVE_PRESET"); break;
-            case MessageType::DELETE_PRESET: Serial.print("DELETE_PRESET"); break;
-            case MessageType::HEARTBEAT: Serial.print("HEARTBEAT"); break;
-            case MessageType::TIME_SYNC: Serial.print("TIME_SYNC"); break;
-            case MessageType::ASSIGN_GROUP: Serial.print("ASSIGN_GROUP"); break;
-            case MessageType::SYNC_PARAM: Serial.print("SYNC_PARAM"); break;
-            case MessageType::SYNC_POWER: Serial.print("SYNC_POWER"); break;
-            case MessageType::REQUEST_SYNC_PRESETS: Serial.print("REQUEST_SYNC_PRESETS"); break;
-            case MessageType::PRESET_MANIFEST: Serial.print("PRESET_MANIFEST"); break;
-            case MessageType::REQUEST_PRESET_DATA: Serial.print("REQUEST_PRESET_DATA"); break;
-            default: Serial.print("UNKNOWN"); break;
-        }
-        Serial.print(" from ");
-        Serial.println(String(msg.senderId, HEX));
+    if (msg.type != MessageType::AUDIO_FEATURES && msg.type != MessageType::SYNC_PARAM &&
+        msg.type != MessageType::PIXEL_FRAME && msg.type != MessageType::EVENT &&
+        msg.type != MessageType::TIME_SYNC_REQUEST && msg.type != MessageType::TIME_SYNC_RESPONSE) {
+        Serial.printf("RX: %s from %llX\r\n", messageTypeName(msg.type), msg.senderId);
     }
 
     switch (msg.type) {
@@ -334,8 +563,20 @@ void MeshNetworkManager::onReceive(const uint8_t* mac, const uint8_t* data, int
             handleShutdown(msg);
             break;
         
-        case MessageType::TIME_SYNC:
-            handleTimeSync(msg);
+        case MessageType::TIME_SYNC_REQUEST:
+            handleTimeSyncRequest(msg);
+            break;
+
+        case MessageType::TIME_SYNC_RESPONSE:
+            handleTimeSyncResponse(msg);
+            break;
+
+        case MessageType::PIXEL_FRAME:
+            handleFrameData(msg);
+            break;
+
+        case MessageType::HANDOVER:
+            handleHandover(msg);
             break;
 
         case MessageType::ANIMATION_STATE:
@@ -355,7 +596,15 @@ void MeshNetworkManager::onReceive(const uint8_t* mac, const uint8_t* data, int
             break;
 
         case MessageType::SAVE_PRESET:
-            handleSavePreset(msg);
+            handleBulkChunk(msg);
+            break;
+
+        case MessageType::BULK_END:
+            handleBulkEnd(msg);
+            break;
+
+        case MessageType::BULK_NACK:
+            handleBulkNack(msg);
             break;
 
         case MessageType::DELETE_PRESET:
@@ -382,116 +631,320 @@ void MeshNetworkManager::onReceive(const uint8_t* mac, const uint8_t* data, int
             handleSyncPower(msg);
             break;
 
-        case MessageType::REQUEST_SYNC_PRESETS:
-            handleRequestSyncPresets(msg);
+        case MessageType::PRESET_DIGEST:
+            handlePresetDigest(msg);
+            break;
+
+        case MessageType::PRESET_BUCKET_REQUEST:
+            handlePresetBucketRequest(msg);
             break;
 
-        case MessageType::PRESET_MANIFEST:
-            handlePresetManifest(msg);
+        case MessageType::PRESET_BUCKET_ENTRIES:
+            handlePresetBucketEntries(msg);
             break;
 
         case MessageType::REQUEST_PRESET_DATA:
             handleRequestPresetData(msg);
             break;
 
+        case MessageType::AUDIO_FEATURES:
+            handleAudioFeatures(msg);
+            break;
+
+        case MessageType::EVENT:
+            handleEvent(msg);
+            break;
+
         default:
             break;
     }
 }
 
-void MeshNetworkManager::sendTimeSync() {
+void MeshNetworkManager::sendTimeSyncRequest() {
+    uint64_t source = chooseTimeSource();
+    pendingTimeSyncSource = source;
+
+    // Burst until the filter window is full (or a new master or source has
+    // answered once), then settle to the adaptive cadence
+    bool filling = clockSampleCount < TIME_SYNC_WINDOW || masterId != timeSyncMasterId || source != timeSyncSourceId;
+    unsigned long interval = filling ? TIME_SYNC_FAST_MS : timeSyncInterval;
+    nextTimeSyncRequest = clock->millis() + interval;
+
+    TimeSyncRequestPayload request;
+    request.sourceId = source;
+    request.t1 = 0; // Stamped by dispatch() as the frame goes out
+
     MeshMessage msg;
-    msg.type = MessageType::TIME_SYNC;
+    msg.type = MessageType::TIME_SYNC_REQUEST;
     msg.senderId = myId;
     msg.sequenceNumber = sequenceNumber++;
     msg.totalPackets = 1;
     msg.packetIndex = 0;
-    msg.dataLength = sizeof(uint32_t);
-    
-    uint32_t now = millis();
-    memcpy(msg.data, &now, sizeof(uint32_t));
-    
-    Serial.printf("[TimeSync] Sending sync. Time: %lu\r\n", now);
-    sendMessage(msg);
+    msg.dataLength = sizeof(TimeSyncRequestPayload);
+    memcpy(msg.data, &request, sizeof(TimeSyncRequestPayload));
+
+    sendTo(source, msg);
 }
 
-void MeshNetworkManager::handleTimeSync(const MeshMessage& msg) {
-    if (msg.senderId == masterId) {
-        uint32_t masterTime;
-        memcpy(&masterTime, msg.data, sizeof(uint32_t));
-        
-        // Add estimated latency
-        const uint32_t LATENCY_MS = 15;
-        masterTime += LATENCY_MS;
+uint64_t MeshNetworkManager::chooseTimeSource() const {
+    // The master unless we know it is out of range (announced, but never heard
+    // first hand lately); then the neighbour nearest to it in strata, staying
+    // with the current source on a tie so its filter keeps its history
+    unsigned long now = clock->millis();
+    uint64_t best = masterId; // No better offer: ask anyway, the unicast fallback relays it
+    uint8_t bestStratum = MESH_TIME_STRATUM_NONE;
+
+    portENTER_CRITICAL(&peerMux);
+    const PeerInfo* master = knownPeers.find(masterId);
+    bool masterInRange = !master || (master->lastHeard && now - master->lastHeard <= TIME_SOURCE_HEARD_MS);
+    if (!masterInRange) {
+        knownPeers.forEach([&](const PeerInfo& peer) {
+            if (!peer.lastHeard || now - peer.lastHeard > TIME_SOURCE_HEARD_MS) return;
+            bool tie = peer.timeStratum == bestStratum && bestStratum != MESH_TIME_STRATUM_NONE;
+            if (peer.timeStratum < bestStratum || (tie && peer.id == timeSyncSourceId)) {
+                best = peer.id;
+                bestStratum = peer.timeStratum;
+            }
+        });
+    }
+    portEXIT_CRITICAL(&peerMux);
+    return best;
+}
 
-        uint32_t localTime = millis();
-        int32_t instantaneousOffset = (int32_t)(masterTime - localTime);
-        
-        // First sync or large jump protection (>500ms)
-        if (!hasSyncedOnce || abs(instantaneousOffset - (int32_t)smoothedOffset) > 500) {
-            smoothedOffset = instantaneousOffset;
-            timeOffset = instantaneousOffset;
-            hasSyncedOnce = true;
-            Serial.printf("[TimeSync] Hard sync. Master: %lu, Local: %lu, Offset: %ld\r\n", masterTime, localTime, timeOffset);
-        } else {
-            // Exponential Smoothing (Alpha = 0.2)
-            // New = Alpha * Instant + (1 - Alpha) * Old
-            smoothedOffset = (0.2 * instantaneousOffset) + (0.8 * smoothedOffset);
-            timeOffset = (int32_t)smoothedOffset;
-             // Only log occasionally to reduce noise, or log debug
-            // Serial.printf("[TimeSync] Smooth sync. Offset: %ld (Raw: %ld)\r\n", timeOffset, instantaneousOffset);
+uint8_t MeshNetworkManager::getTimeStratum() const {
+    if (currentState == NodeState::MASTER) return 0;
+    if (!hasSyncedOnce || timeSyncStratum >= TIME_STRATUM_MAX) return MESH_TIME_STRATUM_NONE;
+    if (clock->millis() - lastTimeSyncAnswer > TIME_STRATUM_STALE_MS) return MESH_TIME_STRATUM_NONE;
+    return timeSyncStratum;
+}
+
+void MeshNetworkManager::handleTimeSyncRequest(const MeshMessage& msg) {
+    if (msg.dataLength < sizeof(TimeSyncRequestPayload)) return;
+
+    TimeSyncRequestPayload request;
+    memcpy(&request, msg.data, sizeof(TimeSyncRequestPayload));
+    if (request.sourceId != myId) return;
+
+    // Only a clock that is itself synced is worth passing on
+    uint8_t stratum = getTimeStratum();
+    if (stratum == MESH_TIME_STRATUM_NONE) return;
+
+    TimeSyncResponsePayload response;
+    response.requesterId = msg.senderId;
+    response.t1 = request.t1;
+    response.t2 = localToNetworkMicros(currentRxMicros);
+    response.stratum = stratum;
+
+    MeshMessage out;
+    out.type = MessageType::TIME_SYNC_RESPONSE;
+    out.senderId = myId;
+    out.sequenceNumber = sequenceNumber++;
+    out.totalPackets = 1;
+    out.packetIndex = 0;
+    out.dataLength = sizeof(TimeSyncResponsePayload);
+
+    response.t3 = 0; // Stamped by dispatch() as the frame goes out
+    memcpy(out.data, &response, sizeof(TimeSyncResponsePayload));
+    sendTo(msg.senderId, out);
+}
+
+void MeshNetworkManager::handleTimeSyncResponse(const MeshMessage& msg) {
+    if (msg.dataLength < sizeof(TimeSyncResponsePayload)) return;
+
+    TimeSyncResponsePayload response;
+    memcpy(&response, msg.data, sizeof(TimeSyncResponsePayload));
+    if (response.requesterId != myId || msg.senderId != pendingTimeSyncSource) return;
+    if (response.t1 != pendingTimeSyncT1) return; // Stale or duplicate
+    pendingTimeSyncT1 = 0;
+    if (response.stratum >= TIME_STRATUM_MAX) return; // Lost its own sync since we asked
+
+    int64_t t4 = currentRxMicros;
+    int64_t delay = (t4 - response.t1) - (response.t3 - response.t2);
+    if (delay < 0) delay = 0;
+    int64_t offset = ((response.t2 - response.t1) + (response.t3 - t4)) / 2;
+
+    // A new source has its own history; start its filter from scratch
+    if (msg.senderId != timeSyncSourceId) {
+        timeSyncSourceId = msg.senderId;
+        clockSampleCount = 0;
+        clockSampleNext = 0;
+        hasDriftBase = false;
+    }
+    timeSyncMasterId = masterId;
+    timeSyncStratum = response.stratum + 1;
+    lastTimeSyncAnswer = clock->millis();
+
+    addClockSample(response.t1 + (t4 - response.t1) / 2, offset, delay);
+}
+
+void MeshNetworkManager::addClockSample(int64_t local, int64_t offset, int64_t delay) {
+    // The offset is only known to within half the round trip, so only call it a
+    // step when the error clearly exceeds that
+    int64_t predicted = localToNetworkMicros(local) - local;
+    int64_t error = offset - predicted;
+
+    if (hasSyncedOnce) {
+        int64_t clamped = std::max<int64_t>(INT32_MIN, std::min<int64_t>(INT32_MAX, error));
+        uint32_t magnitude = (uint32_t)std::min<int64_t>(llabs(error), UINT32_MAX);
+        uint32_t jitter = stats.syncJitter.load(std::memory_order_relaxed);
+        stats.syncOffsetError.store((int32_t)clamped, std::memory_order_relaxed);
+        stats.syncJitter.store(jitter - jitter / 8 + magnitude / 8, std::memory_order_relaxed);
+    }
+    stats.syncDelay.store((uint32_t)std::min<int64_t>(delay, UINT32_MAX), std::memory_order_relaxed);
+    MeshStats::bump(stats.syncSamples);
+
+    if (!hasSyncedOnce || llabs(error) > TIME_SYNC_STEP_US + delay / 2) {
+        portENTER_CRITICAL(&clockMux);
+        clockRefLocal = local;
+        clockRefOffset = offset;
+        portEXIT_CRITICAL(&clockMux);
+        clockSampleCount = 0;
+        clockSampleNext = 0;
+        hasDriftBase = false;
+        if (hasSyncedOnce) {
+            MeshStats::bump(stats.syncSteps);
+            Serial.printf("[TimeSync] Hard sync, error %lld us (delay %lld us)\r\n", error, delay);
         }
+        hasSyncedOnce = true;
+    }
+
+    clockSamples[clockSampleNext] = {local, offset, delay};
+    clockSampleNext = (clockSampleNext + 1) % TIME_SYNC_WINDOW;
+    if (clockSampleCount < TIME_SYNC_WINDOW) clockSampleCount++;
+
+    // Back off while samples keep agreeing with the model; a surprise (or a
+    // restarted filter) brings the fast cadence back
+    if (clockSampleCount < TIME_SYNC_WINDOW || llabs(error) > TIME_SYNC_CALM_US + delay / 2) {
+        timeSyncInterval = TIME_SYNC_INTERVAL_MIN_MS;
     } else {
-        Serial.printf("[TimeSync] Ignored sync from non-master %llX (current master: %llX)\r\n", msg.senderId, masterId);
+        timeSyncInterval = timeSyncInterval * 2 < TIME_SYNC_INTERVAL_MAX_MS ? timeSyncInterval * 2 : TIME_SYNC_INTERVAL_MAX_MS;
+    }
+
+    // Bring every sample to the newest instant using the current drift, then
+    // take the median offset of the lower-delay half (queueing only adds delay)
+    int64_t offsets[TIME_SYNC_WINDOW];
+    int64_t delays[TIME_SYNC_WINDOW];
+    for (int i = 0; i < clockSampleCount; i++) {
+        delays[i] = clockSamples[i].delay;
+    }
+    std::sort(delays, delays + clockSampleCount);
+    int64_t delayCutoff = delays[(clockSampleCount - 1) / 2];
+
+    int n = 0;
+    for (int i = 0; i < clockSampleCount; i++) {
+        const ClockSample& c = clockSamples[i];
+        if (c.delay > delayCutoff) continue;
+        offsets[n++] = c.offset + (int64_t)(clockDrift * (double)(local - c.local));
     }
+    std::sort(offsets, offsets + n);
+    int64_t filtered = (n % 2) ? offsets[n / 2] : (offsets[n / 2 - 1] + offsets[n / 2]) / 2;
+
+    // Drift from filtered offsets spaced far enough apart to swamp the jitter
+    if (!hasDriftBase) {
+        hasDriftBase = true;
+        driftBaseLocal = local;
+        driftBaseOffset = filtered;
+    } else if (local - driftBaseLocal >= TIME_SYNC_DRIFT_BASELINE_US) {
+        double measured = (double)(filtered - driftBaseOffset) / (double)(local - driftBaseLocal);
+        double drift = clockDrift == 0 ? measured : 0.7 * clockDrift + 0.3 * measured;
+        if (drift > TIME_SYNC_MAX_DRIFT) drift = TIME_SYNC_MAX_DRIFT;
+        if (drift < -TIME_SYNC_MAX_DRIFT) drift = -TIME_SYNC_MAX_DRIFT;
+        driftBaseLocal = local;
+        driftBaseOffset = filtered;
+
+        portENTER_CRITICAL(&clockMux);
+        clockDrift = drift;
+        portEXIT_CRITICAL(&clockMux);
+    }
+
+    portENTER_CRITICAL(&clockMux);
+    clockRefLocal = local;
+    clockRefOffset = filtered;
+    portEXIT_CRITICAL(&clockMux);
 }
 
 void MeshNetworkManager::handleAnimationState(const MeshMessage& msg) {
-    if (msg.senderId == masterId) {
-        if (msg.dataLength == sizeof(AnimationStatePayload)) {
-            AnimationStatePayload payload;
-            memcpy(&payload, msg.data, sizeof(AnimationStatePayload));
-            
+    if (!animManager || msg.dataLength < sizeof(AnimationStatePayload)) return;
 
-        }
+    AnimationStatePayload payload;
+    memcpy(&payload, msg.data, sizeof(AnimationStatePayload));
+    payload.animationName[sizeof(payload.animationName) - 1] = '\0';
+
+    // Late commits still apply, on our next frame
+    uint32_t now = getNetworkTime();
+    int32_t ahead = (int32_t)(payload.applyAt - now);
+    uint32_t applyAt = payload.applyAt;
+    if (ahead < 0) {
+        MeshStats::bump(stats.scenesLate);
+        Serial.printf("Mesh: scene '%s' arrived %d ms late\r\n", payload.animationName, -ahead);
+    } else if (ahead > (int32_t)SCENE_MAX_AHEAD_MS) {
+        applyAt = now;
     }
+
+    stageScene(applyAt, payload.animationName,
+               (const char*)msg.data + sizeof(AnimationStatePayload), msg.dataLength - sizeof(AnimationStatePayload));
 }
 
-void MeshNetworkManager::handleHeartbeat(const MeshMessage& msg) {
-    if (currentState == NodeState::IDLE || currentState == NodeState::SLAVE) {
-        // Accept this as master
-        if (masterId == 0 || masterId == msg.senderId) {
-            masterId = msg.senderId;
-            lastHeartbeatTime = millis();
-            
-            if (currentState == NodeState::IDLE) {
-                Serial.print("Master detected: ");
-                Serial.println(String(masterId, HEX));
-                currentState = NodeState::SLAVE;
-            } else {
-                 // Serial.printf("[Heartbeat] Received from master %llX\r\n", msg.senderId);
-            }
-        }
-        // Split brain: higher ID wins
-        else if (msg.senderId > masterId) {
-            Serial.println("Higher priority master detected, switching");
-            masterId = msg.senderId;
-            lastHeartbeatTime = millis();
-            currentState = NodeState::SLAVE;
+bool MeshNetworkManager::outranks(uint32_t term, uint64_t id) const {
+    int32_t ahead = (int32_t)(term - leaderTerm);
+    return ahead > 0 || (ahead == 0 && id > masterId);
+}
+
+bool MeshNetworkManager::acceptLeader(uint64_t id, uint32_t term) {
+    unsigned long now = clock->millis();
+
+    if (currentState == NodeState::MASTER) {
+        if (id == myId) return false;
+        if (!outranks(term, id)) {
+            // A stale or lesser claim: our beacon settles it
+            beaconDue = true;
+            return false;
         }
+        Serial.printf("Mesh: %llX holds a newer lease (term %u), stepping down\r\n", id, term);
+    } else if (currentState == NodeState::SLAVE && id != masterId && !outranks(term, id)) {
+        // Leftover from an older term; it steps down once it hears our master
+        return false;
     }
-    else if (currentState == NodeState::MASTER) {
-        // Another master? Higher ID wins
-        if (msg.senderId > myId) {
-            Serial.println("Higher priority master detected, becoming slave");
-            masterId = msg.senderId;
-            lastHeartbeatTime = millis();
-            currentState = NodeState::SLAVE;
-        }
+
+    if (id != masterId || currentState != NodeState::SLAVE) {
+        Serial.print("Master detected: ");
+        Serial.println(String(id, HEX));
+        successorRank = -1;
+        successorCount = 0;
+        leaseMs = LEASE_MS;
+    }
+    masterId = id;
+    if ((int32_t)(term - leaderTerm) > 0) leaderTerm = term;
+    lastHeartbeatTime = now;
+    currentState = NodeState::SLAVE;
+    electionInProgress = false;
+    return true;
+}
+
+void MeshNetworkManager::handleHeartbeat(const MeshMessage& msg) {
+    // Beacons from older firmware carry nothing: term 0, default lease
+    LeaderBeaconPayload beacon = {};
+    memcpy(&beacon, msg.data, std::min<size_t>(msg.dataLength, sizeof(LeaderBeaconPayload)));
+    if (!acceptLeader(msg.senderId, beacon.term)) return;
+
+    if (beacon.leaseMs) leaseMs = beacon.leaseMs;
+    successorCount = std::min<uint8_t>(beacon.successorCount, LEASE_MAX_SUCCESSORS);
+    memcpy(successorList, beacon.successors, sizeof(successorList));
+    successorRank = -1;
+    for (int i = 0; i < successorCount; i++) {
+        if (successorList[i] == myId) successorRank = i;
     }
 }
 
 void MeshNetworkManager::handleElection(const MeshMessage& msg) {
+    // A lease holder answers with its beacon; its slaves leave that to it
+    if (currentState == NodeState::MASTER) {
+        beaconDue = true;
+        return;
+    }
+    if (currentState == NodeState::SLAVE && clock->millis() - lastHeartbeatTime <= leaseMs) return;
+    if (retiring) return;
+
     if (msg.senderId < myId) {
         // Send OK, we have higher priority
         Serial.println("Sending OK (higher priority)");
@@ -506,46 +959,51 @@ void MeshNetworkManager::handleElection(const MeshMessage& msg) {
         sendMessage(response);
 
         // Start our own election if not already in progress
-        if (currentState != NodeState::ELECTION && currentState != NodeState::MASTER) {
+        if (currentState != NodeState::ELECTION) {
             startElection();
         }
     }
 }
 
 void MeshNetworkManager::handleOK(const MeshMessage& msg) {
-    if (currentState == NodeState::ELECTION) {
+    // OKs are broadcast: only one from a higher ID means someone outranks us
+    if (currentState == NodeState::ELECTION && msg.senderId > myId) {
         Serial.println("Received OK, waiting for coordinator");
         receivedOK = true;
     }
 }
 
 void MeshNetworkManager::handleCoordinator(const MeshMessage& msg) {
-    if (msg.senderId >= myId || currentState == NodeState::ELECTION) {
-        Serial.print("New coordinator: ");
-        Serial.println(String(msg.senderId, HEX));
-        masterId = msg.senderId;
-        lastHeartbeatTime = millis();
-        currentState = NodeState::SLAVE;
-        electionInProgress = false;
+    CoordinatorPayload claim = {};
+    memcpy(&claim, msg.data, std::min<size_t>(msg.dataLength, sizeof(CoordinatorPayload)));
+    if (acceptLeader(msg.senderId, claim.term)) {
+        Serial.printf("New coordinator: %llX (term %u)\r\n", msg.senderId, claim.term);
     }
 }
 
 void MeshNetworkManager::handleShutdown(const MeshMessage& msg) {
-    if (msg.senderId == masterId) {
-        Serial.println("Master shutting down, starting election");
-        startElection();
+    if (msg.senderId == masterId && currentState == NodeState::SLAVE) {
+        // Treat the lease as lapsed now, so successors start claiming
+        Serial.println("Master shutting down, releasing its lease");
+        lastHeartbeatTime = clock->millis() - leaseMs;
     }
 }
 
 void MeshNetworkManager::startElection() {
     Serial.println("Starting election");
+    MeshStats::bump(stats.elections);
     currentState = NodeState::ELECTION;
-    lastElectionTime = millis();
     receivedOK = false;
     electionInProgress = true;
 
-    // Add small random delay to avoid collisions
-    delay(random(10, 50));
+    // Small random hold-off so nodes that noticed together don't collide; update() sends it
+    electionSent = false;
+    electionSendAt = clock->millis() + random(10, 50);
+}
+
+void MeshNetworkManager::sendElection() {
+    electionSent = true;
+    lastElectionTime = clock->millis();
 
     MeshMessage msg;
     msg.type = MessageType::ELECTION;
@@ -558,106 +1016,738 @@ void MeshNetworkManager::startElection() {
     sendMessage(msg);
 }
 
-void MeshNetworkManager::becomeCoordinator() {
+void MeshNetworkManager::becomeCoordinator(uint32_t term) {
     Serial.println("=== Becoming Master ===");
     currentState = NodeState::MASTER;
     masterId = myId;
-    lastHeartbeatTime = millis();
+    leaderTerm = term;
+    lastHeartbeatTime = clock->millis();
     electionInProgress = false;
+    successorRank = -1;
+    successorCount = 0;
+    refreshSuccessors();
+    lastSuccessorCheck = clock->millis();
 
     // Announce coordinator
+    CoordinatorPayload claim;
+    claim.term = leaderTerm;
+
     MeshMessage msg;
     msg.type = MessageType::COORDINATOR;
     msg.senderId = myId;
     msg.sequenceNumber = sequenceNumber++;
     msg.totalPackets = 1;
     msg.packetIndex = 0;
-    msg.dataLength = 0;
+    msg.dataLength = sizeof(CoordinatorPayload);
+    memcpy(msg.data, &claim, sizeof(CoordinatorPayload));
 
     sendMessage(msg);
+
+    // Followed by a beacon naming our successors
+    beaconDue = true;
+}
+
+bool MeshNetworkManager::refreshSuccessors() {
+    // Peers we've heard lately, highest IDs first as the election would rank them
+    unsigned long now = clock->millis();
+    uint64_t ranked[LEASE_MAX_SUCCESSORS] = {};
+    uint8_t count = 0;
+    portENTER_CRITICAL(&peerMux);
+    knownPeers.forEach([&](const PeerInfo& peer) {
+        if (now - peer.lastSeen > SUCCESSOR_FRESH_MS) return;
+        if (count == LEASE_MAX_SUCCESSORS && peer.id < ranked[count - 1]) return;
+        int i = count < LEASE_MAX_SUCCESSORS ? count++ : count - 1;
+        while (i > 0 && ranked[i - 1] < peer.id) {
+            ranked[i] = ranked[i - 1];
+            i--;
+        }
+        ranked[i] = peer.id;
+    });
+    portEXIT_CRITICAL(&peerMux);
+
+    bool changed = count != successorCount || memcmp(ranked, successorList, sizeof(ranked)) != 0;
+    memcpy(successorList, ranked, sizeof(ranked));
+    successorCount = count;
+    return changed;
 }
 
 void MeshNetworkManager::sendHeartbeat() {
+    unsigned long now = clock->millis();
+    lastBeaconTime = now;
+    lastBroadcastTime = now;
+    beaconDue = false;
+
+    LeaderBeaconPayload beacon = {};
+    beacon.term = leaderTerm;
+    beacon.leaseMs = LEASE_MS;
+    beacon.successorCount = successorCount;
+    memcpy(beacon.successors, successorList, sizeof(beacon.successors));
+
     MeshMessage msg;
     msg.type = MessageType::HEARTBEAT;
     msg.senderId = myId;
     msg.sequenceNumber = sequenceNumber++;
     msg.totalPackets = 1;
     msg.packetIndex = 0;
-    msg.dataLength = 0;
+    msg.dataLength = offsetof(LeaderBeaconPayload, successors) + successorCount * sizeof(uint64_t);
+    memcpy(msg.data, &beacon, msg.dataLength);
 
     sendMessage(msg);
 }
 
-void MeshNetworkManager::sendMessage(const MeshMessage& msg) {
-    esp_err_t result = esp_now_send(broadcastAddress, (uint8_t*)&msg, sizeof(MeshMessage));
-    if (result != ESP_OK) {
-        Serial.print("Send failed: ");
-        Serial.println(result);
+void MeshNetworkManager::processHandover(unsigned long now) {
+    uint8_t state = handoverState;
+    if (state == HANDOVER_REQUESTED) {
+        if (currentState != NodeState::MASTER) {
+            handoverState = HANDOVER_DONE;
+            return;
+        }
+        refreshSuccessors();
+        memcpy(handoverTargets, successorList, sizeof(handoverTargets));
+        handoverTargetCount = successorCount;
+        handoverTarget = 0;
+        handoverAttempts = 0;
+        nextHandoverSend = now;
+        handoverState = state = HANDOVER_ACTIVE;
+    }
+    if (state != HANDOVER_ACTIVE) return;
+
+    // Confirmed: the successor's COORDINATOR outranked us and we now follow it
+    if (currentState != NodeState::MASTER) {
+        Serial.printf("Mesh: handed over to %llX\r\n", masterId);
+        MeshStats::bump(stats.handovers);
+        handoverState = HANDOVER_DONE;
+        return;
+    }
+
+    if ((long)(now - nextHandoverSend) < 0) return;
+    if (handoverAttempts >= HANDOVER_ATTEMPTS) {
+        handoverTarget++;
+        handoverAttempts = 0;
+    }
+    if (handoverTarget >= handoverTargetCount) {
+        // Nobody answered: fall back to letting the lease lapse on purpose
+        Serial.println("Mesh: no successor took over, releasing lease");
+        releaseLease();
+        handoverState = HANDOVER_FAILED;
+        return;
     }
+
+    sendHandover(handoverTargets[handoverTarget]);
+    handoverAttempts++;
+    nextHandoverSend = now + HANDOVER_RETRY_MS;
 }
 
-void MeshNetworkManager::sendPeerAnnouncement() {
+void MeshNetworkManager::sendHandover(uint64_t successorId) {
+    HandoverPayload handover = {};
+    handover.successorId = successorId;
+    handover.term = leaderTerm + 1;
+    handover.networkTime = 0; // Stamped by dispatch() as the frame goes out
+    handover.groupHash = myGroupHash.load();
+    if (animManager) {
+        handover.powerOn = animManager->getPower() ? 1 : 0;
+        strncpy(handover.animationName, animManager->getCurrentAnimationName().c_str(), sizeof(handover.animationName) - 1);
+    }
+
     MeshMessage msg;
-    msg.type = MessageType::PEER_ANNOUNCEMENT;
+    msg.type = MessageType::HANDOVER;
     msg.senderId = myId;
     msg.sequenceNumber = sequenceNumber++;
-    
-    PeerAnnouncementPayload payload;
-    payload.ip = (uint32_t)WiFi.localIP();
-    payload.role = currentState;
-    strncpy(payload.groupName, myGroupName.c_str(), 31);
-    payload.groupName[31] = '\0';
-    strncpy(payload.deviceName, myDeviceName.c_str(), 31);
-    payload.deviceName[31] = '\0';
+    msg.totalPackets = 1;
+    msg.packetIndex = 0;
+    msg.dataLength = sizeof(HandoverPayload);
+    memcpy(msg.data, &handover, sizeof(HandoverPayload));
 
-    memcpy(msg.data, &payload, sizeof(PeerAnnouncementPayload));
+    Serial.printf("Mesh: offering lease (term %u) to %llX\r\n", handover.term, successorId);
+    sendTo(successorId, msg);
+}
+
+void MeshNetworkManager::handleHandover(const MeshMessage& msg) {
+    if (msg.dataLength < sizeof(HandoverPayload)) return;
+    if (currentState != NodeState::SLAVE || msg.senderId != masterId || retiring) return;
+
+    HandoverPayload handover;
+    memcpy(&handover, msg.data, sizeof(HandoverPayload));
+    if (handover.successorId != myId) return;
+    handover.animationName[sizeof(handover.animationName) - 1] = '\0';
+
+    // Time base: one last sample of the master's clock across this frame, one
+    // way, taking half the last measured round trip as the flight time
+    if (hasSyncedOnce) {
+        int64_t delay = stats.syncDelay.load(std::memory_order_relaxed);
+        addClockSample(currentRxMicros, handover.networkTime + delay / 2 - currentRxMicros, delay);
+    }
+
+    // Scene: only meaningful within the master's own group (e.g. as pixel stream source)
+    if (animManager && inGroup() && handover.groupHash == myGroupHash.load()) {
+        if (handover.animationName[0] && animManager->getCurrentAnimationName() != handover.animationName) {
+            stageScene(getNetworkTime(), handover.animationName, nullptr, 0);
+        }
+        if (animManager->getPower() != (handover.powerOn != 0)) {
+            animManager->setPower(handover.powerOn != 0);
+        }
+    }
+
+    Serial.printf("Mesh: taking over from %llX (term %u)\r\n", msg.senderId, handover.term);
+    becomeCoordinator(handover.term);
+}
+
+void MeshNetworkManager::sendMessage(MeshMessage& msg) {
+    msg.groupHash = isGroupScoped(msg.type) ? myGroupHash.load() : 0;
+    msg.ttl = MESH_DEFAULT_TTL;
+    msg.relayId = nextRelayId.fetch_add(1, std::memory_order_relaxed);
+    enqueue(msg, 0, coalesceKey(msg));
+}
+
+void MeshNetworkManager::sendTo(uint64_t nodeId, MeshMessage& msg) {
+    msg.groupHash = isGroupScoped(msg.type) ? myGroupHash.load() : 0;
+    msg.ttl = 0; // Point to point, never relayed
+    msg.relayId = nextRelayId.fetch_add(1, std::memory_order_relaxed);
+    enqueue(msg, nodeId, coalesceKey(msg));
+}
+
+void MeshNetworkManager::enqueue(const MeshMessage& msg, uint64_t dest, uint64_t key) {
+    portENTER_CRITICAL(&outboxMux);
+    auto result = outbox.push((uint8_t)priorityFor(msg.type), key, dest, msg);
+    portEXIT_CRITICAL(&outboxMux);
+
+    typedef MeshOutbox<MeshMessage, OUTBOX_CAPACITY>::Result Result;
+    if (result == Result::COALESCED) MeshStats::bump(stats.outboxCoalesced);
+    if (result == Result::EVICTED || result == Result::DROPPED) MeshStats::bump(stats.outboxDrops);
+
+    // Queued from the web or animation task: wake the mesh task to send it
+    TaskHandle_t task = rxTask;
+    if (task && task != xTaskGetCurrentTaskHandle()) xTaskNotifyGive(task);
+}
+
+MeshPriority MeshNetworkManager::priorityFor(MessageType type) {
+    switch (type) {
+        case MessageType::TIME_SYNC_REQUEST:
+        case MessageType::TIME_SYNC_RESPONSE:
+        case MessageType::AUDIO_FEATURES:
+        case MessageType::EVENT:
+            return MeshPriority::REALTIME;
+        case MessageType::PIXEL_FRAME:
+            return MeshPriority::STREAM;
+        case MessageType::SAVE_PRESET:
+        case MessageType::BULK_END:
+        case MessageType::PRESET_DIGEST:
+        case MessageType::PRESET_BUCKET_REQUEST:
+        case MessageType::PRESET_BUCKET_ENTRIES:
+        case MessageType::REQUEST_PRESET_DATA:
+            return MeshPriority::BULK;
+        default:
+            return MeshPriority::CONTROL;
+    }
+}
+
+uint64_t MeshNetworkManager::coalesceKey(const MeshMessage& msg) {
+    // Frames that only carry current state: a newer one makes a queued one pointless
+    uint64_t type = ((uint64_t)msg.type + 1) << 32;
+    switch (msg.type) {
+        case MessageType::HEARTBEAT:
+        case MessageType::PEER_ANNOUNCEMENT:
+        case MessageType::ANIMATION_STATE:
+        case MessageType::SYNC_POWER:
+        case MessageType::AUDIO_FEATURES:
+        case MessageType::PRESET_DIGEST:
+        case MessageType::TIME_SYNC_REQUEST:
+            return type;
+        case MessageType::SYNC_PARAM: {
+            SyncParamHeader header;
+            memcpy(&header, msg.data, sizeof(SyncParamHeader));
+            return type | header.paramId;
+        }
+        case MessageType::ASSIGN_GROUP: {
+            uint64_t targetId;
+            memcpy(&targetId, msg.data, sizeof(uint64_t));
+            return type | (uint32_t)(targetId ^ (targetId >> 32));
+        }
+        default:
+            return 0;
+    }
+}
+
+size_t MeshNetworkManager::outboxCount(MeshPriority priority) const {
+    portENTER_CRITICAL(&outboxMux);
+    size_t n = outbox.count((uint8_t)priority);
+    portEXIT_CRITICAL(&outboxMux);
+    return n;
+}
+
+static inline int64_t airtimeMicros(size_t frameLength) {
+    // 1 Mbps long preamble, plus the action frame wrapping ESP-NOW puts around our bytes
+    return 192 + (int64_t)(frameLength + 43) * 8;
+}
+
+void MeshNetworkManager::processOutbox() {
+    while (true) {
+        // One frame on air at a time; the send callback wakes us for the next
+        if (txBusy && clock->millis() - txStartTime < TX_COMPLETE_TIMEOUT_MS) return;
+
+        int64_t now = clock->micros();
+        airtimeCredit += (now - airtimeRefillTime) * AIRTIME_SHARE_PERCENT / 100;
+        if (airtimeCredit > AIRTIME_BURST_US) airtimeCredit = AIRTIME_BURST_US;
+        airtimeRefillTime = now;
+
+        MeshMessage msg;
+        uint64_t dest;
+        portENTER_CRITICAL(&outboxMux);
+        const auto* entry = outbox.front();
+        if (!entry || (entry->priority != (uint8_t)MeshPriority::REALTIME && airtimeCredit < 0)) {
+            portEXIT_CRITICAL(&outboxMux);
+            return;
+        }
+        msg = entry->msg;
+        dest = entry->dest;
+        outbox.popFront();
+        portEXIT_CRITICAL(&outboxMux);
+
+        airtimeCredit -= airtimeMicros(MESH_HEADER_SIZE + msg.dataLength);
+        dispatch(msg, dest);
+    }
+}
+
+void MeshNetworkManager::dispatch(MeshMessage& msg, uint64_t dest) {
+    // Time sync stamps are taken as the frame leaves, so queueing can't skew them
+    if (msg.type == MessageType::TIME_SYNC_REQUEST) {
+        TimeSyncRequestPayload request;
+        memcpy(&request, msg.data, sizeof(TimeSyncRequestPayload));
+        request.t1 = clock->micros();
+        pendingTimeSyncT1 = request.t1;
+        memcpy(msg.data, &request, sizeof(TimeSyncRequestPayload));
+    } else if (msg.type == MessageType::TIME_SYNC_RESPONSE) {
+        TimeSyncResponsePayload response;
+        memcpy(&response, msg.data, sizeof(TimeSyncResponsePayload));
+        response.t3 = getNetworkTimeMicros();
+        memcpy(msg.data, &response, sizeof(TimeSyncResponsePayload));
+    } else if (msg.type == MessageType::HANDOVER) {
+        HandoverPayload handover;
+        memcpy(&handover, msg.data, sizeof(HandoverPayload));
+        handover.networkTime = getNetworkTimeMicros();
+        memcpy(msg.data, &handover, sizeof(HandoverPayload));
+    }
+
+    if (dest) {
+        uint8_t mac[6];
+        idToMac(dest, mac);
+        if (registerUnicastPeer(dest, mac)) {
+            unicastFallbackArmed = false;
+            memcpy(unicastFallback.mac, mac, 6);
+            unicastFallback.msg = msg;
+            unicastFallbackDue = false;
+            unicastFallbackArmed = true;
+            if (transmit(msg, mac)) return;
+            unicastFallbackArmed = false;
+        }
+        // Same relayId, so a target that did get the unicast drops this copy
+        msg.ttl = MESH_DEFAULT_TTL;
+    }
+
+    // Only our own frames that every node acts on renew the lease: other groups
+    // drop the rest, and a relayed frame carries its origin's ID, not ours
+    if (msg.senderId == myId && !isGroupScoped(msg.type)) lastBroadcastTime = clock->millis();
+
+    transmit(msg);
+}
+
+bool MeshNetworkManager::transmit(const MeshMessage& msg, const uint8_t* dest) {
+    if (msg.dataLength > MESH_MAX_DATA) {
+        MeshStats::bump(stats.txFailures);
+        Serial.printf("Send failed: dataLength %u too large\r\n", msg.dataLength);
+        return false;
+    }
+    // Header + payload only; the unused tail of data[] is never transmitted
+    txStartTime = clock->millis();
+    txBusy = true;
+    if (!radio->send(dest, (const uint8_t*)&msg, MESH_HEADER_SIZE + msg.dataLength)) {
+        txBusy = false;
+        MeshStats::bump(stats.txFailures);
+        return false;
+    }
+
+    uint8_t typeIndex = (uint8_t)msg.type;
+    if (typeIndex < MESH_STATS_TYPES) {
+        MeshStats::bump(stats.types[typeIndex].txPackets);
+        MeshStats::bump(stats.types[typeIndex].txBytes, MESH_HEADER_SIZE + msg.dataLength);
+    }
+    return true;
+}
+
+bool MeshNetworkManager::registerUnicastPeer(uint64_t id, const uint8_t* mac) {
+    unsigned long now = clock->millis();
+    UnicastPeer* slot = &unicastPeers[0];
+    for (UnicastPeer& peer : unicastPeers) {
+        if (peer.id == id) {
+            peer.lastUsed = now;
+            return true;
+        }
+        if (peer.id == 0) {
+            if (slot->id != 0) slot = &peer;
+        } else if (slot->id != 0 && (long)(peer.lastUsed - slot->lastUsed) < 0) {
+            slot = &peer;
+        }
+    }
+
+    if (slot->id != 0) {
+        uint8_t oldMac[6];
+        idToMac(slot->id, oldMac);
+        radio->removePeer(oldMac);
+        slot->id = 0;
+    }
+
+    if (!radio->addPeer(mac)) {
+        Serial.printf("Mesh: Failed to add unicast peer %016llX\r\n", id);
+        return false;
+    }
+
+    slot->id = id;
+    slot->lastUsed = now;
+    return true;
+}
+
+void MeshNetworkManager::processUnicastFallback() {
+    if (!unicastFallbackDue.exchange(false)) return;
+
+    // Out of direct range (or asleep); let relays try
+    MeshMessage& msg = unicastFallback.msg;
+    msg.ttl = MESH_DEFAULT_TTL;
+    enqueue(msg, 0, 0);
+    MeshStats::bump(stats.unicastFallbacks);
+    Serial.printf("Mesh: Unicast %s not acknowledged, broadcasting\r\n", messageTypeName(msg.type));
+}
+
+void MeshNetworkManager::buildPeerAnnouncement(PeerAnnouncementPayload& payload) const {
+    memset(&payload, 0, sizeof(PeerAnnouncementPayload));
+    payload.ip = (uint32_t)WiFi.localIP();
+    payload.role = currentState;
+    strncpy(payload.groupName, getGroupName().c_str(), 31);
+    strncpy(payload.deviceName, myDeviceName.c_str(), 31);
+    payload.capabilities = MESH_CAP_LZSS;
+    payload.timeStratum = getTimeStratum();
+}
+
+void MeshNetworkManager::sendPeerAnnouncement() {
+    MeshMessage msg;
+    msg.type = MessageType::PEER_ANNOUNCEMENT;
+    msg.senderId = myId;
+    msg.sequenceNumber = sequenceNumber++;
+    msg.totalPackets = 1;
+    msg.packetIndex = 0;
+    
+    PeerAnnouncementPayload payload;
+    buildPeerAnnouncement(payload);
+
+    memcpy(msg.data, &payload, sizeof(PeerAnnouncementPayload));
     msg.dataLength = sizeof(PeerAnnouncementPayload);
     
     sendMessage(msg);
 }
 
 void MeshNetworkManager::handlePeerAnnouncement(const MeshMessage& msg) {
-    if (msg.dataLength < sizeof(PeerAnnouncementPayload)) return;
-    
-    PeerAnnouncementPayload* payload = (PeerAnnouncementPayload*)msg.data;
+    // Older firmware stops short of the capabilities byte
+    if (msg.dataLength < offsetof(PeerAnnouncementPayload, capabilities)) return;
+    
+    PeerAnnouncementPayload payload = {};
+    payload.timeStratum = MESH_TIME_STRATUM_NONE;
+    memcpy(&payload, msg.data, msg.dataLength < sizeof(payload) ? msg.dataLength : sizeof(payload));
+    payload.groupName[sizeof(payload.groupName) - 1] = '\0';
+    payload.deviceName[sizeof(payload.deviceName) - 1] = '\0';
+    
+    unsigned long now = clock->millis();
+    bool isNew;
+
+    portENTER_CRITICAL(&peerMux);
+    PeerInfo* peer = knownPeers.upsert(msg.senderId, isNew);
+    bool news = isNew ||
+                peer->ip != payload.ip ||
+                peer->role != payload.role ||
+                strcmp(peer->groupName, payload.groupName) != 0 ||
+                strcmp(peer->deviceName, payload.deviceName) != 0 ||
+                peer->capabilities != payload.capabilities;
+    bool changed = news || now - peer->lastSeenReported >= PEER_SEEN_RESOLUTION_MS;
+    peer->ip = payload.ip;
+    peer->role = payload.role;
+    memcpy(peer->groupName, payload.groupName, sizeof(peer->groupName));
+    memcpy(peer->deviceName, payload.deviceName, sizeof(peer->deviceName));
+    peer->capabilities = payload.capabilities;
+    // Not news: only time sync reads it, and a node's sync settles every
+    // neighbour's stratum at once, which would otherwise restart all Trickles
+    peer->timeStratum = payload.timeStratum;
+    peer->lastSeen = now;
+    if (changed) {
+        // Plain refreshes only show up every PEER_SEEN_RESOLUTION_MS so cached JSON stays valid
+        peer->lastSeenReported = now;
+        knownPeers.touch();
+    }
+    portEXIT_CRITICAL(&peerMux);
+
+    // Someone new or changed: they (and anyone else catching up) hear from us soon
+    if (news) announceTrickle.inconsistent(now);
     
-    // Update or Add peer
-    bool found = false;
-    for (auto& peer : knownPeers) {
-        if (peer.id == msg.senderId) {
-            peer.ip = payload->ip;
-            peer.role = payload->role;
-            peer.groupName = payload->groupName;
-            peer.deviceName = payload->deviceName;
-            peer.lastSeen = millis();
-            found = true;
-            break;
+    if (isNew) {
+        Serial.printf("New Peer Discovered: %016llX at IP %u, Name: %s, Group: %s\r\n", msg.senderId, payload.ip, payload.deviceName, payload.groupName);
+    }
+}
+
+size_t MeshNetworkManager::getPeers(PeerInfo* out, size_t maxPeers) const {
+    size_t n = 0;
+    portENTER_CRITICAL(&peerMux);
+    knownPeers.forEach([&](const PeerInfo& peer) {
+        if (n < maxPeers) out[n++] = peer;
+    });
+    portEXIT_CRITICAL(&peerMux);
+    return n;
+}
+
+uint32_t MeshNetworkManager::getPeerGeneration() const {
+    portENTER_CRITICAL(&peerMux);
+    uint32_t generation = knownPeers.generation();
+    portEXIT_CRITICAL(&peerMux);
+    return generation;
+}
+
+void MeshNetworkManager::trackPeerFrame(const MeshMessage& msg, uint64_t from) {
+    bool direct = from == msg.senderId;
+    // Sequence numbers only say something about the link for broadcasts heard
+    // straight from their origin, sent in the order they were numbered:
+    // - relayed copies take jittered paths
+    // - unicasts (ttl 0) skip the rest of us; leaving them out means their late
+    //   broadcast copies after a missing ACK rarely trail a tracked number
+    // - bulk chunks and pixel packets reuse one number per transfer / frame
+    // - a coalesced frame takes over an older one's turn in the outbox
+    bool sequenced = direct && msg.ttl != 0 && msg.type != MessageType::SAVE_PRESET &&
+                     msg.type != MessageType::PIXEL_FRAME && coalesceKey(msg) == 0;
+    // The outbox sends more urgent classes first: numbers only rise within a class
+    uint8_t priority = (uint8_t)priorityFor(msg.type);
+    uint8_t bit = 1 << priority;
+    bool duplicate = false;
+    bool reordered = false;
+    unsigned long now = clock->millis();
+
+    portENTER_CRITICAL(&peerMux);
+    // Whoever transmitted it is in range, which is what a time source needs
+    PeerInfo* neighbour = knownPeers.find(from);
+    if (neighbour) neighbour->lastHeard = now;
+    PeerInfo* peer = knownPeers.find(msg.senderId);
+    if (peer) {
+        // Doesn't touch the generation; lastSeenReported keeps snapshots stable
+        peer->lastSeen = now;
+        if (direct && currentRxRssi) peer->rssi = currentRxRssi; // Relayed copies show the relay's signal
+
+        if (sequenced) {
+            bool known = peer->sequenced & bit;
+            int32_t delta = (int32_t)(msg.sequenceNumber - peer->lastSequence[priority]);
+            if (known && delta == 0) {
+                duplicate = true;
+            } else if (known && delta < 0 && delta > -SEQUENCE_REORDER_WINDOW) {
+                reordered = true;
+            } else {
+                peer->lastSequence[priority] = msg.sequenceNumber;
+                peer->sequenced |= bit;
+            }
         }
     }
-    
-    if (!found) {
-        knownPeers.push_back({msg.senderId, payload->ip, payload->role, payload->groupName, payload->deviceName, millis()});
-        Serial.printf("New Peer Discovered: %016llX at IP %u, Name: %s, Group: %s\r\n", msg.senderId, payload->ip, payload->deviceName, payload->groupName);
+    portEXIT_CRITICAL(&peerMux);
+
+    if (duplicate) MeshStats::bump(stats.duplicates);
+    if (reordered) MeshStats::bump(stats.outOfOrder);
+}
+
+const char* MeshNetworkManager::messageTypeName(MessageType type) {
+    switch (type) {
+        case MessageType::HEARTBEAT: return "HEARTBEAT";
+        case MessageType::ELECTION: return "ELECTION";
+        case MessageType::OK: return "OK";
+        case MessageType::COORDINATOR: return "COORDINATOR";
+        case MessageType::PEER_ANNOUNCEMENT: return "PEER_ANNOUNCEMENT";
+        case MessageType::SHUTDOWN: return "SHUTDOWN";
+        case MessageType::ANIMATION_STATE: return "ANIMATION_STATE";
+        case MessageType::QUERY_PRESET: return "QUERY_PRESET";
+        case MessageType::PRESET_EXIST_RESPONSE: return "PRESET_EXIST_RESPONSE";
+        case MessageType::SAVE_PRESET: return "SAVE_PRESET";
+        case MessageType::DELETE_PRESET: return "DELETE_PRESET";
+        case MessageType::CHECK_FOR_UPDATES: return "CHECK_FOR_UPDATES";
+        case MessageType::RENAME_PRESET: return "RENAME_PRESET";
+        case MessageType::ASSIGN_GROUP: return "ASSIGN_GROUP";
+        case MessageType::SYNC_PARAM: return "SYNC_PARAM";
+        case MessageType::SYNC_POWER: return "SYNC_POWER";
+        case MessageType::REQUEST_PRESET_DATA: return "REQUEST_PRESET_DATA";
+        case MessageType::AUDIO_FEATURES: return "AUDIO_FEATURES";
+        case MessageType::EVENT: return "EVENT";
+        case MessageType::BULK_END: return "BULK_END";
+        case MessageType::BULK_NACK: return "BULK_NACK";
+        case MessageType::PRESET_DIGEST: return "PRESET_DIGEST";
+        case MessageType::PRESET_BUCKET_REQUEST: return "PRESET_BUCKET_REQUEST";
+        case MessageType::PRESET_BUCKET_ENTRIES: return "PRESET_BUCKET_ENTRIES";
+        case MessageType::TIME_SYNC_REQUEST: return "TIME_SYNC_REQUEST";
+        case MessageType::TIME_SYNC_RESPONSE: return "TIME_SYNC_RESPONSE";
+        case MessageType::PIXEL_FRAME: return "PIXEL_FRAME";
+        case MessageType::HANDOVER: return "HANDOVER";
+        default: return "UNKNOWN";
     }
 }
 
 // ==========================================
-// PRESET PROPAGATION IMPLEMENTATION
+// MULTI-HOP RELAY
 // ==========================================
 
-bool MeshNetworkManager::checkPresetExists(const std::string& name) {
-    if (!animManager) return false;
-    
-    // 1. Check local first
-    if (animManager->exists(name)) {
+bool MeshNetworkManager::acceptRelayFrame(const MeshMessage& msg) {
+    unsigned long now = clock->millis();
+
+    for (const SeenFrame& seen : relaySeen) {
+        if (seen.origin != msg.senderId || seen.relayId != msg.relayId || now - seen.time >= RELAY_SEEN_MS) continue;
+
+        // Another copy means a neighbour relayed it; once enough have, ours adds nothing
+        for (PendingRelay& relay : pendingRelays) {
+            if (relay.active && relay.msg.senderId == msg.senderId && relay.msg.relayId == msg.relayId &&
+                ++relay.copiesHeard >= RELAY_SUPPRESS_COPIES) {
+                relay.active = false;
+                MeshStats::bump(stats.relaySuppressed);
+            }
+        }
+        return false;
+    }
+
+    relaySeen[relaySeenNext] = {msg.senderId, msg.relayId, now};
+    relaySeenNext = (relaySeenNext + 1) % RELAY_SEEN_SIZE;
+
+    if (!relayEnabled || msg.ttl == 0) return true;
+
+    for (PendingRelay& relay : pendingRelays) {
+        if (relay.active) continue;
+        // Jitter spreads out neighbours that heard the same frame at the same instant
+        relay.active = true;
+        relay.copiesHeard = 0;
+        relay.due = now + random(RELAY_JITTER_MIN_MS, RELAY_JITTER_MAX_MS + 1);
+        relay.msg = msg;
+        relay.msg.ttl--;
         return true;
     }
-    
-    // 2. Query Network
-    lastQueryFound = false;
-    lastQueryName = name;
-    
+    return true; // Relay slots full; others in range will likely cover it
+}
+
+void MeshNetworkManager::processRelays() {
+    unsigned long now = clock->millis();
+    for (PendingRelay& relay : pendingRelays) {
+        if (!relay.active || (long)(now - relay.due) < 0) continue;
+        relay.active = false;
+        enqueue(relay.msg, 0, 0); // Never coalesced: keys only describe our own frames
+        MeshStats::bump(stats.relayed);
+    }
+}
+
+unsigned long MeshNetworkManager::getIdleWaitMs() const {
+    unsigned long wait = 50;
+    unsigned long now = clock->millis();
+
+    // Queued frames waiting on airtime credit (a busy radio wakes us on completion)
+    portENTER_CRITICAL(&outboxMux);
+    bool queued = outbox.size() > 0;
+    portEXIT_CRITICAL(&outboxMux);
+    if (queued) {
+        if (txBusy) wait = TX_COMPLETE_TIMEOUT_MS;
+        else if (airtimeCredit < 0) wait = (unsigned long)(-airtimeCredit * 100 / AIRTIME_SHARE_PERCENT / 1000) + 1;
+        else return 1;
+    }
+
+    // Timed work on this task, sooner than the housekeeping tick
+    auto until = [&](unsigned long due) {
+        long left = (long)(due - now);
+        if (left < (long)wait) wait = left > 1 ? left : 1;
+    };
+    for (const PendingRelay& relay : pendingRelays) {
+        if (relay.active) until(relay.due);
+    }
+    // Bulk: NACKs we owe (scheduled, or asked again after a quiet spell) and
+    // the linger for NACKs after our own BULK_END
+    for (const InboundTransfer& session : inbound) {
+        if (!session.active || session.complete) continue;
+        until(session.nackTime ? session.nackTime : session.lastActivity + BULK_NACK_RETRY_MS + 1);
+    }
+    if (outboundActive && outbound.ending) until(outbound.lingerUntil);
+    // Planned handover: the next HANDOVER to a successor
+    if (handoverState == HANDOVER_ACTIVE) until(nextHandoverSend);
+    return wait;
+}
+
+void MeshNetworkManager::processGossip(unsigned long now) {
+    // A change to what we announce is news to everyone
+    PeerAnnouncementPayload announcement;
+    buildPeerAnnouncement(announcement);
+    uint32_t hash = fnv1a32((const uint8_t*)&announcement, sizeof(announcement));
+    if (hash != lastAnnouncementHash) {
+        lastAnnouncementHash = hash;
+        announceTrickle.inconsistent(now);
+    }
+
+    portENTER_CRITICAL(&peerMux);
+    unsigned long peers = knownPeers.size();
+    portEXIT_CRITICAL(&peerMux);
+    unsigned long announceMax = (peers + 1) * ANNOUNCE_SPACING_MS;
+    if (announceMax < ANNOUNCE_IMAX_MIN_MS) announceMax = ANNOUNCE_IMAX_MIN_MS;
+    if (announceMax > ANNOUNCE_IMAX_MAX_MS) announceMax = ANNOUNCE_IMAX_MAX_MS;
+    announceTrickle.setMax(announceMax);
+    if (announceTrickle.poll(now)) sendPeerAnnouncement();
+
+    // Preset digest: a change to our own set restarts the fast phase
+    if (animManager && now - lastDigestCheck >= PRESET_DIGEST_CHECK_MS) {
+        lastDigestCheck = now;
+        PresetDigestPayload digest;
+        buildPresetDigest(digest);
+        if (digest.root != lastDigestRoot) {
+            lastDigestRoot = digest.root;
+            digestTrickle.inconsistent(now);
+        }
+    }
+    bool suppressed = false;
+    if (digestTrickle.poll(now, &suppressed)) {
+        broadcastPresetDigest();
+    } else if (suppressed) {
+        MeshStats::bump(stats.gossipSuppressed);
+    }
+}
+
+// ==========================================
+// PRESET PROPAGATION IMPLEMENTATION
+// ==========================================
+
+int MeshNetworkManager::lookupPresetExists(const std::string& name) {
+    if (animManager && animManager->exists(name)) return 1;
+
+    unsigned long now = clock->millis();
+    std::lock_guard<std::mutex> lock(presetQueryMutex);
+    for (const auto& known : knownPresets) {
+        if (known.name == name && (long)(known.expires - now) > 0) return known.exists ? 1 : 0;
+    }
+    return -1;
+}
+
+uint32_t MeshNetworkManager::queryPresetExists(const std::string& name, PresetQueryCallback callback) {
+    int known = lookupPresetExists(name);
+    uint32_t id;
+    bool ask = true;
+    {
+        std::lock_guard<std::mutex> lock(presetQueryMutex);
+        // Too many in flight: no answer either way, the caller can ask again
+        if (known < 0 && presetQueries.size() >= MAX_PRESET_QUERIES) return 0;
+        id = nextPresetQueryId++;
+        if (nextPresetQueryId == 0) nextPresetQueryId = 1; // 0 means busy
+        if (known < 0) {
+            // One frame per name: later askers just wait on the same answer
+            for (const auto& query : presetQueries) {
+                if (query.name == name) ask = false;
+            }
+            presetQueries.push_back({id, name, clock->millis() + PRESET_QUERY_TIMEOUT_MS, callback});
+        }
+    }
+
+    if (known >= 0) {
+        if (callback) callback(id, known == 1);
+        return id;
+    }
+    if (!ask) return id;
+
     MeshMessage msg;
     msg.type = MessageType::QUERY_PRESET;
     msg.senderId = myId;
@@ -666,66 +1756,90 @@ bool MeshNetworkManager::checkPresetExists(const std::string& name) {
     msg.packetIndex = 0;
     
     // Payload is just the name
-    strncpy((char*)msg.data, name.c_str(), 229);
-    msg.data[229] = '\0'; 
+    strncpy((char*)msg.data, name.c_str(), MESH_MAX_DATA - 1);
+    msg.data[MESH_MAX_DATA - 1] = '\0'; 
     msg.dataLength = strlen((char*)msg.data) + 1;
     
     sendMessage(msg);
-    
-    // 3. Wait for response (blocking, up to 500ms)
-    unsigned long start = millis();
-    while (millis() - start < 500) {
-        // Yield to allow background tasks (esp-now callbacks) to run? 
-        // On ESP32 Arduino, callbacks happen in ISR or separate task, but update() runs in loop.
-        // We are blocking the loop here.
-        // If receive happens in ISR/task, 'lastQueryFound' will be set.
-        delay(10); 
-        if (lastQueryFound) return true;
+    return id;
+}
+
+void MeshNetworkManager::rememberPreset(const std::string& name, bool exists) {
+    unsigned long expires = clock->millis() + (exists ? PRESET_KNOWN_TTL_MS : PRESET_MISSING_TTL_MS);
+    std::lock_guard<std::mutex> lock(presetQueryMutex);
+    KnownPreset* slot = nullptr;
+    for (auto& known : knownPresets) {
+        if (known.name == name) {
+            slot = &known;
+            break;
+        }
+    }
+    if (!slot && knownPresets.size() < PRESET_CACHE_CAPACITY) {
+        knownPresets.push_back({name, exists, expires});
+        return;
+    }
+    if (!slot) {
+        // Full: replace whichever runs out first
+        slot = &knownPresets[0];
+        for (auto& known : knownPresets) {
+            if ((long)(known.expires - slot->expires) < 0) slot = &known;
+        }
+        slot->name = name;
+    }
+    slot->exists = exists;
+    slot->expires = expires;
+}
+
+void MeshNetworkManager::resolvePresetQueries(const std::string& name, bool exists) {
+    std::vector<PresetQuery> answered;
+    {
+        std::lock_guard<std::mutex> lock(presetQueryMutex);
+        for (auto it = presetQueries.begin(); it != presetQueries.end(); ) {
+            if (it->name == name) {
+                answered.push_back(std::move(*it));
+                it = presetQueries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // Outside the lock: callbacks may well ask again
+    for (auto& query : answered) {
+        if (query.callback) query.callback(query.id, exists);
+    }
+}
+
+void MeshNetworkManager::processPresetQueries(unsigned long now) {
+    std::vector<std::string> unanswered;
+    {
+        std::lock_guard<std::mutex> lock(presetQueryMutex);
+        for (const auto& query : presetQueries) {
+            if ((long)(now - query.deadline) >= 0 &&
+                std::find(unanswered.begin(), unanswered.end(), query.name) == unanswered.end()) {
+                unanswered.push_back(query.name);
+            }
+        }
+    }
+    for (const auto& name : unanswered) {
+        Serial.printf("Mesh: No node has preset '%s'\r\n", name.c_str());
+        rememberPreset(name, false);
+        resolvePresetQueries(name, false);
     }
-    
-    return false;
 }
 
 void MeshNetworkManager::broadcastSavePreset(const std::string& name, const std::string& baseType, const std::string& paramsJson) {
-    Serial.printf("Mesh: Broadcasting save preset '%s' (base: %s), JSON len: %d\r\n", name.c_str(), baseType.c_str(), paramsJson.length());
+    Serial.printf("Mesh: Queueing save preset '%s' (base: %s), JSON len: %d\r\n", name.c_str(), baseType.c_str(), paramsJson.length());
     
     // Format payload: Name\0BaseType\0JSONData
     std::vector<uint8_t> totalPayload;
+    totalPayload.reserve(name.length() + baseType.length() + paramsJson.length() + 2);
     totalPayload.insert(totalPayload.end(), name.begin(), name.end());
     totalPayload.push_back('\0');
     totalPayload.insert(totalPayload.end(), baseType.begin(), baseType.end());
     totalPayload.push_back('\0');
     totalPayload.insert(totalPayload.end(), paramsJson.begin(), paramsJson.end());
     
-    size_t totalLen = totalPayload.size();
-    uint8_t totalPackets = (totalLen + 229) / 230;
-    uint32_t seq = sequenceNumber++;
-    
-    // Repeat the broadcast 3 times for redundancy
-    for (int r = 0; r < 3; r++) {
-        for (int i = 0; i < totalPackets; i++) {
-            MeshMessage msg;
-            msg.type = MessageType::SAVE_PRESET;
-            msg.senderId = myId;
-            msg.sequenceNumber = seq;
-            msg.totalPackets = totalPackets;
-            msg.packetIndex = i;
-            
-            size_t offset = i * 230;
-            size_t chunkLen = totalLen - offset;
-            if (chunkLen > 230) chunkLen = 230;
-            
-            memcpy(msg.data, totalPayload.data() + offset, chunkLen);
-            msg.dataLength = chunkLen;
-            
-            sendMessage(msg);
-            // Slightly longer delay between packets to prevent congestion
-            delay(20); 
-        }
-        Serial.printf("Mesh: Sent preset broadcast round %d/3\r\n", r + 1);
-        delay(50); // Delay between rounds
-    }
-    Serial.println("Mesh: Preset broadcast complete");
+    sendBulk(MessageType::SAVE_PRESET, std::move(totalPayload));
 }
 
 void MeshNetworkManager::broadcastDeletePreset(const std::string& name) {
@@ -735,10 +1849,12 @@ void MeshNetworkManager::broadcastDeletePreset(const std::string& name) {
     msg.sequenceNumber = sequenceNumber++;
     msg.totalPackets = 1;
     msg.packetIndex = 0;
-    msg.dataLength = name.length() + 1;
+    strncpy((char*)msg.data, name.c_str(), MESH_MAX_DATA - 1);
+    msg.data[MESH_MAX_DATA - 1] = '\0';
+    msg.dataLength = strlen((char*)msg.data) + 1;
     
-    strncpy((char*)msg.data, name.c_str(), 229);
     sendMessage(msg);
+    rememberPreset(name, false);
     Serial.printf("Mesh: Delete preset '%s' broadcast complete\r\n", name.c_str());
 }
 
@@ -755,7 +1871,7 @@ void MeshNetworkManager::broadcastRenamePreset(const std::string& oldName, const
     payload += newName;
     payload += '\0';
     
-    if (payload.length() > 230) {
+    if (payload.length() > MESH_MAX_DATA) {
         Serial.println("Mesh: Rename payload too large!");
         return;
     }
@@ -764,15 +1880,17 @@ void MeshNetworkManager::broadcastRenamePreset(const std::string& oldName, const
     msg.dataLength = payload.length();
     
     sendMessage(msg);
+    rememberPreset(oldName, false);
+    rememberPreset(newName, true);
     Serial.printf("Mesh: Rename preset broadcast complete\r\n");
 }
 
 void MeshNetworkManager::handleQueryPreset(const MeshMessage& msg) {
     if (!animManager) return;
     
-    char name[230];
+    char name[MESH_MAX_DATA];
     memcpy(name, msg.data, msg.dataLength);
-    name[229] = '\0'; // Safety
+    name[MESH_MAX_DATA - 1] = '\0'; // Safety
     
     if (animManager->exists(name)) {
         // Send Response
@@ -787,103 +1905,44 @@ void MeshNetworkManager::handleQueryPreset(const MeshMessage& msg) {
         memcpy(response.data, name, strlen(name) + 1);
         response.dataLength = strlen(name) + 1;
         
-        sendMessage(response); 
+        sendTo(msg.senderId, response);
     }
 }
 
 void MeshNetworkManager::handlePresetExistResponse(const MeshMessage& msg) {
-    char name[230];
+    char name[MESH_MAX_DATA];
     memcpy(name, msg.data, msg.dataLength);
-    name[229] = '\0';
+    name[MESH_MAX_DATA - 1] = '\0';
     
-    if (lastQueryName == name) {
-        lastQueryFound = true;
-    }
+    rememberPreset(name, true);
+    resolvePresetQueries(name, true);
 }
 
-void MeshNetworkManager::handleSavePreset(const MeshMessage& msg) {
-    Serial.printf("Mesh: handleSavePreset called, packet %d/%d, seq %u\r\n", msg.packetIndex + 1, msg.totalPackets, msg.sequenceNumber);
-    
+void MeshNetworkManager::handleSavePreset(uint64_t senderId, const uint8_t* data, size_t length) {
     if (!animManager) {
         Serial.println("Mesh: handleSavePreset - animManager is NULL!");
         return;
     }
     
-    unsigned long now = millis();
+    // Unpack: Name\0BaseType\0JSON
+    const char* raw = (const char*)data;
+    const char* nameEnd = (const char*)memchr(raw, '\0', length);
+    if (!nameEnd) return;
+    size_t nameLen = nameEnd - raw + 1;
     
-    if (presetBuffer.sequenceNumber != msg.sequenceNumber) {
-        // New transfer
-        presetBuffer.sequenceNumber = msg.sequenceNumber;
-        presetBuffer.totalPackets = msg.totalPackets;
-        presetBuffer.receivedPackets = 0;
-        presetBuffer.data.clear();
-        presetBuffer.lastPacketTime = now;
-        
-        // Reserve estimated size
-        presetBuffer.data.resize(msg.totalPackets * 230);
-        
-        // Resize flags and reset
-        presetBuffer.receivedPacketFlags.resize(msg.totalPackets);
-        std::fill(presetBuffer.receivedPacketFlags.begin(), presetBuffer.receivedPacketFlags.end(), false);
-    }
+    const char* baseEnd = (const char*)memchr(raw + nameLen, '\0', length - nameLen);
+    if (!baseEnd) return;
+    size_t baseLen = baseEnd - (raw + nameLen) + 1;
     
-    // Packet Handling
-    if (msg.packetIndex < presetBuffer.totalPackets) {
-         // Check if we already have this packet
-         if (presetBuffer.receivedPacketFlags.size() > msg.packetIndex && presetBuffer.receivedPacketFlags[msg.packetIndex]) {
-             // Duplicate, ignore
-             return;
-         }
-
-         size_t offset = msg.packetIndex * 230;
-         if (offset + msg.dataLength <= presetBuffer.data.size()) {
-             memcpy(presetBuffer.data.data() + offset, msg.data, msg.dataLength);
-             presetBuffer.receivedPackets++;
-             
-             // Mark as received
-             if (presetBuffer.receivedPacketFlags.size() > msg.packetIndex) {
-                 presetBuffer.receivedPacketFlags[msg.packetIndex] = true;
-             }
-             
-             presetBuffer.lastPacketTime = now;
-         }
-    }
+    std::string pName(raw, nameLen - 1);
+    std::string pBase(raw + nameLen, baseLen - 1);
+    std::string pJson(raw + nameLen + baseLen, length - nameLen - baseLen);
     
-    // Check completion
-    if (presetBuffer.receivedPackets >= presetBuffer.totalPackets) {
-        // Unpack: Name\0BaseType\0JSON
-        const char* raw = (const char*)presetBuffer.data.data();
-        size_t totalSize = presetBuffer.data.size(); // Actually we might have resized too big, use explicit search?
-        // Wait, resize was max possible. 
-        // We need to trust null terminators.
-        
-        std::string pName = raw;
-        size_t nameLen = pName.length() + 1;
-        
-        if (nameLen < totalSize) {
-            std::string pBase = raw + nameLen;
-            size_t baseLen = pBase.length() + 1;
-            
-            if (nameLen + baseLen < totalSize) {
-                std::string pJson = raw + nameLen + baseLen;
-                
-                // Save it!
-                Serial.printf("Mesh: Saving preset '%s' (%s)\r\n", pName.c_str(), pBase.c_str());
-                if (animManager->savePresetFromData(pName, pBase, pJson)) {
-                    // Note: Don't call flashColor here - async callback context, blocking is bad
-                    Serial.println("Mesh: Preset saved successfully!");
-                } else {
-                    Serial.println("Mesh: Preset save FAILED!");
-                }
-            }
-        }
-        
-        // Reset
-
-        // Important: If we just saved a preset that we requested, we might want to reload or notify?
-        // simple loadPresets() is called inside savePresetFromData.
-        
-        presetBuffer.sequenceNumber = 0; 
+    Serial.printf("Mesh: Saving preset '%s' (%s) from %llX\r\n", pName.c_str(), pBase.c_str(), senderId);
+    if (animManager->savePresetFromData(pName, pBase, pJson)) {
+        Serial.println("Mesh: Preset saved successfully!");
+    } else {
+        Serial.println("Mesh: Preset save FAILED!");
     }
 }
 
@@ -891,92 +1950,204 @@ void MeshNetworkManager::handleSavePreset(const MeshMessage& msg) {
 // SYNC LOGIC
 // ==========================================
 
-void MeshNetworkManager::broadcastRequestSyncPresets() {
+static inline uint8_t presetBucket(const char* name) {
+    return fnv1a32(name) % PRESET_DIGEST_BUCKETS;
+}
+
+void MeshNetworkManager::buildPresetDigest(PresetDigestPayload& digest) const {
+    memset(&digest, 0, sizeof(PresetDigestPayload));
+    if (!animManager) return;
+
+    // Sums are order independent, so every node gets the same buckets for the same set
+    auto entries = animManager->getPresetDigests();
+    for (const auto& e : entries) {
+        digest.buckets[presetBucket(e.name.c_str())] += e.hash;
+    }
+    digest.count = entries.size();
+    digest.root = fnv1a32((const uint8_t*)digest.buckets, sizeof(digest.buckets));
+}
+
+void MeshNetworkManager::broadcastPresetDigest() {
+    PresetDigestPayload digest;
+    buildPresetDigest(digest);
+
     MeshMessage msg;
-    msg.type = MessageType::REQUEST_SYNC_PRESETS;
+    msg.type = MessageType::PRESET_DIGEST;
     msg.senderId = myId;
     msg.sequenceNumber = sequenceNumber++;
     msg.totalPackets = 1;
     msg.packetIndex = 0;
-    msg.dataLength = 0;
-    
+    msg.dataLength = sizeof(PresetDigestPayload);
+    memcpy(msg.data, &digest, sizeof(PresetDigestPayload));
+
     sendMessage(msg);
-    Serial.println("Mesh: Requested Preset Sync");
 }
 
-void MeshNetworkManager::handleRequestSyncPresets(const MeshMessage& msg) {
-    if (!animManager) return;
-    
-    // Queue all preset names for sending (non-blocking)
-    std::vector<std::string> names = animManager->getPresetNames();
-    
-    if (names.empty()) return;
-    
-    Serial.printf("Mesh: Queueing %d presets for manifest broadcast\r\n", names.size());
-    
-    // Add to queue
-    for (const auto& name : names) {
-        manifestQueue.names.push_back(name);
+void MeshNetworkManager::handlePresetDigest(const MeshMessage& msg) {
+    if (!animManager || msg.dataLength < sizeof(PresetDigestPayload)) return;
+
+    PresetDigestPayload theirs;
+    memcpy(&theirs, msg.data, sizeof(PresetDigestPayload));
+
+    PresetDigestPayload mine;
+    buildPresetDigest(mine);
+    unsigned long now = clock->millis();
+    if (theirs.root == mine.root) {
+        digestTrickle.consistent(); // In sync; they said what we would have
+        return;
     }
-    
-    // Schedule first send with random delay to avoid collision
-    unsigned long delayTime = random(100, 800);
-    manifestQueue.nextSendTime = millis() + delayTime;
-    manifestQueue.active = true;
-}
 
-void MeshNetworkManager::handlePresetManifest(const MeshMessage& msg) {
-    if (!animManager) return;
-    
-    char name[230];
-    memcpy(name, msg.data, msg.dataLength);
-    name[229] = '\0';
-    
-    // Check if we have this preset
-    if (!animManager->exists(name)) {
-        // Check duplication
-        unsigned long now = millis();
-        bool alreadyRequested = false;
-        
-        // Clean up old requests and check for duplicates
-        for (auto it = requestedPresets.begin(); it != requestedPresets.end(); ) {
-            if (now - it->requestTime > 30000) {
-                it = requestedPresets.erase(it); // expire old (30s timeout)
-            } else {
-                if (it->name == name) {
-                    alreadyRequested = true;
-                }
-                ++it;
-            }
+    // Skip peers we already reconciled against in this exact state. A pair
+    // that never converges (a partition, a preset that won't copy) must not
+    // pin the digest timer at Imin, so only a new pair resets it.
+    for (auto it = reconciled.begin(); it != reconciled.end(); ) {
+        if (now - it->time > PRESET_RECONCILE_MEMORY_MS) {
+            it = reconciled.erase(it);
+            continue;
         }
-        
-        // Also check if already in the request queue
-        for (const auto& req : dataRequestQueue.requests) {
-            if (req.name == name) {
-                alreadyRequested = true;
-                break;
-            }
+        if (it->peerId == msg.senderId) {
+            if (it->peerRoot == theirs.root && it->myRoot == mine.root) return;
+            it = reconciled.erase(it);
+            continue;
         }
+        ++it;
+    }
+    reconciled.push_back({msg.senderId, theirs.root, mine.root, now});
+
+    // Differing sets: digests speed up until everyone agrees, which also lets them pull from us
+    digestTrickle.inconsistent(now);
+
+    uint16_t mask = 0;
+    for (int i = 0; i < PRESET_DIGEST_BUCKETS; i++) {
+        if (theirs.buckets[i] != mine.buckets[i]) mask |= (1 << i);
+    }
+
+    // Only buckets where they have something can help us
+    if (theirs.count > 0) {
+        PresetBucketRequestPayload request;
+        request.targetId = msg.senderId;
+        request.bucketMask = mask;
+
+        MeshMessage out;
+        out.type = MessageType::PRESET_BUCKET_REQUEST;
+        out.senderId = myId;
+        out.sequenceNumber = sequenceNumber++;
+        out.totalPackets = 1;
+        out.packetIndex = 0;
+        out.dataLength = sizeof(PresetBucketRequestPayload);
+        memcpy(out.data, &request, sizeof(PresetBucketRequestPayload));
+        sendTo(msg.senderId, out);
+    }
+}
 
-        if (!alreadyRequested) {
-            Serial.printf("Mesh: Missing preset '%s', queuing request to %016llX\r\n", name, msg.senderId);
-            requestedPresets.push_back({name, now});
-            
-            // Queue the request instead of sending immediately
-            dataRequestQueue.requests.push_back({name, msg.senderId});
+void MeshNetworkManager::handlePresetBucketRequest(const MeshMessage& msg) {
+    if (!animManager || msg.dataLength < sizeof(PresetBucketRequestPayload)) return;
+
+    PresetBucketRequestPayload request;
+    memcpy(&request, msg.data, sizeof(PresetBucketRequestPayload));
+    if (request.targetId != myId) return;
+
+    PresetBucketEntriesHeader header;
+    header.requesterId = msg.senderId;
+
+    MeshMessage out;
+    out.type = MessageType::PRESET_BUCKET_ENTRIES;
+    out.senderId = myId;
+    out.totalPackets = 1;
+    out.packetIndex = 0;
+    memcpy(out.data, &header, sizeof(PresetBucketEntriesHeader));
+    size_t used = sizeof(PresetBucketEntriesHeader);
+
+    // Entries are self-contained, so a lost frame only delays those names to the next round
+    auto entries = animManager->getPresetDigests();
+    for (const auto& e : entries) {
+        if (!(request.bucketMask & (1 << presetBucket(e.name.c_str())))) continue;
+
+        size_t entryLen = sizeof(uint32_t) + e.name.length() + 1;
+        if (sizeof(PresetBucketEntriesHeader) + entryLen > MESH_MAX_DATA) continue;
+
+        if (used + entryLen > MESH_MAX_DATA) {
+            out.sequenceNumber = sequenceNumber++;
+            out.dataLength = used;
+            sendTo(msg.senderId, out);
+            used = sizeof(PresetBucketEntriesHeader);
         }
+        memcpy(out.data + used, &e.hash, sizeof(uint32_t));
+        memcpy(out.data + used + sizeof(uint32_t), e.name.c_str(), e.name.length() + 1);
+        used += entryLen;
+    }
+
+    if (used > sizeof(PresetBucketEntriesHeader)) {
+        out.sequenceNumber = sequenceNumber++;
+        out.dataLength = used;
+        sendTo(msg.senderId, out);
     }
 }
 
-void MeshNetworkManager::broadcastRequestPresetData(const std::string& name, uint64_t targetId) {
-    // This is now just a helper to queue a request
-    dataRequestQueue.requests.push_back({name, targetId});
+void MeshNetworkManager::handlePresetBucketEntries(const MeshMessage& msg) {
+    if (!animManager || msg.dataLength < sizeof(PresetBucketEntriesHeader)) return;
+
+    PresetBucketEntriesHeader header;
+    memcpy(&header, msg.data, sizeof(PresetBucketEntriesHeader));
+    if (header.requesterId != myId) return;
+
+    size_t pos = sizeof(PresetBucketEntriesHeader);
+    while (pos + sizeof(uint32_t) < msg.dataLength) {
+        const char* name = (const char*)msg.data + pos + sizeof(uint32_t);
+        size_t maxLen = msg.dataLength - pos - sizeof(uint32_t);
+        size_t nameLen = strnlen(name, maxLen);
+        if (nameLen == maxLen) break; // Unterminated
+
+        // Without version info a same-named preset with different content is left
+        // alone; only presets we don't have at all are fetched
+        if (!animManager->exists(name)) {
+            requestMissingPreset(name, msg.senderId);
+        }
+        rememberPreset(name, true);
+        pos += sizeof(uint32_t) + nameLen + 1;
+    }
 }
 
-void MeshNetworkManager::handleRequestPresetData(const MeshMessage& msg) {
-    if (!animManager) return;
-    
-    if (msg.dataLength < sizeof(uint64_t)) return;
+void MeshNetworkManager::requestMissingPreset(const char* name, uint64_t sourceId) {
+    unsigned long now = clock->millis();
+    bool alreadyRequested = false;
+    
+    // Clean up old requests and check for duplicates
+    for (auto it = requestedPresets.begin(); it != requestedPresets.end(); ) {
+        if (now - it->requestTime > 30000) {
+            it = requestedPresets.erase(it); // expire old (30s timeout)
+        } else {
+            if (it->name == name) {
+                alreadyRequested = true;
+            }
+            ++it;
+        }
+    }
+    
+    // Also check if already in the request queue
+    for (const auto& req : dataRequestQueue.requests) {
+        if (req.name == name) {
+            alreadyRequested = true;
+            break;
+        }
+    }
+
+    if (!alreadyRequested) {
+        Serial.printf("Mesh: Missing preset '%s', queuing request to %016llX\r\n", name, sourceId);
+        requestedPresets.push_back({name, now});
+        dataRequestQueue.requests.push_back({name, sourceId});
+    }
+}
+
+void MeshNetworkManager::broadcastRequestPresetData(const std::string& name, uint64_t targetId) {
+    // This is now just a helper to queue a request
+    dataRequestQueue.requests.push_back({name, targetId});
+}
+
+void MeshNetworkManager::handleRequestPresetData(const MeshMessage& msg) {
+    if (!animManager) return;
+    
+    if (msg.dataLength < sizeof(uint64_t)) return;
     
     uint64_t targetId;
     memcpy(&targetId, msg.data, sizeof(uint64_t));
@@ -986,9 +2157,9 @@ void MeshNetworkManager::handleRequestPresetData(const MeshMessage& msg) {
         return;
     }
 
-    char name[230];
-    strncpy(name, (char*)msg.data + sizeof(uint64_t), 229 - sizeof(uint64_t));
-    name[229] = '\0';
+    char name[MESH_MAX_DATA];
+    strncpy(name, (char*)msg.data + sizeof(uint64_t), MESH_MAX_DATA - 1 - sizeof(uint64_t));
+    name[MESH_MAX_DATA - 1] = '\0';
     
     Serial.printf("Mesh: Request for preset data '%s' received (Directed)\r\n", name);
     
@@ -1005,11 +2176,12 @@ void MeshNetworkManager::handleRequestPresetData(const MeshMessage& msg) {
 void MeshNetworkManager::handleDeletePreset(const MeshMessage& msg) {
     if (!animManager) return;
     
-    char name[230];
+    char name[MESH_MAX_DATA];
     memcpy(name, msg.data, msg.dataLength);
-    name[229] = '\0';
+    name[MESH_MAX_DATA - 1] = '\0';
     
     animManager->deletePreset(name);
+    rememberPreset(name, false);
 }
 
 void MeshNetworkManager::handleRenamePreset(const MeshMessage& msg) {
@@ -1044,6 +2216,8 @@ void MeshNetworkManager::handleRenamePreset(const MeshMessage& msg) {
         
         Serial.printf("Mesh: Renaming preset from '%s' to '%s'\r\n", oldName.c_str(), newName.c_str());
         animManager->renamePreset(oldName, newName);
+        rememberPreset(oldName, false);
+        rememberPreset(newName, true);
     } else {
         Serial.println("Mesh: Invalid Rename Payload");
     }
@@ -1075,12 +2249,100 @@ void MeshNetworkManager::handleCheckForUpdates(const MeshMessage& msg) {
 // GROUP MANAGEMENT IMPLEMENTATION
 // ==========================================
 
+std::string MeshNetworkManager::getGroupName() const {
+    std::lock_guard<std::mutex> lock(groupNameMutex);
+    return myGroupName;
+}
+
+bool MeshNetworkManager::inGroup() const {
+    std::lock_guard<std::mutex> lock(groupNameMutex);
+    return !myGroupName.empty();
+}
+
 void MeshNetworkManager::setGroupName(const std::string& name) {
-    if (myGroupName != name) {
+    {
+        std::lock_guard<std::mutex> lock(groupNameMutex);
+        if (myGroupName == name) return;
         Serial.printf("Mesh: Group name changed from '%s' to '%s'\r\n", myGroupName.c_str(), name.c_str());
         myGroupName = name;
-        // Trigger announcement immediately so others know
-        sendPeerAnnouncement();
+        myGroupHash = fnv1a32(name.c_str());
+    }
+    rebuildMemberships();
+    // Trigger announcement immediately so others know
+    sendPeerAnnouncement();
+}
+
+void MeshNetworkManager::setExtraGroups(const std::vector<std::string>& names) {
+    std::string primary = getGroupName();
+    std::vector<std::string> groups;
+    for (const auto& name : names) {
+        if (name.empty() || name == primary) continue;
+        if (std::find(groups.begin(), groups.end(), name) != groups.end()) continue;
+        if (groups.size() + 1 >= MAX_GROUP_MEMBERSHIPS) {
+            Serial.printf("Mesh: Too many groups, ignoring '%s'\r\n", name.c_str());
+            continue;
+        }
+        groups.push_back(name.substr(0, 31));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(extraGroupsMutex);
+        if (groups == extraGroups) return;
+        extraGroups = groups;
+    }
+    Serial.printf("Mesh: Member of %u extra group(s)\r\n", (unsigned)groups.size());
+    rebuildMemberships();
+}
+
+std::vector<std::string> MeshNetworkManager::getExtraGroups() const {
+    std::lock_guard<std::mutex> lock(extraGroupsMutex);
+    return extraGroups;
+}
+
+void MeshNetworkManager::rebuildMemberships() {
+    std::string primary = getGroupName();
+    uint32_t hashes[MAX_GROUP_MEMBERSHIPS];
+    size_t count = 0;
+    if (!primary.empty()) hashes[count++] = fnv1a32(primary.c_str());
+    {
+        std::lock_guard<std::mutex> lock(extraGroupsMutex);
+        for (const auto& name : extraGroups) {
+            if (count >= MAX_GROUP_MEMBERSHIPS) break;
+            if (name == primary) continue;
+            hashes[count++] = fnv1a32(name.c_str());
+        }
+    }
+
+    portENTER_CRITICAL(&groupMux);
+    memcpy(memberHashes, hashes, count * sizeof(uint32_t));
+    memberCount = count;
+    portEXIT_CRITICAL(&groupMux);
+}
+
+bool MeshNetworkManager::isGroupMember(uint32_t groupHash) const {
+    bool member = false;
+    portENTER_CRITICAL(&groupMux);
+    for (size_t i = 0; i < memberCount; i++) {
+        if (memberHashes[i] == groupHash) {
+            member = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&groupMux);
+    return member;
+}
+
+bool MeshNetworkManager::isGroupScoped(MessageType type) {
+    switch (type) {
+        case MessageType::ANIMATION_STATE:
+        case MessageType::SYNC_PARAM:
+        case MessageType::SYNC_POWER:
+        case MessageType::AUDIO_FEATURES:
+        case MessageType::PIXEL_FRAME:
+        case MessageType::EVENT:
+            return true;
+        default:
+            return false;
     }
 }
 
@@ -1094,24 +2356,22 @@ void MeshNetworkManager::setDeviceName(const std::string& name) {
 }
 
 void MeshNetworkManager::broadcastAssignGroup(uint64_t targetId, const char* newGroupName) {
-    Serial.printf("Mesh: Queuing ASSIGN_GROUP for %016llX -> '%s'\r\n", targetId, newGroupName);
+    Serial.printf("Mesh: Sending ASSIGN_GROUP for %016llX -> '%s'\r\n", targetId, newGroupName);
     
     // Immediately update local knownPeers cache so getPeers() returns updated data
     // This prevents the UI from snapping back when fetchPeers() is called before mesh propagates
-    for (auto& peer : knownPeers) {
-        if (peer.id == targetId) {
-            peer.groupName = newGroupName;
-            Serial.printf("Mesh: Updated local cache for peer %016llX -> group '%s'\r\n", targetId, newGroupName);
-            break;
-        }
+    portENTER_CRITICAL(&peerMux);
+    PeerInfo* peer = knownPeers.find(targetId);
+    if (peer) {
+        strncpy(peer->groupName, newGroupName, sizeof(peer->groupName) - 1);
+        peer->groupName[sizeof(peer->groupName) - 1] = '\0';
+        knownPeers.touch();
+    }
+    portEXIT_CRITICAL(&peerMux);
+    if (peer) {
+        Serial.printf("Mesh: Updated local cache for peer %016llX -> group '%s'\r\n", targetId, newGroupName);
     }
-    
-    pendingGroupAssignment.targetId = targetId;
-    pendingGroupAssignment.groupName = newGroupName;
-    pendingGroupAssignment.pending = true;
-}
 
-void MeshNetworkManager::doSendAssignGroup(uint64_t targetId, const std::string& groupName) {
     MeshMessage msg;
     msg.type = MessageType::ASSIGN_GROUP;
     msg.senderId = myId;
@@ -1121,13 +2381,12 @@ void MeshNetworkManager::doSendAssignGroup(uint64_t targetId, const std::string&
     
     // Payload: TargetID (8) + GroupName (N)
     memcpy(msg.data, &targetId, sizeof(uint64_t));
-    strncpy((char*)msg.data + sizeof(uint64_t), groupName.c_str(), 229 - sizeof(uint64_t));
-    ((char*)msg.data)[229] = '\0'; // Safety
+    strncpy((char*)msg.data + sizeof(uint64_t), newGroupName, MESH_MAX_DATA - 1 - sizeof(uint64_t));
+    ((char*)msg.data)[MESH_MAX_DATA - 1] = '\0'; // Safety
     
-    msg.dataLength = sizeof(uint64_t) + strlen(groupName.c_str()) + 1;
+    msg.dataLength = sizeof(uint64_t) + strlen((char*)msg.data + sizeof(uint64_t)) + 1;
     
-    sendMessage(msg);
-    Serial.printf("Mesh: ASSIGN_GROUP broadcast complete\r\n");
+    sendTo(targetId, msg); // Queued; reassigning the same node before it goes out replaces it
 }
 
 void MeshNetworkManager::handleAssignGroup(const MeshMessage& msg) {
@@ -1137,9 +2396,9 @@ void MeshNetworkManager::handleAssignGroup(const MeshMessage& msg) {
     memcpy(&targetId, msg.data, sizeof(uint64_t));
     
     if (targetId == myId) {
-        char name[230];
-        strncpy(name, (char*)msg.data + sizeof(uint64_t), 230 - sizeof(uint64_t));
-        name[229] = '\0';
+        char name[MESH_MAX_DATA];
+        strncpy(name, (char*)msg.data + sizeof(uint64_t), MESH_MAX_DATA - sizeof(uint64_t));
+        name[MESH_MAX_DATA - 1] = '\0';
         
         Serial.printf("Mesh: Received ASSIGN_GROUP command. New Group: '%s'\r\n", name);
         setGroupName(name);
@@ -1150,27 +2409,408 @@ void MeshNetworkManager::handleAssignGroup(const MeshMessage& msg) {
 }
 
 // ==========================================
-// SYNC PARAM IMPLEMENTATION
+// BULK TRANSFER IMPLEMENTATION
 // ==========================================
 
-void MeshNetworkManager::broadcastSyncParam(const std::string& paramName, const std::string& jsonValue) {
-    if (myGroupName.empty()) return; // Don't broadcast if not in a group
-    
-    pendingParamSync.paramName = paramName;
-    pendingParamSync.jsonValue = jsonValue;
-    pendingParamSync.pending = true;
+static inline bool bitmapTest(const uint8_t* bits, uint8_t i) { return bits[i >> 3] & (1 << (i & 7)); }
+static inline void bitmapSet(uint8_t* bits, uint8_t i) { bits[i >> 3] |= (1 << (i & 7)); }
+static inline void bitmapClear(uint8_t* bits, uint8_t i) { bits[i >> 3] &= ~(1 << (i & 7)); }
+
+bool MeshNetworkManager::peersSupport(uint8_t capability) const {
+    bool all = true;
+    portENTER_CRITICAL(&peerMux);
+    knownPeers.forEach([&](const PeerInfo& peer) {
+        if ((peer.capabilities & capability) != capability) all = false;
+    });
+    portEXIT_CRITICAL(&peerMux);
+    return all;
 }
 
-void MeshNetworkManager::doSendSyncParam(const std::string& paramName, const std::string& jsonValue) {
-    // Format: GroupName\0ParamName\0JsonValue
-    std::string payload = myGroupName;
-    payload += '\0';
-    payload += paramName;
-    payload += '\0';
-    payload += jsonValue;
-    
-    if (payload.length() > 230) {
-        Serial.println("Mesh: Sync Param payload too large!");
+size_t MeshNetworkManager::bulkMaxBytes(MessageType type) {
+    switch (type) {
+        case MessageType::SAVE_PRESET:
+            return BULK_PRESET_MAX_BYTES;
+        default:
+            return 0;
+    }
+}
+
+void MeshNetworkManager::sendBulk(MessageType type, std::vector<uint8_t>&& payload) {
+    if (payload.size() > bulkMaxBytes(type)) {
+        Serial.printf("Mesh: Bulk payload of %u bytes over the %u byte limit\r\n", payload.size(), bulkMaxBytes(type));
+        return;
+    }
+
+    size_t totalPackets = (payload.size() + MESH_MAX_DATA - 1) / MESH_MAX_DATA;
+    bool lzss = false;
+
+    // Compress on the caller's task, and only when it saves airtime for everyone
+    if (totalPackets > 1 && payload.size() <= Lzss::MAX_INPUT && peersSupport(MESH_CAP_LZSS)) {
+        size_t capacity = (totalPackets - 1) * MESH_MAX_DATA;
+        std::vector<uint8_t> packed(capacity);
+        BulkLzssHeader header;
+        header.rawLength = (uint16_t)payload.size();
+        memcpy(packed.data(), &header, sizeof(header));
+        size_t n = Lzss::encode(payload.data(), payload.size(), packed.data() + sizeof(header), capacity - sizeof(header));
+        if (n) {
+            packed.resize(sizeof(header) + n);
+            Serial.printf("Mesh: Bulk payload compressed %u -> %u bytes\r\n", payload.size(), packed.size());
+            payload.swap(packed);
+            totalPackets = (payload.size() + MESH_MAX_DATA - 1) / MESH_MAX_DATA;
+            lzss = true;
+        }
+    }
+
+    if (totalPackets == 0 || totalPackets > BULK_MAX_PACKETS) {
+        Serial.printf("Mesh: Bulk payload of %u bytes not sendable\r\n", payload.size());
+        return;
+    }
+
+    OutboundTransfer transfer;
+    transfer.type = type;
+    transfer.transferId = 0; // Assigned when it starts
+    transfer.payload = std::move(payload);
+    transfer.lzss = lzss;
+    transfer.totalPackets = (uint8_t)totalPackets;
+    transfer.round = 1;
+    transfer.cursor = 0;
+    memset(transfer.toSend, 0, sizeof(transfer.toSend));
+    for (uint8_t i = 0; i < transfer.totalPackets; i++) bitmapSet(transfer.toSend, i);
+    transfer.ending = false;
+    transfer.lingerUntil = 0;
+
+    std::lock_guard<std::mutex> lock(outboundMutex);
+    if (outboundQueue.size() >= BULK_MAX_QUEUED) {
+        Serial.println("Mesh: Bulk queue full, dropping transfer");
+        return;
+    }
+    outboundQueue.push_back(std::move(transfer));
+}
+
+void MeshNetworkManager::processOutbound() {
+    unsigned long now = clock->millis();
+
+    if (!outboundActive) {
+        std::lock_guard<std::mutex> lock(outboundMutex);
+        if (outboundQueue.empty()) return;
+        outbound = std::move(outboundQueue.front());
+        outboundQueue.erase(outboundQueue.begin());
+        outbound.transferId = (sequenceNumber++ & ~BULK_TRANSFER_LZSS) | (outbound.lzss ? BULK_TRANSFER_LZSS : 0);
+        outboundActive = true;
+        Serial.printf("Mesh: Bulk transfer %u started, %u bytes in %u packets\r\n",
+                      outbound.transferId, outbound.payload.size(), outbound.totalPackets);
+    }
+
+    if (outbound.ending) {
+        if ((long)(now - outbound.lingerUntil) >= 0) {
+            Serial.printf("Mesh: Bulk transfer %u complete after %u round(s)\r\n", outbound.transferId, outbound.round);
+            outboundActive = false;
+            outbound.payload.clear();
+            outbound.payload.shrink_to_fit();
+        }
+        return;
+    }
+
+    // Feed the outbox one chunk at a time so anything more urgent can cut in
+    if (outboxCount(MeshPriority::BULK) > 0) return;
+
+    for (uint16_t i = outbound.cursor; i < outbound.totalPackets; i++) {
+        if (bitmapTest(outbound.toSend, i)) {
+            bitmapClear(outbound.toSend, i);
+            outbound.cursor = i + 1;
+            sendBulkChunk(i);
+            return;
+        }
+    }
+
+    // Round done: tell receivers so they NACK whatever is missing
+    BulkEndPayload end;
+    end.transferId = outbound.transferId;
+    end.type = outbound.type;
+    end.totalPackets = outbound.totalPackets;
+    end.round = outbound.round;
+
+    MeshMessage msg;
+    msg.type = MessageType::BULK_END;
+    msg.senderId = myId;
+    msg.sequenceNumber = sequenceNumber++;
+    msg.totalPackets = 1;
+    msg.packetIndex = 0;
+    msg.dataLength = sizeof(BulkEndPayload);
+    memcpy(msg.data, &end, sizeof(BulkEndPayload));
+    sendMessage(msg);
+
+    outbound.ending = true;
+    outbound.lingerUntil = now + BULK_LINGER_MS;
+}
+
+void MeshNetworkManager::sendBulkChunk(uint8_t index) {
+    MeshMessage msg;
+    msg.type = outbound.type;
+    msg.senderId = myId;
+    msg.sequenceNumber = outbound.transferId;
+    msg.totalPackets = outbound.totalPackets;
+    msg.packetIndex = index;
+
+    size_t offset = (size_t)index * MESH_MAX_DATA;
+    size_t chunkLen = outbound.payload.size() - offset;
+    if (chunkLen > MESH_MAX_DATA) chunkLen = MESH_MAX_DATA;
+
+    memcpy(msg.data, outbound.payload.data() + offset, chunkLen);
+    msg.dataLength = chunkLen;
+    sendMessage(msg);
+}
+
+void MeshNetworkManager::handleBulkNack(const MeshMessage& msg) {
+    BulkNackPayload nack = {};
+    size_t len = msg.dataLength < sizeof(BulkNackPayload) ? msg.dataLength : sizeof(BulkNackPayload);
+    if (len < offsetof(BulkNackPayload, missing)) return;
+    memcpy(&nack, msg.data, len);
+
+    if (nack.originId == myId) {
+        if (!outboundActive || nack.transferId != outbound.transferId) return;
+        if (outbound.round >= BULK_MAX_ROUNDS) return;
+
+        // Fold the gaps into the next round; several NACKs may arrive for the same round
+        bool any = false;
+        for (uint16_t i = 0; i < outbound.totalPackets; i++) {
+            if (bitmapTest(nack.missing, i)) {
+                if (!bitmapTest(outbound.toSend, i)) MeshStats::bump(stats.bulkRetransmits);
+                bitmapSet(outbound.toSend, i);
+                any = true;
+            }
+        }
+        if (any) {
+            if (outbound.ending) outbound.round++;
+            outbound.ending = false;
+            outbound.cursor = 0;
+        }
+        return;
+    }
+
+    // Someone else's NACK for a transfer we're waiting on: if it covers all
+    // our gaps the retransmission will reach us too, so stay quiet
+    InboundTransfer* session = findInbound(nack.originId, nack.transferId);
+    if (session && !session->complete && session->nackTime) {
+        for (uint16_t i = 0; i < session->totalPackets; i++) {
+            if (!bitmapTest(session->received, i) && !bitmapTest(nack.missing, i)) return;
+        }
+        session->nackTime = 0;
+        session->lastActivity = clock->millis();
+    }
+}
+
+MeshNetworkManager::InboundTransfer* MeshNetworkManager::findInbound(uint64_t senderId, uint32_t transferId) {
+    for (auto& session : inbound) {
+        if (session.active && session.senderId == senderId && session.transferId == transferId) return &session;
+    }
+    return nullptr;
+}
+
+MeshNetworkManager::InboundTransfer* MeshNetworkManager::startInbound(uint64_t senderId, uint32_t transferId, MessageType type, uint8_t totalPackets) {
+    // The packet count comes off the air: never size anything from it unchecked
+    size_t maxPackets = (bulkMaxBytes(type) + MESH_MAX_DATA - 1) / MESH_MAX_DATA;
+    if (totalPackets == 0 || totalPackets > maxPackets) {
+        MeshStats::bump(stats.rxMalformed);
+        return nullptr;
+    }
+
+    // The sender has moved on to its next transfer
+    InboundTransfer* slot = nullptr;
+    for (auto& session : inbound) {
+        if (session.active && session.senderId == senderId) {
+            slot = &session;
+            break;
+        }
+    }
+    // Else a free session, or the stalest finished one
+    if (!slot) {
+        for (auto& session : inbound) {
+            if (!session.active) {
+                slot = &session;
+                break;
+            }
+            if (session.complete && (!slot || (long)(session.lastActivity - slot->lastActivity) < 0)) slot = &session;
+        }
+    }
+    // All busy: the stalest transfer in progress gives way
+    if (!slot) {
+        slot = &inbound[0];
+        for (auto& session : inbound) {
+            if ((long)(session.lastActivity - slot->lastActivity) < 0) slot = &session;
+        }
+        MeshStats::bump(stats.reassemblyTimeouts);
+        Serial.printf("Mesh: Bulk transfer %u from %llX dropped for one from %llX\r\n",
+                      slot->transferId, slot->senderId, senderId);
+    }
+
+    slot->active = true;
+    slot->complete = false;
+    slot->type = type;
+    slot->senderId = senderId;
+    slot->transferId = transferId;
+    slot->totalPackets = totalPackets;
+    slot->receivedPackets = 0;
+    memset(slot->received, 0, sizeof(slot->received));
+    slot->length = 0;
+    slot->data.assign((size_t)totalPackets * MESH_MAX_DATA, 0);
+    slot->lastActivity = clock->millis();
+    slot->nackTime = 0;
+    return slot;
+}
+
+void MeshNetworkManager::releaseInbound(InboundTransfer& session) {
+    session.data.clear(); // Keeps the capacity for the next transfer
+}
+
+void MeshNetworkManager::handleBulkChunk(const MeshMessage& msg) {
+    if (msg.totalPackets == 0 || msg.packetIndex >= msg.totalPackets) return;
+
+    InboundTransfer* session = findInbound(msg.senderId, msg.sequenceNumber);
+    if (session && session->complete) return; // Retransmission for someone else
+    if (!session || session->totalPackets != msg.totalPackets) {
+        session = startInbound(msg.senderId, msg.sequenceNumber, msg.type, msg.totalPackets);
+        if (!session) return;
+    }
+
+    session->lastActivity = clock->millis();
+    if (bitmapTest(session->received, msg.packetIndex)) return; // Duplicate
+
+    // Every chunk but the last is full size
+    bool last = msg.packetIndex == session->totalPackets - 1;
+    if (!last && msg.dataLength != MESH_MAX_DATA) return;
+
+    size_t offset = (size_t)msg.packetIndex * MESH_MAX_DATA;
+    memcpy(session->data.data() + offset, msg.data, msg.dataLength);
+    bitmapSet(session->received, msg.packetIndex);
+    session->receivedPackets++;
+    if (last) session->length = offset + msg.dataLength;
+
+    if (session->receivedPackets < session->totalPackets) return;
+
+    // Complete: keep the ID so late retransmissions are ignored, release the buffer
+    session->complete = true;
+    session->nackTime = 0;
+
+    deliverBulk(*session);
+    releaseInbound(*session);
+}
+
+void MeshNetworkManager::deliverBulk(const InboundTransfer& session) {
+    const uint8_t* data = session.data.data();
+    size_t length = session.length;
+
+    if (session.transferId & BULK_TRANSFER_LZSS) {
+        if (length < sizeof(BulkLzssHeader)) return;
+        BulkLzssHeader header;
+        memcpy(&header, data, sizeof(header));
+        // The claimed size is the sender's word; hold it to the same limit as an uncompressed transfer
+        if (header.rawLength > bulkMaxBytes(session.type)) {
+            MeshStats::bump(stats.rxMalformed);
+            Serial.printf("Mesh: Bulk transfer %u from %llX claims %u bytes, dropped\r\n",
+                          session.transferId & ~BULK_TRANSFER_LZSS, session.senderId, header.rawLength);
+            return;
+        }
+        bulkDecoded.resize(header.rawLength);
+        int n = Lzss::decode(data + sizeof(header), length - sizeof(header), bulkDecoded.data(), bulkDecoded.size());
+        if (n != (int)header.rawLength) {
+            MeshStats::bump(stats.rxMalformed);
+            Serial.printf("Mesh: Bulk transfer %u from %llX failed to decompress\r\n",
+                          session.transferId & ~BULK_TRANSFER_LZSS, session.senderId);
+            return;
+        }
+        data = bulkDecoded.data();
+        length = header.rawLength;
+    }
+
+    switch (session.type) {
+        case MessageType::SAVE_PRESET:
+            handleSavePreset(session.senderId, data, length);
+            break;
+        default:
+            break;
+    }
+}
+
+void MeshNetworkManager::handleBulkEnd(const MeshMessage& msg) {
+    if (msg.dataLength < sizeof(BulkEndPayload)) return;
+    BulkEndPayload end;
+    memcpy(&end, msg.data, sizeof(BulkEndPayload));
+    if (end.totalPackets == 0) return;
+
+    InboundTransfer* session = findInbound(msg.senderId, end.transferId);
+    if (session && session->complete) return;
+    if (!session) {
+        // Missed every chunk of this round; the end marker is enough to ask for all of them
+        session = startInbound(msg.senderId, end.transferId, end.type, end.totalPackets);
+        if (!session) return;
+    }
+
+    // Jitter so receivers don't all answer at once (and can suppress each other)
+    unsigned long now = clock->millis();
+    session->lastActivity = now;
+    if (!session->nackTime) session->nackTime = now + random(2, 30);
+}
+
+void MeshNetworkManager::processInbound() {
+    unsigned long now = clock->millis();
+
+    for (auto& session : inbound) {
+        if (!session.active || session.complete) continue;
+
+        if (now - session.lastActivity > BULK_RX_TIMEOUT_MS) {
+            MeshStats::bump(stats.reassemblyTimeouts);
+            Serial.printf("Mesh: Bulk transfer %u from %llX timed out (%u/%u)\r\n",
+                          session.transferId, session.senderId, session.receivedPackets, session.totalPackets);
+            session.active = false;
+            releaseInbound(session);
+            continue;
+        }
+
+        // Lost BULK_END or lost NACK: ask again after a quiet spell
+        if (!session.nackTime && now - session.lastActivity > BULK_NACK_RETRY_MS) {
+            session.nackTime = now + random(2, 30);
+        }
+
+        if (session.nackTime && (long)(now - session.nackTime) >= 0) {
+            sendBulkNack(session);
+            session.nackTime = 0;
+            session.lastActivity = now;
+        }
+    }
+}
+
+void MeshNetworkManager::sendBulkNack(const InboundTransfer& session) {
+    BulkNackPayload nack = {};
+    nack.originId = session.senderId;
+    nack.transferId = session.transferId;
+    nack.totalPackets = session.totalPackets;
+    for (uint16_t i = 0; i < session.totalPackets; i++) {
+        if (!bitmapTest(session.received, i)) bitmapSet(nack.missing, i);
+    }
+
+    MeshMessage msg;
+    msg.type = MessageType::BULK_NACK;
+    msg.senderId = myId;
+    msg.sequenceNumber = sequenceNumber++;
+    msg.totalPackets = 1;
+    msg.packetIndex = 0;
+    msg.dataLength = offsetof(BulkNackPayload, missing) + (session.totalPackets + 7) / 8;
+    memcpy(msg.data, &nack, msg.dataLength);
+    sendMessage(msg);
+}
+
+// ==========================================
+// SYNC PARAM IMPLEMENTATION
+// ==========================================
+
+void MeshNetworkManager::broadcastSyncParam(const AnimationParameter& param) {
+    if (!inGroup()) return; // Don't broadcast if not in a group
+
+    uint8_t buffer[MESH_MAX_DATA];
+    size_t length = encodeSyncParam(param, buffer, sizeof(buffer));
+    if (length == 0) {
+        Serial.printf("Mesh: Sync Param '%s' too large!\r\n", param.name);
         return;
     }
 
@@ -1180,81 +2820,129 @@ void MeshNetworkManager::doSendSyncParam(const std::string& paramName, const std
     msg.sequenceNumber = sequenceNumber++;
     msg.totalPackets = 1;
     msg.packetIndex = 0;
-    
-    memcpy(msg.data, payload.c_str(), payload.length());
-    msg.dataLength = payload.length();
-    
+    memcpy(msg.data, buffer, length);
+    msg.dataLength = length;
+
+    // Coalesced per parameter: a slider drag collapses into its latest value,
+    // while edits to other parameters keep their own place in the queue
     sendMessage(msg);
-    Serial.printf("Mesh: SYNC_PARAM broadcast complete for %s\r\n", paramName.c_str());
 }
 
-void MeshNetworkManager::handleSyncParam(const MeshMessage& msg) {
-    if (!animManager) return;
-    
-    const char* raw = (const char*)msg.data;
-    size_t len = msg.dataLength;
-    
-    // Parse: GroupName\0ParamName\0Value
-    // Check if group matches
-    std::string groupName = raw;
-    if (groupName != myGroupName || myGroupName.empty()) {
-        return; // Not for us
+size_t MeshNetworkManager::encodeSyncParam(const AnimationParameter& param, uint8_t* out, size_t capacity) const {
+    SyncParamHeader header;
+    header.paramId = param.id;
+    header.type = (uint8_t)param.type;
+
+    if (capacity < sizeof(SyncParamHeader) + 4) return 0;
+    uint8_t* value = out + sizeof(SyncParamHeader);
+    size_t valueLength = 0;
+
+    switch (param.type) {
+        case PARAM_INT: {
+            int32_t v = *static_cast<int*>(param.value);
+            memcpy(value, &v, sizeof(v));
+            valueLength = sizeof(v);
+            break;
+        }
+        case PARAM_FLOAT: {
+            float v = *static_cast<float*>(param.value);
+            memcpy(value, &v, sizeof(v));
+            valueLength = sizeof(v);
+            break;
+        }
+        case PARAM_BYTE:
+            value[0] = *static_cast<uint8_t*>(param.value);
+            valueLength = 1;
+            break;
+        case PARAM_BOOL:
+            value[0] = *static_cast<bool*>(param.value) ? 1 : 0;
+            valueLength = 1;
+            break;
+        case PARAM_COLOR: {
+            const CRGB& c = *static_cast<CRGB*>(param.value);
+            value[0] = c.r;
+            value[1] = c.g;
+            value[2] = c.b;
+            valueLength = 3;
+            break;
+        }
+        case PARAM_DYNAMIC_PALETTE: {
+            const DynamicPalette& pal = *static_cast<DynamicPalette*>(param.value);
+            size_t count = pal.colors.size();
+            if (count > 255 || sizeof(SyncParamHeader) + 1 + count * 3 > capacity) return 0;
+            value[0] = (uint8_t)count;
+            for (size_t i = 0; i < count; i++) {
+                value[1 + i * 3] = pal.colors[i].r;
+                value[2 + i * 3] = pal.colors[i].g;
+                value[3 + i * 3] = pal.colors[i].b;
+            }
+            valueLength = 1 + count * 3;
+            break;
+        }
     }
-    
-    if (groupName.length() + 1 >= len) return;
-    
-    std::string paramName = raw + groupName.length() + 1;
-    
-    if (groupName.length() + 1 + paramName.length() + 1 >= len) return;
-    
-    std::string jsonValueStr = raw + groupName.length() + 1 + paramName.length() + 1;
-    
-    // Apply param locally
+
+    memcpy(out, &header, sizeof(SyncParamHeader));
+    return sizeof(SyncParamHeader) + valueLength;
+}
+
+void MeshNetworkManager::handleSyncParam(const MeshMessage& msg) {
+    if (!animManager || msg.dataLength < sizeof(SyncParamHeader)) return;
+
+    SyncParamHeader header;
+    memcpy(&header, msg.data, sizeof(SyncParamHeader));
+
     Animation* current = animManager->getCurrentAnimation();
-    if (current) {
-        // We need to parse the JSON value.
-        // It's a string from the web: "123", "true", "\"#FF0000\"", "[...]"
-        // We can reuse logic or simple parsing.
-        // Using ArduinoJson here is safest if we have heap.
-        // Or passed string is raw value?
-        // WebManager passes whatever `doc["value"]` was.
-        
-        // Since we don't want to depend heavily on ArduinoJson everywhere if avoidable, but we need it.
-        // Let's assume passed string is JSON representation.
-        StaticJsonDocument<512> doc;
-        DeserializationError error = deserializeJson(doc, jsonValueStr);
-        if (!error) {
-             // Logic similar to WebManager setParam
-             if (doc.is<int>()) current->setParam(paramName.c_str(), doc.as<int>());
-             else if (doc.is<float>()) current->setParam(paramName.c_str(), doc.as<float>());
-             else if (doc.is<bool>()) current->setParam(paramName.c_str(), doc.as<bool>());
-             else if (doc.is<const char*>()) {
-                  const char* val = doc.as<const char*>();
-                   if (val && val[0] == '#' && strlen(val) == 7) {
-                       int r, g, b;
-                       if (sscanf(val + 1, "%02x%02x%02x", &r, &g, &b) == 3) {
-                           current->setParam(paramName.c_str(), CRGB(r, g, b));
-                       }
-                   }
-             }
-             // Dynamic Palette array logic omitted for brevity/complexity, can add if needed
-             else if (doc.is<JsonArray>()) {
-                    JsonArray arr = doc.as<JsonArray>();
-                    if (current->findParameter(paramName.c_str())->type == PARAM_DYNAMIC_PALETTE) {
-                       DynamicPalette newPal;
-                       for (JsonVariant v : arr) {
-                           const char* val = v.as<const char*>();
-                           if (val && val[0] == '#' && strlen(val) == 7) {
-                               int r, g, b;
-                               if (sscanf(val + 1, "%02x%02x%02x", &r, &g, &b) == 3) {
-                                   newPal.colors.push_back(CRGB(r, g, b));
-                               }
-                           }
-                       }
-                       if (newPal.colors.empty()) newPal.colors.push_back(CRGB::Black);
-                       current->setParam(paramName.c_str(), newPal);
-                    }
-             }
+    if (!current) return;
+
+    // Same effect on both ends, so the type must match exactly
+    AnimationParameter* param = current->findParameter(header.paramId);
+    if (!param || (uint8_t)param->type != header.type) return;
+
+    const uint8_t* value = msg.data + sizeof(SyncParamHeader);
+    size_t valueLength = msg.dataLength - sizeof(SyncParamHeader);
+
+    switch (param->type) {
+        case PARAM_INT: {
+            if (valueLength < 4) return;
+            int32_t v;
+            memcpy(&v, value, sizeof(v));
+            *static_cast<int*>(param->value) = v;
+            break;
+        }
+        case PARAM_FLOAT: {
+            if (valueLength < 4) return;
+            float v;
+            memcpy(&v, value, sizeof(v));
+            *static_cast<float*>(param->value) = v;
+            break;
+        }
+        case PARAM_BYTE:
+            if (valueLength < 1) return;
+            *static_cast<uint8_t*>(param->value) = value[0];
+            break;
+        case PARAM_BOOL:
+            if (valueLength < 1) return;
+            *static_cast<bool*>(param->value) = value[0] != 0;
+            break;
+        case PARAM_COLOR:
+            if (valueLength < 3) return;
+            *static_cast<CRGB*>(param->value) = CRGB(value[0], value[1], value[2]);
+            break;
+        case PARAM_DYNAMIC_PALETTE: {
+            if (valueLength < 1) return;
+            size_t count = value[0];
+            if (valueLength < 1 + count * 3) return;
+            // Resize in place; only grows the vector when the palette gets longer
+            DynamicPalette& pal = *static_cast<DynamicPalette*>(param->value);
+            if (count == 0) {
+                pal.colors.assign(1, CRGB::Black);
+                break;
+            }
+            pal.colors.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                pal.colors[i] = CRGB(value[1 + i * 3], value[2 + i * 3], value[3 + i * 3]);
+            }
+            break;
         }
     }
 }
@@ -1264,16 +2952,10 @@ void MeshNetworkManager::handleSyncParam(const MeshMessage& msg) {
 // ==========================================
 
 void MeshNetworkManager::broadcastSyncPower(bool powerOn) {
-    if (myGroupName.empty()) return;
+    if (!inGroup()) return;
     
-    pendingPowerSync.powerOn = powerOn;
-    pendingPowerSync.pending = true;
-}
-
-void MeshNetworkManager::doSendSyncPower(bool powerOn) {
-    std::string payload = myGroupName;
-    payload += '\0';
-    payload += (powerOn ? "1" : "0");
+    SyncPowerPayload payload;
+    payload.powerOn = powerOn ? 1 : 0;
     
     MeshMessage msg;
     msg.type = MessageType::SYNC_POWER;
@@ -1282,30 +2964,255 @@ void MeshNetworkManager::doSendSyncPower(bool powerOn) {
     msg.totalPackets = 1;
     msg.packetIndex = 0;
     
-    memcpy(msg.data, payload.c_str(), payload.length());
-    msg.dataLength = payload.length();
+    memcpy(msg.data, &payload, sizeof(SyncPowerPayload));
+    msg.dataLength = sizeof(SyncPowerPayload);
     
     sendMessage(msg);
-    Serial.printf("Mesh: SYNC_POWER broadcast complete: %s\r\n", powerOn ? "ON" : "OFF");
+    Serial.printf("Mesh: SYNC_POWER queued: %s\r\n", powerOn ? "ON" : "OFF");
 }
 
 void MeshNetworkManager::handleSyncPower(const MeshMessage& msg) {
-    if (!animManager) return;
-    
-    const char* raw = (const char*)msg.data;
-    size_t len = msg.dataLength;
-    
-    std::string groupName = raw;
-    if (groupName != myGroupName || myGroupName.empty()) return;
+    if (!animManager || msg.dataLength < sizeof(SyncPowerPayload)) return;
     
-    if (groupName.length() + 1 >= len) return;
-    
-    // Value is "1" or "0"
-    char val = raw[groupName.length() + 1];
-    bool powerOn = (val == '1');
+    SyncPowerPayload payload;
+    memcpy(&payload, msg.data, sizeof(SyncPowerPayload));
     
+    bool powerOn = payload.powerOn != 0;
     if (animManager->getPower() != powerOn) {
         Serial.printf("Mesh: syncing power %s\r\n", powerOn ? "ON" : "OFF");
         animManager->setPower(powerOn);
     }
 }
+
+
+// ==========================================
+// AUDIO FEATURES IMPLEMENTATION
+// ==========================================
+
+void MeshNetworkManager::broadcastAudioFeatures(const AudioFeatures& features) {
+    // Called from the animation task after each locally analysed frame
+    if (!isAudioEar()) return;
+
+    unsigned long now = clock->millis();
+    if (now - lastAudioSendTime < AUDIO_FEATURE_MIN_INTERVAL_MS) return;
+    lastAudioSendTime = now;
+
+    AudioFeaturesPayload payload;
+    payload.captureTime = getNetworkTime();
+    payload.frameIndex = audioFrameIndex++;
+    payload.flags = features.beat ? AUDIO_FLAG_BEAT : 0;
+    memcpy(payload.bands, features.bands, AUDIO_FEATURE_BANDS);
+
+    MeshMessage msg;
+    msg.type = MessageType::AUDIO_FEATURES;
+    msg.senderId = myId;
+    msg.sequenceNumber = sequenceNumber++;
+    msg.totalPackets = 1;
+    msg.packetIndex = 0;
+    msg.dataLength = sizeof(AudioFeaturesPayload);
+    memcpy(msg.data, &payload, sizeof(AudioFeaturesPayload));
+
+    sendMessage(msg);
+}
+
+void MeshNetworkManager::handleAudioFeatures(const MeshMessage& msg) {
+    if (msg.dataLength < sizeof(AudioFeaturesPayload)) return;
+    if (!inGroup() || msg.groupHash != myGroupHash.load()) return; // An extra membership's ear
+
+    AudioFeaturesPayload payload;
+    memcpy(&payload, msg.data, sizeof(AudioFeaturesPayload));
+
+    if (isAudioEar()) return;
+    unsigned long now = clock->millis();
+
+    // Follow a single ear; only switch once it has gone quiet
+    if (msg.senderId != audioSourceId) {
+        if (audioSourceId != 0 && now - lastAudioSourceTime < AUDIO_SOURCE_TIMEOUT_MS) return;
+        Serial.printf("Mesh: Audio features now from %016llX\r\n", msg.senderId);
+        audioSourceId = msg.senderId;
+    } else if ((int16_t)(payload.frameIndex - lastAudioFrameIndex) <= 0) {
+        return; // Duplicate or out of order
+    }
+    lastAudioSourceTime = now;
+    lastAudioFrameIndex = payload.frameIndex;
+
+    // Signed: the ear's clock may run a little ahead of ours, which isn't age
+    int32_t age = (int32_t)(getNetworkTime() - payload.captureTime);
+    if (age > (int32_t)AUDIO_FEATURE_MAX_AGE_MS) return;
+
+    AudioFeatures features;
+    memcpy(features.bands, payload.bands, AUDIO_FEATURE_BANDS);
+    features.beat = (payload.flags & AUDIO_FLAG_BEAT) != 0;
+
+    if (audioFeaturesCallback) {
+        audioFeaturesCallback(features);
+    }
+}
+
+// ==========================================
+// PIXEL STREAMING IMPLEMENTATION
+// ==========================================
+
+bool MeshNetworkManager::isPixelStreamSource() const {
+    return pixelStreamEnabled && currentState == NodeState::MASTER;
+}
+
+bool MeshNetworkManager::isPixelStreamActive() const {
+    if (isPixelStreamSource()) return true;
+    return lastStreamRxTime != 0 && clock->millis() - lastStreamRxTime < PIXEL_STREAM_TIMEOUT_MS;
+}
+
+bool MeshNetworkManager::isPixelStreamFrameDue() const {
+    return clock->millis() - lastStreamSendTime >= PIXEL_STREAM_INTERVAL_MS;
+}
+
+void MeshNetworkManager::streamPixels(const CRGB* frame, int numLeds, uint32_t displayTime) {
+    // Called from the animation task with a frame rendered for displayTime
+    if (!isPixelStreamSource()) return;
+
+    unsigned long now = clock->millis();
+    lastStreamSendTime = now;
+
+    // Radio still busy with the last frame: skip this one rather than queue behind it
+    if (outboxCount(MeshPriority::STREAM) > 0) {
+        MeshStats::bump(stats.pixelFramesSkipped);
+        return;
+    }
+
+    int count = numLeds < (int)streamLastSent.size() ? numLeds : (int)streamLastSent.size();
+    bool key = !streamHasSent || now - lastKeyframeTime >= PIXEL_KEYFRAME_INTERVAL_MS;
+    const CRGB* base = key ? nullptr : streamLastSent.data();
+
+    // Nothing changed: no packet, and nothing new to show locally either
+    if (!key && memcmp(frame, base, count * sizeof(CRGB)) == 0) return;
+
+    uint32_t frameId = streamFrameId + 1;
+    PixelFrameHeader header;
+    header.displayTime = displayTime;
+    header.baseFrameId = key ? frameId : streamFrameId;
+    header.totalPixels = count;
+    header.flags = key ? PIXEL_FRAME_KEY : 0;
+
+    if (streamPackets.capacity() < PIXEL_STREAM_MAX_PACKETS) streamPackets.reserve(PIXEL_STREAM_MAX_PACKETS);
+    streamPackets.clear();
+
+    // Each packet covers its own pixel range so a loss stays local
+    int pixel = 0;
+    do {
+        if (streamPackets.size() >= PIXEL_STREAM_MAX_PACKETS) {
+            Serial.println("Mesh: Pixel frame too large to stream");
+            return;
+        }
+        streamPackets.emplace_back();
+        MeshMessage& msg = streamPackets.back();
+        header.pixelStart = pixel;
+
+        int encoded = 0;
+        size_t length = PixelCodec::encode(frame, base, pixel, count - pixel,
+                                           msg.data + sizeof(PixelFrameHeader),
+                                           MESH_MAX_DATA - sizeof(PixelFrameHeader), encoded);
+        memcpy(msg.data, &header, sizeof(PixelFrameHeader));
+        msg.dataLength = sizeof(PixelFrameHeader) + length;
+        pixel += encoded;
+    } while (pixel < count);
+
+    for (size_t i = 0; i < streamPackets.size(); i++) {
+        MeshMessage& msg = streamPackets[i];
+        msg.type = MessageType::PIXEL_FRAME;
+        msg.senderId = myId;
+        msg.sequenceNumber = frameId;
+        msg.totalPackets = streamPackets.size();
+        msg.packetIndex = i;
+        sendMessage(msg);
+    }
+
+    streamFrameId = frameId;
+    streamHasSent = true;
+    if (key) lastKeyframeTime = now;
+    memcpy(streamLastSent.data(), frame, count * sizeof(CRGB));
+
+    // The source shows its own frame at the same instant as the group
+    portENTER_CRITICAL(&streamMux);
+    memcpy(streamReady.data(), frame, count * sizeof(CRGB));
+    streamReadyDisplayTime = displayTime;
+    streamReadyPending = true;
+    portEXIT_CRITICAL(&streamMux);
+}
+
+void MeshNetworkManager::handleFrameData(const MeshMessage& msg) {
+    if (msg.dataLength < sizeof(PixelFrameHeader) || streamWorking.empty()) return;
+    if (isPixelStreamSource()) return;
+    if (!inGroup() || msg.groupHash != myGroupHash.load()) return; // Streams follow the primary group
+
+    PixelFrameHeader header;
+    memcpy(&header, msg.data, sizeof(PixelFrameHeader));
+    if (msg.totalPackets == 0 || msg.totalPackets > PIXEL_STREAM_MAX_PACKETS || msg.packetIndex >= msg.totalPackets) return;
+
+    lastStreamRxTime = clock->millis();
+
+    if (msg.senderId != frameBuffer.senderId || msg.sequenceNumber != frameBuffer.sequenceNumber) {
+        // New frame: a delta is only usable on top of the frame it was made from
+        bool key = header.flags & PIXEL_FRAME_KEY;
+        if (frameBuffer.valid) MeshStats::bump(stats.pixelFramesDropped); // Previous one never completed
+        frameBuffer = {};
+        frameBuffer.senderId = msg.senderId;
+        frameBuffer.sequenceNumber = msg.sequenceNumber;
+        frameBuffer.totalPackets = msg.totalPackets;
+        frameBuffer.displayTime = header.displayTime;
+        // The source path and the renderer touch streamReady from other tasks
+        portENTER_CRITICAL(&streamMux);
+        frameBuffer.valid = key || (streamHasReady && streamReadySender == msg.senderId && streamReadyId == header.baseFrameId);
+        if (frameBuffer.valid && !key) memcpy(streamWorking.data(), streamReady.data(), streamWorking.size() * sizeof(CRGB));
+        portEXIT_CRITICAL(&streamMux);
+
+        if (!frameBuffer.valid) MeshStats::bump(stats.pixelFramesDropped);
+        else if (key) fill_solid(streamWorking.data(), streamWorking.size(), CRGB::Black);
+    }
+
+    if (!frameBuffer.valid) return; // Waiting for a keyframe, or already complete
+    if (frameBuffer.received[msg.packetIndex >> 3] & (1 << (msg.packetIndex & 7))) return;
+
+    int covered = PixelCodec::decode(msg.data + sizeof(PixelFrameHeader), msg.dataLength - sizeof(PixelFrameHeader),
+                                     streamWorking.data(), header.pixelStart, streamWorking.size());
+    if (covered < 0) {
+        MeshStats::bump(stats.pixelFramesDropped);
+        frameBuffer.valid = false;
+        return;
+    }
+    frameBuffer.received[msg.packetIndex >> 3] |= (1 << (msg.packetIndex & 7));
+    frameBuffer.receivedPackets++;
+
+    if (frameBuffer.receivedPackets < frameBuffer.totalPackets) return;
+
+    portENTER_CRITICAL(&streamMux);
+    streamWorking.swap(streamReady);
+    streamReadySender = frameBuffer.senderId;
+    streamReadyId = frameBuffer.sequenceNumber;
+    streamReadyDisplayTime = frameBuffer.displayTime;
+    streamReadyPending = true;
+    streamHasReady = true;
+    portEXIT_CRITICAL(&streamMux);
+
+    frameBuffer.valid = false; // Ignore late duplicates of this frame
+}
+
+bool MeshNetworkManager::presentStreamFrame(CRGB* leds, int numLeds) {
+    // Animation task: copy the newest complete frame out once its time has come
+    uint32_t now = getNetworkTime();
+    bool shown = false;
+
+    portENTER_CRITICAL(&streamMux);
+    if (streamReadyPending) {
+        int32_t wait = (int32_t)(streamReadyDisplayTime - now);
+        // A frame far in the future means the clocks disagree; don't hold it hostage
+        if (wait <= 0 || wait > 1000) {
+            int count = numLeds < (int)streamReady.size() ? numLeds : (int)streamReady.size();
+            memcpy(leds, streamReady.data(), count * sizeof(CRGB));
+            streamReadyPending = false;
+            shown = true;
+        }
+    }
+    portEXIT_CRITICAL(&streamMux);
+
+    return shown;
+}
@@ -38,6 +38,12 @@ void OtaManager::update() {
         lastCheck = 0; // force immediate check
     }
 
+    if (checkRequested) {
+        checkRequested = false;
+        forceCheck();
+        return;
+    }
+
     unsigned long elapsed = millis() - lastCheck;
     if (elapsed < checkInterval) return;
 
@@ -98,7 +104,9 @@ void OtaManager::checkForUpdates() {
 
     if (compareVersions(currentVersion.c_str(), latestVersion) < 0) {
         Serial.println("OTA: Update available");
-        performOTA(latestVersion);
+        if (restartCallback) restartCallback(true);
+        performOTA(latestVersion); // Only returns if the update failed
+        if (restartCallback) restartCallback(false);
     } else {
         Serial.println("OTA: Already up to date");
     }
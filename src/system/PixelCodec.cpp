@@ -0,0 +1,84 @@
+#include "system/PixelCodec.h"
+
+size_t PixelCodec::encode(const CRGB* frame, const CRGB* base, int start, int maxCount,
+                          uint8_t* out, size_t capacity, int& encodedCount) {
+    size_t pos = 0;
+    int i = start;
+    int end = start + maxCount;
+
+    while (i < end) {
+        // Unchanged since the base frame
+        if (base && frame[i] == base[i]) {
+            if (pos + 1 > capacity) break;
+            int n = 1;
+            while (i + n < end && n < MAX_SKIP && frame[i + n] == base[i + n]) n++;
+            out[pos++] = 0x80 | (n - 1);
+            i += n;
+            continue;
+        }
+
+        // Same colour repeated
+        int run = 1;
+        while (i + run < end && run < MAX_REPEAT && frame[i + run] == frame[i]) run++;
+        if (run >= 2) {
+            if (pos + 4 > capacity) break;
+            out[pos++] = 0x40 | (run - 1);
+            out[pos++] = frame[i].r;
+            out[pos++] = frame[i].g;
+            out[pos++] = frame[i].b;
+            i += run;
+            continue;
+        }
+
+        // Literal run up to the next skip or repeat
+        if (pos + 4 > capacity) break;
+        int room = (int)((capacity - pos - 1) / 3);
+        int n = 1;
+        while (i + n < end && n < MAX_LITERAL && n < room) {
+            const CRGB& c = frame[i + n];
+            if (base && c == base[i + n]) break;
+            if (i + n + 1 < end && c == frame[i + n + 1]) break;
+            n++;
+        }
+        out[pos++] = n - 1;
+        for (int k = 0; k < n; k++) {
+            out[pos++] = frame[i + k].r;
+            out[pos++] = frame[i + k].g;
+            out[pos++] = frame[i + k].b;
+        }
+        i += n;
+    }
+
+    encodedCount = i - start;
+    return pos;
+}
+
+int PixelCodec::decode(const uint8_t* in, size_t length, CRGB* dst, int start, int limit) {
+    size_t pos = 0;
+    int i = start;
+
+    while (pos < length) {
+        uint8_t op = in[pos++];
+
+        if (op & 0x80) {
+            i += (op & 0x7F) + 1;
+        } else if (op & 0x40) {
+            if (pos + 3 > length) return -1;
+            CRGB c(in[pos], in[pos + 1], in[pos + 2]);
+            pos += 3;
+            int n = (op & 0x3F) + 1;
+            for (int k = 0; k < n; k++, i++) {
+                if (i < limit) dst[i] = c;
+            }
+        } else {
+            int n = op + 1;
+            if (pos + (size_t)n * 3 > length) return -1;
+            for (int k = 0; k < n; k++, i++) {
+                if (i < limit) dst[i] = CRGB(in[pos], in[pos + 1], in[pos + 2]);
+                pos += 3;
+            }
+        }
+    }
+
+    return i - start;
+}
@@ -1,4 +1,5 @@
 #include "system/SystemManager.h"
+#include "audio/AudioAnalyzer.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 
@@ -33,15 +34,38 @@ void SystemManager::begin() {
 
     Serial.println("Init: Mesh...");
     mesh.begin();
+    streamFrame.assign(ledController.getNumLeds(), CRGB::Black);
     
     Serial.println("Init: Loading Config...");
     loadConfig();
+
+    // Share audio analysis across the group: the ear broadcasts, everyone else consumes
+    AudioAnalyzer::shared().setFrameListener([this](const AudioFeatures& features) {
+        mesh.broadcastAudioFeatures(features);
+    });
+    mesh.setAudioFeaturesCallback([](const AudioFeatures& features) {
+        AudioAnalyzer::shared().injectRemoteFeatures(features);
+    });
+    // Event flashes go over whatever is rendered, stream source frames included
+    animation.setFrameOverlay([this](uint32_t epoch, CRGB* leds, int numLeds) {
+        mesh.renderEvents(epoch * 10, leds, numLeds);
+    });
     
     Serial.println("Init: Web...");
     web.begin();
 
     Serial.println("Init: OTA...");
     ota.begin();
+    // Hand over mesh leadership before going dark for a firmware update
+    ota.setRestartCallback([this](bool restarting) {
+        if (restarting) mesh.prepareForRestart();
+        else mesh.cancelRestart();
+    });
+    // Same for a reboot asked for from the UI, run here in the loop rather than on the web task
+    web.setRestartCallback([this]() {
+        mesh.prepareForRestart();
+        ESP.restart();
+    });
     
     Serial.println("Init: Tasks...");
     // Start Tasks
@@ -64,6 +88,17 @@ void SystemManager::begin() {
         &meshTaskHandle,
         MESH_TASK_CORE
     );
+    mesh.setTaskHandle(meshTaskHandle);
+
+    xTaskCreatePinnedToCore(
+        audioTaskTrampoline,
+        "AudioTask",
+        AUDIO_TASK_STACK_SIZE,
+        this,
+        AUDIO_TASK_PRIORITY,
+        &audioTaskHandle,
+        AUDIO_TASK_CORE
+    );
     Serial.println("Init: Tasks done.");
 }
 
@@ -74,7 +109,11 @@ void SystemManager::update() {
     
     // Check for config changes (group or device name)
     if (mesh.getGroupName() != lastSavedGroupName || 
-        mesh.getDeviceName() != lastSavedDeviceName) {
+        mesh.getDeviceName() != lastSavedDeviceName ||
+        mesh.getAudioEar() != lastSavedAudioEar ||
+        mesh.getPixelStream() != lastSavedPixelStream ||
+        mesh.getRelay() != lastSavedMeshRelay ||
+        mesh.getExtraGroups() != lastSavedExtraGroups) {
         saveConfig();
     }
     
@@ -107,17 +146,59 @@ void SystemManager::animationTask() {
             // Or just rely on state changes.
         }
 
-        // All nodes render locally using synchronized network time
-        animation.update(networkTime / 10);
+        // Staged scene changes land on a frame boundary; a stream source renders
+        // ahead, so it switches by the time its frames will be shown
+        bool streaming = mesh.isPixelStreamActive() && animation.getPower() && !ledController.isOtaInProgress();
+        uint32_t frameTime = networkTime;
+        if (streaming && mesh.isPixelStreamSource()) frameTime += MeshNetworkManager::PIXEL_STREAM_DELAY_MS;
+        mesh.applyDueScene(frameTime);
+
+        if (streaming) {
+            // Streaming: the master renders ahead for the display time and sends
+            // the frame; everyone (master included) shows it when that time comes
+            if (mesh.isPixelStreamSource() && mesh.isPixelStreamFrameDue()) {
+                uint32_t displayTime = networkTime + MeshNetworkManager::PIXEL_STREAM_DELAY_MS;
+                animation.renderFrame(displayTime / 10, streamFrame.data(), streamFrame.size());
+                mesh.streamPixels(streamFrame.data(), streamFrame.size(), displayTime);
+            }
+            if (mesh.presentStreamFrame(ledController.getLeds(), ledController.getNumLeds())) {
+                ledController.render();
+            }
+        } else {
+            // All nodes render locally using synchronized network time
+            animation.update(networkTime / 10);
+        }
 
         vTaskDelay(10 / portTICK_PERIOD_MS);
     }
 }
 
+void SystemManager::audioTaskTrampoline(void* parameter) {
+    if (parameter) {
+        static_cast<SystemManager*>(parameter)->audioTask();
+    }
+}
+
+void SystemManager::audioTask() {
+    while (true) {
+        // The ear keeps listening for its group even when its own effect
+        // ignores audio. Sampling busy-waits on the ADC, so it lives here
+        // rather than in the render loop; an audio effect pulls frames itself.
+        Animation* current = animation.getCurrentAnimation();
+        if (!mesh.isAudioEar() || (current && current->isAudioReactive())) {
+            vTaskDelay(100 / portTICK_PERIOD_MS);
+            continue;
+        }
+        AudioAnalyzer::shared().update();
+        vTaskDelay(1); // Let the idle task (and its watchdog) in between frames
+    }
+}
+
 void SystemManager::meshTask() {
     while (true) {
         mesh.update();
-        vTaskDelay(50 / portTICK_PERIOD_MS);
+        // Sleep until a frame arrives, a relay falls due or the next housekeeping tick
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(mesh.getIdleWaitMs()));
     }
 }
 
@@ -137,7 +218,7 @@ void SystemManager::loadConfig() {
         return;
     }
 
-    StaticJsonDocument<512> doc;
+    StaticJsonDocument<768> doc;
     DeserializationError error = deserializeJson(doc, file);
     file.close();
 
@@ -159,12 +240,49 @@ void SystemManager::loadConfig() {
         lastSavedDeviceName = name;
         Serial.printf("Config: Loaded device name '%s'\n", name.c_str());
     }
+
+    if (doc.containsKey("audioEar")) {
+        bool ear = doc["audioEar"];
+        mesh.setAudioEar(ear);
+        lastSavedAudioEar = ear;
+        Serial.printf("Config: Audio ear %s\n", ear ? "enabled" : "disabled");
+    }
+
+    if (doc.containsKey("pixelStream")) {
+        bool stream = doc["pixelStream"];
+        mesh.setPixelStream(stream);
+        lastSavedPixelStream = stream;
+        Serial.printf("Config: Pixel streaming %s\n", stream ? "enabled" : "disabled");
+    }
+
+    if (doc.containsKey("meshRelay")) {
+        bool relay = doc["meshRelay"];
+        mesh.setRelay(relay);
+        lastSavedMeshRelay = relay;
+        Serial.printf("Config: Mesh relay %s\n", relay ? "enabled" : "disabled");
+    }
+
+    if (doc["extraGroups"].is<JsonArray>()) {
+        std::vector<std::string> groups;
+        for (JsonVariant group : doc["extraGroups"].as<JsonArray>()) {
+            const char* name = group.as<const char*>();
+            if (name) groups.push_back(name);
+        }
+        mesh.setExtraGroups(groups);
+        lastSavedExtraGroups = mesh.getExtraGroups();
+        Serial.printf("Config: Loaded %u extra group(s)\n", (unsigned)lastSavedExtraGroups.size());
+    }
 }
 
 void SystemManager::saveConfig() {
-    StaticJsonDocument<512> doc;
+    StaticJsonDocument<768> doc;
     doc["group"] = mesh.getGroupName();
     doc["deviceName"] = mesh.getDeviceName();
+    doc["audioEar"] = mesh.getAudioEar();
+    doc["pixelStream"] = mesh.getPixelStream();
+    doc["meshRelay"] = mesh.getRelay();
+    JsonArray extraGroups = doc.createNestedArray("extraGroups");
+    for (const auto& group : mesh.getExtraGroups()) extraGroups.add(group);
 
     File file = LittleFS.open("/config.json", "w");
     if (!file) {
@@ -177,5 +295,9 @@ void SystemManager::saveConfig() {
     
     lastSavedGroupName = mesh.getGroupName();
     lastSavedDeviceName = mesh.getDeviceName();
+    lastSavedAudioEar = mesh.getAudioEar();
+    lastSavedPixelStream = mesh.getPixelStream();
+    lastSavedMeshRelay = mesh.getRelay();
+    lastSavedExtraGroups = mesh.getExtraGroups();
     Serial.println("Config: Saved configuration");
 }
@@ -17,10 +17,17 @@ void WebManager::begin() {
 
     meshManager.setAnimationManager(&animManager);
     
-    // Register OTA Callback
+    // Register OTA Callback. Runs on the mesh task, which has to keep running
+    // through the update (e.g. to hand over leadership), so the check is deferred
     meshManager.setOtaCallback([this]() {
         Serial.println("WebManager: Triggering OTA check from mesh request");
-        otaManager.forceCheck();
+        otaManager.requestCheck();
+    });
+
+    // Scene commits switch on the animation task once their deadline passes;
+    // note it and let update() push the new state, off the render path
+    meshManager.setSceneCallback([this]() {
+        sceneChanged = true;
     });
 
     server.begin();
@@ -29,6 +36,31 @@ void WebManager::begin() {
 
 void WebManager::update() {
     ws.cleanupClients();
+
+    std::vector<String> events;
+    {
+        std::lock_guard<std::mutex> lock(pendingEventsMutex);
+        events.swap(pendingEvents);
+    }
+    for (const String& event : events) ws.textAll(event);
+
+    if (sceneChanged) {
+        sceneChanged = false;
+        ws.textAll("{\"event\":\"params\", \"data\":" + getParamsJson() + "}");
+        ws.textAll("{\"event\":\"status\", \"data\":" + getSystemStatusJson() + "}");
+    }
+
+    if (restartRequested) {
+        restartRequested = false;
+        if (restartCallback) restartCallback();
+        else ESP.restart();
+    }
+}
+
+void WebManager::queueEvent(String&& json) {
+    std::lock_guard<std::mutex> lock(pendingEventsMutex);
+    if (pendingEvents.size() >= MAX_PENDING_EVENTS) return; // Nobody draining; clients can ask again
+    pendingEvents.push_back(std::move(json));
 }
 
 void WebManager::setupRoutes() {
@@ -62,20 +94,22 @@ void WebManager::setupRoutes() {
     server.on("/api/animation", HTTP_POST, [this](AsyncWebServerRequest *request) {
         // Body handled in handler... 
     }, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-        StaticJsonDocument<200> doc;
+        DynamicJsonDocument doc(1024); // Room for a "params" object
         DeserializationError error = deserializeJson(doc, data, len);
         if (!error) {
-            if (doc.containsKey("name")) {
-                const char* name = doc["name"];
-                animManager.setAnimation(name);
-                request->send(200, "application/json", "{\"status\":\"ok\"}");
-                
-                // Broadcast to WS
-                ws.textAll("{\"event\":\"params\", \"data\":" + getParamsJson() + "}");
-                ws.textAll("{\"event\":\"status\", \"data\":" + getSystemStatusJson() + "}");
-                
-                // Broadcast to Mesh
-                meshManager.broadcastAnimationState(name, 0); 
+            if (doc.containsKey("name") || doc.containsKey("params")) {
+                // Optional "params" are applied on top of the preset, at the same moment
+                const char* name = doc["name"] | "";
+                String params;
+                if (doc["params"].is<JsonObject>()) serializeJson(doc["params"], params);
+
+                // Clients hear the new params/status from the scene callback once it applies
+                uint32_t applyAt = meshManager.commitScene(name, params.c_str());
+                if (applyAt == 0) {
+                    request->send(400, "application/json", "{\"error\":\"Params too large\"}");
+                    return;
+                }
+                request->send(200, "application/json", "{\"status\":\"ok\",\"applyAt\":" + String(applyAt) + "}");
             }
         }
     });
@@ -155,12 +189,34 @@ void WebManager::setupRoutes() {
     // API: Check Preset Exists
     server.on("/api/checkPreset", HTTP_GET, [this](AsyncWebServerRequest *request) {
         if (request->hasParam("name")) {
-            String name = request->getParam("name")->value();
-            bool exists = meshManager.checkPresetExists(name.c_str());
-            String json = "{\"exists\":";
-            json += (exists ? "true" : "false");
-            json += "}";
-            request->send(200, "application/json", json);
+            std::string name = request->getParam("name")->value().c_str();
+            int known = meshManager.lookupPresetExists(name);
+            if (known >= 0) {
+                request->send(200, "application/json", known ? "{\"exists\":true}" : "{\"exists\":false}");
+                return;
+            }
+            // Ask the mesh without holding up the async TCP task: the answer
+            // goes out as a "presetExists" event, and asking again once it's
+            // in gets it from the cache
+            uint32_t id = meshManager.queryPresetExists(name, [this, name](uint32_t queryId, bool exists) {
+                StaticJsonDocument<192> doc;
+                doc["event"] = "presetExists";
+                JsonObject data = doc.createNestedObject("data");
+                data["id"] = queryId;
+                data["name"] = name.c_str();
+                data["exists"] = exists;
+                String output;
+                serializeJson(doc, output);
+                queueEvent(std::move(output)); // Resolved on the mesh task
+            });
+            if (id == 0) {
+                // Not "missing": the mesh just has too many questions out
+                AsyncWebServerResponse *response = request->beginResponse(503, "application/json", "{\"error\":\"Busy, try again\"}");
+                response->addHeader("Retry-After", "1");
+                request->send(response);
+                return;
+            }
+            request->send(202, "application/json", "{\"pending\":true,\"id\":" + String(id) + "}");
         } else {
              request->send(400, "application/json", "{\"error\":\"Missing name param\"}");
         }
@@ -177,6 +233,11 @@ void WebManager::setupRoutes() {
         request->send(200, "application/json", getPeersJson());
     });
 
+    // API: Mesh Telemetry
+    server.on("/api/mesh/stats", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(200, "application/json", getMeshStatsJson());
+    });
+
     // API: Assign Group
     server.on("/api/mesh/assign_group", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
         StaticJsonDocument<256> doc;
@@ -210,6 +271,106 @@ void WebManager::setupRoutes() {
         }
     });
 
+    // API: Designate this node as its group's audio ear
+    server.on("/api/mesh/audio_ear", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        StaticJsonDocument<128> doc;
+        DeserializationError error = deserializeJson(doc, data, len);
+        if (!error && doc.containsKey("enabled")) {
+            meshManager.setAudioEar(doc["enabled"].as<bool>());
+            request->send(200, "application/json", "{\"status\":\"ok\"}");
+        } else {
+            request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        }
+    });
+
+    // API: Master renders and streams pixels to its group
+    server.on("/api/mesh/pixel_stream", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        StaticJsonDocument<128> doc;
+        DeserializationError error = deserializeJson(doc, data, len);
+        if (!error && doc.containsKey("enabled")) {
+            meshManager.setPixelStream(doc["enabled"].as<bool>());
+            request->send(200, "application/json", "{\"status\":\"ok\"}");
+        } else {
+            request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        }
+    });
+
+    // API: Rebroadcast other nodes' frames to extend the mesh
+    server.on("/api/mesh/relay", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        StaticJsonDocument<128> doc;
+        DeserializationError error = deserializeJson(doc, data, len);
+        if (!error && doc.containsKey("enabled")) {
+            meshManager.setRelay(doc["enabled"].as<bool>());
+            request->send(200, "application/json", "{\"status\":\"ok\"}");
+        } else {
+            request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        }
+    });
+
+    // API: Mesh Event (beat / flash / trigger across the group, for DJ tools)
+    server.on("/api/mesh/event", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        StaticJsonDocument<192> doc;
+        DeserializationError error = deserializeJson(doc, data, len);
+        if (!error) {
+            uint32_t fireAt = triggerEvent(doc.as<JsonObject>());
+            request->send(200, "application/json", "{\"status\":\"ok\",\"fireAt\":" + String(fireAt) + "}");
+        } else {
+            request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        }
+    });
+
+    // API: Extra Group Memberships (commands only; the primary group comes from assignGroup)
+    server.on("/api/mesh/groups", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        StaticJsonDocument<384> doc;
+        DeserializationError error = deserializeJson(doc, data, len);
+        if (!error && doc["groups"].is<JsonArray>()) {
+            std::vector<std::string> groups;
+            for (JsonVariant group : doc["groups"].as<JsonArray>()) {
+                const char* name = group.as<const char*>();
+                if (name) groups.push_back(name);
+            }
+            meshManager.setExtraGroups(groups);
+            request->send(200, "application/json", "{\"status\":\"ok\"}");
+        } else {
+            request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        }
+    });
+
+    // API: Audio Replay (WAV from LittleFS instead of the microphone)
+    server.on("/api/audio/replay", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        StaticJsonDocument<256> doc;
+        DeserializationError error = deserializeJson(doc, data, len);
+        if (error) {
+            request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+            return;
+        }
+        if (doc["stop"] | false) {
+            animManager.stopAudioReplay();
+            request->send(200, "application/json", "{\"status\":\"stopped\"}");
+        } else if (doc.containsKey("file")) {
+            animManager.startAudioReplay(doc["file"].as<const char*>(), doc["realtime"] | true, doc["loop"] | false);
+            request->send(200, "application/json", "{\"status\":\"ok\"}");
+        } else {
+            request->send(400, "application/json", "{\"error\":\"Missing file\"}");
+        }
+    });
+
+    // API: Audio Benchmark (runs in slices on the animation task, poll GET for progress and the result)
+    server.on("/api/audio/benchmark", HTTP_POST, [this](AsyncWebServerRequest *request) {}, NULL, [this](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+        StaticJsonDocument<256> doc;
+        DeserializationError error = deserializeJson(doc, data, len);
+        if (!error && doc.containsKey("file")) {
+            animManager.requestAudioBenchmark(doc["file"].as<const char*>());
+            request->send(202, "application/json", "{\"status\":\"queued\"}");
+        } else {
+            request->send(400, "application/json", "{\"error\":\"Missing file\"}");
+        }
+    });
+
+    server.on("/api/audio/benchmark", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        request->send(200, "application/json", getAudioBenchmarkJson());
+    });
+
     // API: Trigger OTA Check (Legacy/Backup)
     server.on("/api/ota/check", HTTP_POST, [this](AsyncWebServerRequest *request) {
         Serial.println("API: Triggering OTA check");
@@ -348,24 +509,27 @@ void WebManager::handleWebSocketMessage(AsyncWebSocketClient *client, void *arg,
                    // Broadcast new params to all connected clients
                    ws.textAll("{\"event\":\"params\", \"data\":" + getParamsJson() + "}");
                    
-                   // Broadcast to Mesh Group DISABLED for Frontend Sync (as per user request previously, they might want it back?)
-                   // Current logic: Frontend sends to each device individually via WS if needed.
-                   // Actually, for setParam, we usually want group sync if it's a "Group" action.
-                   // But "setParam" from UI is usually device specific target.
-                   // Let's keep mesh broadcast DISABLED here for now as established.
+                   // "setParam" from UI is device specific by default; the frontend
+                   // opts into group sync with "group": true (binary SYNC_PARAM, cheap
+                   // enough to stream while a slider is dragged)
+                   if (doc["group"].as<bool>()) {
+                       AnimationParameter* param = current->findParameter(name);
+                       if (param) meshManager.broadcastSyncParam(*param);
+                   }
                }
             }
         } 
+        else if (strcmp(cmd, "event") == 0) {
+             // A tap in the UI: the WebSocket is already open, so this is the quickest way in
+             triggerEvent(doc.as<JsonObject>());
+        }
         else if (strcmp(cmd, "setAnimation") == 0) {
-             const char* name = doc["name"];
-             animManager.setAnimation(name);
-             ws.textAll("{\"event\":\"params\", \"data\":" + getParamsJson() + "}");
-             ws.textAll("{\"event\":\"status\", \"data\":" + getSystemStatusJson() + "}");
-             
-             // Broadcast to Mesh Group (Now enabled!)
-             meshManager.broadcastAnimationState(name, 0);
+             const char* name = doc["name"] | "";
+             // Switches here and across the group together; the scene callback pushes the new state
+             meshManager.commitScene(name);
         } else if (strcmp(cmd, "reboot") == 0) {
-             ESP.restart();
+             // The handover waits on the mesh; don't hold the web task for it
+             restartRequested = true;
         } else if (strcmp(cmd, "setPower") == 0) {
              bool p = doc["value"];
              animManager.setPower(p);
@@ -454,8 +618,29 @@ void WebManager::handleWebSocketMessage(AsyncWebSocketClient *client, void *arg,
     }
 }
 
+// {"kind": "beat" | "flash" | "trigger", "color": "#RRGGBB", "intensity": 0-255, "duration": ms},
+// all optional. Beats default to a short white pulse, everything else to a full flash.
+uint32_t WebManager::triggerEvent(JsonObject args) {
+    const char* kindName = args["kind"] | "flash";
+    MeshEventKind kind = MeshEventKind::FLASH;
+    if (strcmp(kindName, "beat") == 0) kind = MeshEventKind::BEAT;
+    else if (strcmp(kindName, "trigger") == 0) kind = MeshEventKind::TRIGGER;
+    bool beat = kind == MeshEventKind::BEAT;
+
+    CRGB color = CRGB::White;
+    const char* hex = args["color"];
+    if (hex && hex[0] == '#' && strlen(hex) == 7) {
+        int r, g, b;
+        if (sscanf(hex + 1, "%02x%02x%02x", &r, &g, &b) == 3) color = CRGB(r, g, b);
+    }
+    uint8_t intensity = args["intensity"] | (beat ? 160 : 255);
+    uint16_t duration = args["duration"] | (beat ? 120 : 400);
+
+    return meshManager.broadcastEvent(kind, color, intensity, duration);
+}
+
 String WebManager::getSystemStatusJson() {
-    StaticJsonDocument<512> doc;
+    StaticJsonDocument<768> doc;
     doc["uptime"] = millis();
     doc["heap"] = ESP.getFreeHeap();
     doc["animation"] = animManager.getCurrentAnimationName();
@@ -463,6 +648,14 @@ String WebManager::getSystemStatusJson() {
     doc["ip"] = WiFi.localIP().toString();
     doc["version"] = otaManager.getVersion();
     doc["phase"] = animManager.getDevicePhase();
+    doc["audioEar"] = meshManager.getAudioEar();
+    doc["audioEarActive"] = meshManager.isAudioEar();
+    doc["clockDriftPpm"] = meshManager.getClockDriftPpm();
+    doc["pixelStream"] = meshManager.getPixelStream();
+    doc["pixelStreamActive"] = meshManager.isPixelStreamActive();
+    doc["meshRelay"] = meshManager.getRelay();
+    JsonArray extraGroups = doc.createNestedArray("extraGroups");
+    for (const auto& group : meshManager.getExtraGroups()) extraGroups.add(group);
     String output;
     serializeJson(doc, output);
     return output;
@@ -541,21 +734,32 @@ String WebManager::getParamsJson() {
 
 
 String WebManager::getPeersJson() {
-    StaticJsonDocument<2048> doc;
+    uint32_t generation = meshManager.getPeerGeneration();
+    bool master = meshManager.isMaster();
+    std::string group = meshManager.getGroupName();
+    std::string name = meshManager.getDeviceName();
+    if (peersJsonValid && generation == peersJsonGeneration && master == peersJsonMaster &&
+        group == peersJsonGroup && name == peersJsonName) {
+        return peersJsonCache;
+    }
+
+    size_t count = meshManager.getPeers(peerScratch, MeshNetworkManager::MAX_PEERS);
+
+    DynamicJsonDocument doc(512 + count * 384);
     JsonArray arr = doc.to<JsonArray>();
     
     // Self
     JsonObject self = arr.createNestedObject();
     self["id"] = "local";
     self["ip"] = WiFi.localIP().toString();
-    self["role"] = meshManager.isMaster() ? "MASTER" : "SLAVE";
-    self["group"] = meshManager.getGroupName();
-    self["name"] = meshManager.getDeviceName();
+    self["role"] = master ? "MASTER" : "SLAVE";
+    self["group"] = group;
+    self["name"] = name;
     self["self"] = true;
 
     // Mesh Peers
-    std::vector<PeerInfo> peers = meshManager.getPeers();
-    for (const auto& peer : peers) {
+    for (size_t i = 0; i < count; i++) {
+        const PeerInfo& peer = peerScratch[i];
         JsonObject obj = arr.createNestedObject();
         char idStr[17];
         sprintf(idStr, "%016llX", peer.id);
@@ -564,10 +768,107 @@ String WebManager::getPeersJson() {
         obj["role"] = (peer.role == NodeState::MASTER) ? "MASTER" : "SLAVE";
         obj["group"] = peer.groupName;
         obj["name"] = peer.deviceName;
-        obj["lastSeen"] = peer.lastSeen;
+        obj["lastSeen"] = peer.lastSeenReported;
         obj["self"] = false;
     }
 
+    peersJsonCache = "";
+    serializeJson(doc, peersJsonCache);
+    peersJsonValid = true;
+    peersJsonGeneration = generation;
+    peersJsonMaster = master;
+    peersJsonGroup = group;
+    peersJsonName = name;
+    return peersJsonCache;
+}
+
+String WebManager::getMeshStatsJson() {
+    const MeshStats& stats = meshManager.getStats();
+    size_t count = meshManager.getPeers(peerScratch, MeshNetworkManager::MAX_PEERS);
+
+    DynamicJsonDocument doc(2048 + count * 96);
+    doc["uptime"] = millis();
+
+    // Per message type, only those seen: [rxPackets, rxBytes, txPackets, txBytes]
+    JsonObject types = doc.createNestedObject("types");
+    for (int i = 0; i < MESH_STATS_TYPES; i++) {
+        const MeshStats::TypeCounters& t = stats.types[i];
+        uint32_t rxPackets = t.rxPackets.load(std::memory_order_relaxed);
+        uint32_t txPackets = t.txPackets.load(std::memory_order_relaxed);
+        if (!rxPackets && !txPackets) continue;
+        JsonArray row = types.createNestedArray(MeshNetworkManager::messageTypeName((MessageType)i));
+        row.add(rxPackets);
+        row.add(t.rxBytes.load(std::memory_order_relaxed));
+        row.add(txPackets);
+        row.add(t.txBytes.load(std::memory_order_relaxed));
+    }
+
+    JsonObject health = doc.createNestedObject("health");
+    health["txFailures"] = stats.txFailures.load(std::memory_order_relaxed);
+    health["txCallbackFailures"] = stats.txCallbackFailures.load(std::memory_order_relaxed);
+    health["unicastFallbacks"] = stats.unicastFallbacks.load(std::memory_order_relaxed);
+    health["rxQueueDrops"] = stats.rxQueueDrops.load(std::memory_order_relaxed);
+    health["outboxCoalesced"] = stats.outboxCoalesced.load(std::memory_order_relaxed);
+    health["outboxDrops"] = stats.outboxDrops.load(std::memory_order_relaxed);
+    health["rxMalformed"] = stats.rxMalformed.load(std::memory_order_relaxed);
+    health["groupFiltered"] = stats.groupFiltered.load(std::memory_order_relaxed);
+    health["duplicates"] = stats.duplicates.load(std::memory_order_relaxed);
+    health["outOfOrder"] = stats.outOfOrder.load(std::memory_order_relaxed);
+    health["reassemblyTimeouts"] = stats.reassemblyTimeouts.load(std::memory_order_relaxed);
+    health["bulkRetransmits"] = stats.bulkRetransmits.load(std::memory_order_relaxed);
+    health["pixelFramesDropped"] = stats.pixelFramesDropped.load(std::memory_order_relaxed);
+    health["pixelFramesSkipped"] = stats.pixelFramesSkipped.load(std::memory_order_relaxed);
+    health["relayed"] = stats.relayed.load(std::memory_order_relaxed);
+    health["relaySuppressed"] = stats.relaySuppressed.load(std::memory_order_relaxed);
+    health["gossipSuppressed"] = stats.gossipSuppressed.load(std::memory_order_relaxed);
+    health["scenesLate"] = stats.scenesLate.load(std::memory_order_relaxed);
+    health["eventsLate"] = stats.eventsLate.load(std::memory_order_relaxed);
+    health["takeovers"] = stats.takeovers.load(std::memory_order_relaxed);
+    health["handovers"] = stats.handovers.load(std::memory_order_relaxed);
+    health["elections"] = stats.elections.load(std::memory_order_relaxed);
+    health["masterChanges"] = stats.masterChanges.load(std::memory_order_relaxed);
+
+    JsonObject sync = doc.createNestedObject("sync");
+    sync["offsetErrorUs"] = stats.syncOffsetError.load(std::memory_order_relaxed);
+    sync["jitterUs"] = stats.syncJitter.load(std::memory_order_relaxed);
+    sync["delayUs"] = stats.syncDelay.load(std::memory_order_relaxed);
+    sync["samples"] = stats.syncSamples.load(std::memory_order_relaxed);
+    sync["steps"] = stats.syncSteps.load(std::memory_order_relaxed);
+    sync["driftPpm"] = meshManager.getClockDriftPpm();
+
+    unsigned long now = millis();
+    JsonArray peers = doc.createNestedArray("peers");
+    for (size_t i = 0; i < count; i++) {
+        const PeerInfo& peer = peerScratch[i];
+        JsonArray row = peers.createNestedArray(); // [id, rssi, msSinceLastFrame]
+        char idStr[17];
+        sprintf(idStr, "%016llX", peer.id);
+        row.add(idStr);
+        row.add(peer.rssi);
+        row.add(now - peer.lastSeen);
+    }
+
+    String output;
+    serializeJson(doc, output);
+    return output;
+}
+
+String WebManager::getAudioBenchmarkJson() {
+    StaticJsonDocument<512> doc;
+    AudioBenchmark::Result r = animManager.getAudioBenchmarkResult();
+    doc["pending"] = animManager.isAudioBenchmarkPending();
+    doc["progress"] = animManager.getAudioBenchmarkProgress();
+    doc["ok"] = r.ok;
+    if (!r.ok && !r.error.empty()) doc["error"] = r.error;
+    doc["frames"] = r.frames;
+    doc["analysisUsAvg"] = r.avgAnalysisMicros;
+    doc["analysisUsMax"] = r.maxAnalysisMicros;
+    doc["renderUsAvg"] = r.avgRenderMicros;
+    doc["renderUsMax"] = r.maxRenderMicros;
+    doc["kicks"] = r.kicks;
+    doc["responses"] = r.responses;
+    doc["latencyMsAvg"] = r.avgLatencyMs;
+    doc["latencyMsMax"] = r.maxLatencyMs;
     String output;
     serializeJson(doc, output);
     return output;
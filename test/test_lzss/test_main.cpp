@@ -0,0 +1,97 @@
+#include <unity.h>
+#include "system/Lzss.h"
+#include <string>
+#include <vector>
+
+static uint32_t rng = 1;
+static uint8_t nextByte() {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 24;
+}
+
+void setUp() { rng = 1; }
+void tearDown() {}
+
+// Encodes into a buffer sized like the input plus headroom and decodes back;
+// returns the encoded size
+static size_t roundTrip(const std::vector<uint8_t>& in) {
+    std::vector<uint8_t> encoded(in.size() + in.size() / 8 + 16);
+    size_t length = Lzss::encode(in.data(), in.size(), encoded.data(), encoded.size());
+    TEST_ASSERT_GREATER_THAN(0, length);
+
+    std::vector<uint8_t> decoded(in.size());
+    TEST_ASSERT_EQUAL_INT((int)in.size(), Lzss::decode(encoded.data(), length, decoded.data(), decoded.size()));
+    TEST_ASSERT_EQUAL_MEMORY(in.data(), decoded.data(), in.size());
+    return length;
+}
+
+static std::vector<uint8_t> bytes(const std::string& s) {
+    return std::vector<uint8_t>(s.begin(), s.end());
+}
+
+static void test_preset_json_round_trip() {
+    std::string json = "{\"name\":\"Sunset\",\"type\":\"Gradient\",\"params\":{";
+    for (int i = 0; i < 20; i++) {
+        json += "\"colour" + std::to_string(i) + "\":{\"r\":" + std::to_string(i * 7) + ",\"g\":12,\"b\":200},";
+    }
+    json += "\"speed\":1.5}}";
+    size_t length = roundTrip(bytes(json));
+    TEST_ASSERT_LESS_THAN(json.size() / 2, length);
+}
+
+static void test_overlapping_match() {
+    // A run is one literal, then matches copying from just behind themselves
+    std::vector<uint8_t> run(1000, 'a');
+    size_t length = roundTrip(run);
+    TEST_ASSERT_LESS_THAN(150, length);
+}
+
+static void test_beyond_the_window() {
+    // Text from a small alphabet, longer than the window several times over
+    std::vector<uint8_t> text(20000);
+    for (auto& c : text) c = 'a' + nextByte() % 6;
+    roundTrip(text);
+}
+
+static void test_incompressible_input_needs_no_saving() {
+    std::vector<uint8_t> noise(500);
+    for (auto& c : noise) c = nextByte();
+    std::vector<uint8_t> encoded(noise.size());
+    // Capacity = length only accepts a saving, which noise can't give
+    TEST_ASSERT_EQUAL_size_t(0, Lzss::encode(noise.data(), noise.size(), encoded.data(), encoded.size()));
+    roundTrip(noise);
+}
+
+static void test_rejects_oversized_input() {
+    std::vector<uint8_t> big(Lzss::MAX_INPUT + 1, 'x');
+    std::vector<uint8_t> encoded(big.size());
+    TEST_ASSERT_EQUAL_size_t(0, Lzss::encode(big.data(), big.size(), encoded.data(), encoded.size()));
+    big.pop_back();
+    roundTrip(big);
+}
+
+static void test_decode_rejects_malformed_streams() {
+    uint8_t out[64];
+    // A match before any output
+    uint8_t early[] = {0x00, 0x00, 0x00};
+    TEST_ASSERT_EQUAL_INT(-1, Lzss::decode(early, sizeof(early), out, sizeof(out)));
+    // A literal, then a match cut short
+    uint8_t cut[] = {0x01, 'a', 0x00};
+    TEST_ASSERT_EQUAL_INT(-1, Lzss::decode(cut, sizeof(cut), out, sizeof(out)));
+    // Longer than the caller's buffer
+    uint8_t run[] = {0x01, 'a', 0x00, 0x0F};
+    TEST_ASSERT_EQUAL_INT(19, Lzss::decode(run, sizeof(run), out, sizeof(out)));
+    TEST_ASSERT_EQUAL_INT(-1, Lzss::decode(run, sizeof(run), out, 10));
+    TEST_ASSERT_EQUAL_INT(-1, Lzss::decode(run, 2, out, 0));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_preset_json_round_trip);
+    RUN_TEST(test_overlapping_match);
+    RUN_TEST(test_beyond_the_window);
+    RUN_TEST(test_incompressible_input_needs_no_saving);
+    RUN_TEST(test_rejects_oversized_input);
+    RUN_TEST(test_decode_rejects_malformed_streams);
+    return UNITY_END();
+}
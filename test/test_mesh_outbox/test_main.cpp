@@ -0,0 +1,103 @@
+#include <unity.h>
+#include "system/MeshOutbox.h"
+
+typedef MeshOutbox<int, 4> Outbox;
+
+void setUp() {}
+void tearDown() {}
+
+static int popValue(Outbox& outbox) {
+    const Outbox::Entry* entry = outbox.front();
+    TEST_ASSERT_NOT_NULL(entry);
+    int value = entry->msg;
+    outbox.popFront();
+    return value;
+}
+
+static void test_urgent_classes_first_then_push_order() {
+    Outbox outbox;
+    TEST_ASSERT_NULL(outbox.front());
+    outbox.push(3, 0, 0, 30);
+    outbox.push(1, 0, 0, 10);
+    outbox.push(3, 0, 0, 31);
+    outbox.push(0, 0, 0, 0);
+    TEST_ASSERT_EQUAL_size_t(2, outbox.count(3));
+
+    TEST_ASSERT_EQUAL_INT(0, popValue(outbox));
+    TEST_ASSERT_EQUAL_INT(10, popValue(outbox));
+    TEST_ASSERT_EQUAL_INT(30, popValue(outbox));
+    TEST_ASSERT_EQUAL_INT(31, popValue(outbox));
+    TEST_ASSERT_EQUAL_size_t(0, outbox.size());
+}
+
+static void test_coalescing_keeps_the_turn() {
+    Outbox outbox;
+    outbox.push(1, 7, 0, 1);
+    outbox.push(1, 0, 0, 2);
+    TEST_ASSERT_TRUE(outbox.push(1, 7, 5, 3) == Outbox::Result::COALESCED);
+    TEST_ASSERT_EQUAL_size_t(2, outbox.size());
+
+    const Outbox::Entry* entry = outbox.front();
+    TEST_ASSERT_EQUAL_INT(3, entry->msg); // Latest value, first slot
+    TEST_ASSERT_EQUAL_UINT64(5, entry->dest);
+    outbox.popFront();
+    TEST_ASSERT_EQUAL_INT(2, popValue(outbox));
+}
+
+static void test_key_zero_never_coalesces() {
+    Outbox outbox;
+    TEST_ASSERT_TRUE(outbox.push(1, 0, 0, 1) == Outbox::Result::QUEUED);
+    TEST_ASSERT_TRUE(outbox.push(1, 0, 0, 2) == Outbox::Result::QUEUED);
+    TEST_ASSERT_EQUAL_size_t(2, outbox.size());
+}
+
+static void test_full_evicts_newest_of_least_urgent() {
+    Outbox outbox;
+    outbox.push(3, 0, 0, 30);
+    outbox.push(3, 0, 0, 31);
+    outbox.push(2, 0, 0, 20);
+    outbox.push(1, 0, 0, 10);
+    TEST_ASSERT_EQUAL_size_t(0, outbox.free());
+
+    TEST_ASSERT_TRUE(outbox.push(0, 0, 0, 0) == Outbox::Result::EVICTED);
+    TEST_ASSERT_EQUAL_size_t(1, outbox.count(3));
+    TEST_ASSERT_EQUAL_INT(0, popValue(outbox));
+    TEST_ASSERT_EQUAL_INT(10, popValue(outbox));
+    TEST_ASSERT_EQUAL_INT(20, popValue(outbox));
+    TEST_ASSERT_EQUAL_INT(30, popValue(outbox)); // 31 was the one evicted
+}
+
+static void test_full_refuses_equal_or_less_urgent() {
+    Outbox outbox;
+    for (int i = 0; i < 4; i++) outbox.push(1, 0, 0, i);
+    TEST_ASSERT_TRUE(outbox.push(1, 0, 0, 4) == Outbox::Result::DROPPED);
+    TEST_ASSERT_TRUE(outbox.push(2, 0, 0, 5) == Outbox::Result::DROPPED);
+    TEST_ASSERT_EQUAL_INT(0, popValue(outbox));
+
+    // Coalescing needs no free slot
+    outbox.push(1, 9, 0, 6);
+    TEST_ASSERT_TRUE(outbox.push(1, 9, 0, 7) == Outbox::Result::COALESCED);
+}
+
+static void test_push_order_survives_slot_reuse() {
+    Outbox outbox;
+    for (int round = 0; round < 10; round++) {
+        outbox.push(2, 0, 0, round * 10);
+        outbox.push(2, 0, 0, round * 10 + 1);
+        TEST_ASSERT_EQUAL_INT(round * 10, popValue(outbox));
+        outbox.push(2, 0, 0, round * 10 + 2);
+        TEST_ASSERT_EQUAL_INT(round * 10 + 1, popValue(outbox));
+        TEST_ASSERT_EQUAL_INT(round * 10 + 2, popValue(outbox));
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_urgent_classes_first_then_push_order);
+    RUN_TEST(test_coalescing_keeps_the_turn);
+    RUN_TEST(test_key_zero_never_coalesces);
+    RUN_TEST(test_full_evicts_newest_of_least_urgent);
+    RUN_TEST(test_full_refuses_equal_or_less_urgent);
+    RUN_TEST(test_push_order_survives_slot_reuse);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <unity.h>
+#include "system/PixelCodec.h"
+#include <cstring>
+#include <vector>
+
+static const int LEDS = 300;
+static const size_t CHUNK = 213; // MESH_MAX_DATA less the PixelFrameHeader
+
+static uint32_t rng = 1;
+static uint8_t nextByte() {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 24;
+}
+
+static CRGB randomColor() {
+    return CRGB(nextByte(), nextByte(), nextByte());
+}
+
+void setUp() { rng = 1; }
+void tearDown() {}
+
+// Encodes the whole frame chunk by chunk and decodes each chunk into dst
+static size_t roundTrip(const std::vector<CRGB>& frame, const CRGB* base, std::vector<CRGB>& dst) {
+    uint8_t buffer[CHUNK];
+    size_t total = 0;
+    int start = 0;
+    while (start < LEDS) {
+        int count = 0;
+        size_t length = PixelCodec::encode(frame.data(), base, start, LEDS - start, buffer, sizeof(buffer), count);
+        TEST_ASSERT_GREATER_THAN(0, count);
+        TEST_ASSERT_LESS_OR_EQUAL(sizeof(buffer), length);
+        TEST_ASSERT_EQUAL_INT(count, PixelCodec::decode(buffer, length, dst.data(), start, LEDS));
+        total += length;
+        start += count;
+    }
+    TEST_ASSERT_EQUAL_INT(LEDS, start);
+    return total;
+}
+
+static void test_keyframe_round_trip() {
+    std::vector<CRGB> frame(LEDS);
+    for (auto& c : frame) c = randomColor();
+    std::vector<CRGB> dst(LEDS);
+    size_t length = roundTrip(frame, nullptr, dst);
+    TEST_ASSERT_EQUAL_MEMORY(frame.data(), dst.data(), LEDS * sizeof(CRGB));
+    // Noise doesn't compress; literals cost one op byte per 64 pixels at most
+    TEST_ASSERT_LESS_OR_EQUAL(LEDS * 3 + LEDS / 8, length);
+}
+
+static void test_solid_runs_compress() {
+    std::vector<CRGB> frame(LEDS);
+    for (int i = 0; i < LEDS; i++) frame[i] = i < LEDS / 2 ? CRGB(255, 0, 0) : CRGB(0, 0, 255);
+    std::vector<CRGB> dst(LEDS);
+    size_t length = roundTrip(frame, nullptr, dst);
+    TEST_ASSERT_EQUAL_MEMORY(frame.data(), dst.data(), LEDS * sizeof(CRGB));
+    TEST_ASSERT_LESS_OR_EQUAL(6 * 4, length); // 150-pixel runs need three repeat ops each
+}
+
+static void test_delta_skips_unchanged_pixels() {
+    std::vector<CRGB> base(LEDS);
+    for (auto& c : base) c = randomColor();
+    std::vector<CRGB> frame = base;
+    frame[10] = CRGB(1, 2, 3);
+    frame[200] = CRGB(4, 5, 6);
+    frame[201] = CRGB(7, 8, 9);
+
+    std::vector<CRGB> dst = base; // Receivers apply deltas over their copy of the base
+    size_t length = roundTrip(frame, base.data(), dst);
+    TEST_ASSERT_EQUAL_MEMORY(frame.data(), dst.data(), LEDS * sizeof(CRGB));
+    TEST_ASSERT_LESS_OR_EQUAL(20, length);
+}
+
+static void test_stops_at_capacity() {
+    std::vector<CRGB> frame(LEDS);
+    for (auto& c : frame) c = randomColor();
+    uint8_t buffer[64 + 4];
+    memset(buffer, 0xEE, sizeof(buffer));
+    int count = 0;
+    size_t length = PixelCodec::encode(frame.data(), nullptr, 0, LEDS, buffer, 64, count);
+    TEST_ASSERT_LESS_OR_EQUAL(64, length);
+    TEST_ASSERT_EQUAL_INT(21, count); // One op byte plus 21 pixels of 3 bytes
+    for (size_t i = 64; i < sizeof(buffer); i++) TEST_ASSERT_EQUAL_UINT8(0xEE, buffer[i]);
+}
+
+static void test_decode_drops_pixels_past_limit() {
+    uint8_t chunk[] = {0x40 | 9, 10, 20, 30}; // Ten copies
+    CRGB dst[8];
+    int covered = PixelCodec::decode(chunk, sizeof(chunk), dst, 0, 5);
+    TEST_ASSERT_EQUAL_INT(10, covered);
+    for (int i = 0; i < 5; i++) TEST_ASSERT_TRUE(dst[i] == CRGB(10, 20, 30));
+    for (int i = 5; i < 8; i++) TEST_ASSERT_TRUE(dst[i] == CRGB(0, 0, 0));
+}
+
+static void test_decode_rejects_truncated_chunks() {
+    CRGB dst[8];
+    uint8_t literal[] = {2, 1, 2, 3, 4, 5, 6, 7, 8}; // Three pixels announced, 8 of 9 bytes
+    TEST_ASSERT_EQUAL_INT(-1, PixelCodec::decode(literal, sizeof(literal), dst, 0, 8));
+    uint8_t repeat[] = {0x40 | 3, 1, 2};
+    TEST_ASSERT_EQUAL_INT(-1, PixelCodec::decode(repeat, sizeof(repeat), dst, 0, 8));
+    uint8_t skip[] = {0x80 | 4};
+    TEST_ASSERT_EQUAL_INT(5, PixelCodec::decode(skip, sizeof(skip), dst, 0, 8));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_keyframe_round_trip);
+    RUN_TEST(test_solid_runs_compress);
+    RUN_TEST(test_delta_skips_unchanged_pixels);
+    RUN_TEST(test_stops_at_capacity);
+    RUN_TEST(test_decode_drops_pixels_past_limit);
+    RUN_TEST(test_decode_rejects_truncated_chunks);
+    return UNITY_END();
+}
@@ -0,0 +1,111 @@
+#include <unity.h>
+#include "system/SpscRing.h"
+#include <atomic>
+#include <thread>
+
+void setUp() {}
+void tearDown() {}
+
+static void test_pops_in_push_order() {
+    SpscRing<int, 8> ring;
+    TEST_ASSERT_TRUE(ring.empty());
+    for (int i = 0; i < 5; i++) TEST_ASSERT_TRUE(ring.push(i));
+    int value;
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_INT(i, value);
+    }
+    TEST_ASSERT_FALSE(ring.pop(value));
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+static void test_full_ring_counts_drops() {
+    // One slot stays free to tell full from empty
+    SpscRing<int, 4> ring;
+    TEST_ASSERT_TRUE(ring.push(1));
+    TEST_ASSERT_TRUE(ring.push(2));
+    TEST_ASSERT_TRUE(ring.push(3));
+    TEST_ASSERT_FALSE(ring.push(4));
+    TEST_ASSERT_NULL(ring.reserve());
+    TEST_ASSERT_EQUAL_UINT32(2, ring.takeDropped());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.takeDropped());
+
+    int value;
+    TEST_ASSERT_TRUE(ring.pop(value));
+    TEST_ASSERT_EQUAL_INT(1, value);
+    TEST_ASSERT_TRUE(ring.push(4));
+}
+
+static void test_reserve_commit_and_peek_release() {
+    SpscRing<int, 4> ring;
+    int* slot = ring.reserve();
+    TEST_ASSERT_NOT_NULL(slot);
+    *slot = 42;
+    TEST_ASSERT_TRUE(ring.empty()); // Not visible until committed
+    ring.commit();
+
+    const int* item = ring.peek();
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_EQUAL_INT(42, *item);
+    TEST_ASSERT_NOT_NULL(ring.peek()); // Peeking doesn't consume
+    ring.release();
+    TEST_ASSERT_NULL(ring.peek());
+}
+
+static void test_wraps_around() {
+    SpscRing<int, 4> ring;
+    int value;
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_TRUE(ring.push(i));
+        TEST_ASSERT_TRUE(ring.push(i + 100));
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_INT(i, value);
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_INT(i + 100, value);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, ring.takeDropped());
+}
+
+static void test_producer_and_consumer_threads() {
+    // Every value arrives exactly once and in order, or is counted as dropped
+    static const uint32_t COUNT = 200000;
+    SpscRing<uint32_t, 64> ring;
+    uint32_t pushed = 0;
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < COUNT; i++) {
+            if (ring.push(i)) pushed++;
+        }
+        done = true;
+    });
+
+    uint32_t received = 0;
+    uint32_t last = 0;
+    bool ordered = true;
+    uint32_t value;
+    while (true) {
+        bool finished = done; // Everything pushed before this is drained below
+        while (ring.pop(value)) {
+            if (received && value <= last) ordered = false;
+            last = value;
+            received++;
+        }
+        if (finished) break;
+        std::this_thread::yield();
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_EQUAL_UINT32(pushed, received);
+    TEST_ASSERT_EQUAL_UINT32(COUNT, received + ring.takeDropped());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pops_in_push_order);
+    RUN_TEST(test_full_ring_counts_drops);
+    RUN_TEST(test_reserve_commit_and_peek_release);
+    RUN_TEST(test_wraps_around);
+    RUN_TEST(test_producer_and_consumer_threads);
+    return UNITY_END();
+}
@@ -0,0 +1,109 @@
+#include <unity.h>
+#include "system/TrickleTimer.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Polls every ms over [from, to); returns how often it fired, and when last
+static int run(TrickleTimer& timer, unsigned long from, unsigned long to, unsigned long* firedAt = nullptr,
+               int* suppressedCount = nullptr) {
+    int fired = 0;
+    for (unsigned long t = from; t < to; t++) {
+        bool suppressed = false;
+        if (timer.poll(t, &suppressed)) {
+            fired++;
+            if (firedAt) *firedAt = t;
+        }
+        if (suppressed && suppressedCount) (*suppressedCount)++;
+    }
+    return fired;
+}
+
+static void test_fires_once_in_the_second_half() {
+    for (uint32_t seed = 1; seed < 20; seed++) {
+        TrickleTimer timer(100, 100, 0);
+        timer.seed(seed);
+        timer.start(0);
+        unsigned long firedAt = 0;
+        TEST_ASSERT_EQUAL_INT(1, run(timer, 0, 100, &firedAt));
+        TEST_ASSERT_GREATER_OR_EQUAL(50, firedAt);
+        TEST_ASSERT_LESS_THAN(100, firedAt);
+    }
+}
+
+static void test_interval_doubles_up_to_max() {
+    TrickleTimer timer(100, 800, 0);
+    timer.start(0);
+    TEST_ASSERT_EQUAL_UINT32(100, timer.getInterval());
+    // 100 + 200 + 400 + 800 + 800: one transmission per interval
+    TEST_ASSERT_EQUAL_INT(5, run(timer, 0, 2300));
+    TEST_ASSERT_EQUAL_UINT32(800, timer.getInterval());
+}
+
+static void test_consistent_copies_suppress() {
+    TrickleTimer timer(100, 100, 2);
+    timer.start(0);
+    timer.consistent();
+    timer.consistent(); // k heard before our turn: stay quiet
+    int suppressed = 0;
+    TEST_ASSERT_EQUAL_INT(0, run(timer, 0, 100, nullptr, &suppressed));
+    TEST_ASSERT_EQUAL_INT(1, suppressed);
+
+    // The count starts over each interval
+    timer.consistent();
+    TEST_ASSERT_EQUAL_INT(1, run(timer, 100, 200));
+}
+
+static void test_k_zero_never_suppresses() {
+    TrickleTimer timer(100, 100, 0);
+    timer.start(0);
+    for (int i = 0; i < 10; i++) timer.consistent();
+    TEST_ASSERT_EQUAL_INT(1, run(timer, 0, 100));
+}
+
+static void test_inconsistent_drops_back_to_min() {
+    TrickleTimer timer(100, 1600, 0);
+    timer.start(0);
+    run(timer, 0, 1501); // 100 + 200 + 400 + 800 = 1500
+    TEST_ASSERT_EQUAL_UINT32(1600, timer.getInterval());
+
+    timer.inconsistent(2000);
+    TEST_ASSERT_EQUAL_UINT32(100, timer.getInterval());
+    unsigned long firedAt = 0;
+    TEST_ASSERT_EQUAL_INT(1, run(timer, 2000, 2100, &firedAt));
+    TEST_ASSERT_GREATER_OR_EQUAL(2050, firedAt);
+}
+
+static void test_inconsistent_at_min_keeps_the_interval() {
+    // Repeated news while already fast must not keep pushing the turn back
+    TrickleTimer timer(100, 1600, 0);
+    timer.start(0);
+    int fired = 0;
+    for (unsigned long t = 0; t < 100; t++) {
+        timer.inconsistent(t);
+        if (timer.poll(t)) fired++;
+    }
+    TEST_ASSERT_EQUAL_INT(1, fired);
+}
+
+static void test_set_max_clamps_and_applies_next_interval() {
+    TrickleTimer timer(100, 1000, 0);
+    timer.setMax(50);
+    TEST_ASSERT_EQUAL_UINT32(100, timer.getMax());
+    timer.setMax(200);
+    timer.start(0);
+    run(timer, 0, 700); // 100 + 200 + 200 + 200
+    TEST_ASSERT_EQUAL_UINT32(200, timer.getInterval());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fires_once_in_the_second_half);
+    RUN_TEST(test_interval_doubles_up_to_max);
+    RUN_TEST(test_consistent_copies_suppress);
+    RUN_TEST(test_k_zero_never_suppresses);
+    RUN_TEST(test_inconsistent_drops_back_to_min);
+    RUN_TEST(test_inconsistent_at_min_keeps_the_interval);
+    RUN_TEST(test_set_max_clamps_and_applies_next_interval);
+    return UNITY_END();
+}